@@ -127,10 +127,21 @@ EDGE_PTR TRIANGULATION::InitTwoEnclosingTriangles( NODES_CONTAINER::iterator aFi
     double dx = ( xmax - xmin ) / fac;
     double dy = ( ymax - ymin ) / fac;
 
-    NODE_PTR n1 = boost::make_shared<NODE>( xmin - dx, ymin - dy );
-    NODE_PTR n2 = boost::make_shared<NODE>( xmax + dx, ymin - dy );
-    NODE_PTR n3 = boost::make_shared<NODE>( xmax + dx, ymax + dy );
-    NODE_PTR n4 = boost::make_shared<NODE>( xmin - dx, ymax + dy );
+    return InitTwoEnclosingTriangles( xmin - dx, ymin - dy, xmax + dx, ymax + dy );
+}
+
+
+EDGE_PTR TRIANGULATION::InitTwoEnclosingTriangles( int aXmin, int aYmin, int aXmax, int aYmax )
+{
+    NODE_PTR n1 = boost::make_shared<NODE>( aXmin, aYmin );
+    NODE_PTR n2 = boost::make_shared<NODE>( aXmax, aYmin );
+    NODE_PTR n3 = boost::make_shared<NODE>( aXmax, aYmax );
+    NODE_PTR n4 = boost::make_shared<NODE>( aXmin, aYmax );
+
+    m_boundingNodes[0] = n1;
+    m_boundingNodes[1] = n2;
+    m_boundingNodes[2] = n3;
+    m_boundingNodes[3] = n4;
 
     // diagonal
     EDGE_PTR e1d = boost::make_shared<EDGE>();
@@ -218,6 +229,68 @@ void TRIANGULATION::CreateDelaunay( NODES_CONTAINER::iterator aFirst,
 
     // Assumes rectangular domain
     m_helper->RemoveRectangularBoundary<TTLtraits>( dc );
+
+    for( int i = 0; i < 4; ++i )
+        m_boundingNodes[i].reset();
+}
+
+
+void TRIANGULATION::CreateDelaunay( NODES_CONTAINER::iterator aFirst,
+                                    NODES_CONTAINER::iterator aLast,
+                                    int aXmin, int aYmin, int aXmax, int aYmax )
+{
+    cleanAll();
+
+    EDGE_PTR bedge = InitTwoEnclosingTriangles( aXmin, aYmin, aXmax, aYmax );
+    DART d_iter( bedge );
+
+    NODES_CONTAINER::iterator it;
+    for( it = aFirst; it != aLast; ++it )
+    {
+        m_helper->InsertNode<TTLtraits>( d_iter, *it );
+    }
+
+    // The rectangular boundary is kept: all the nodes are interior nodes,
+    // so they can be inserted and removed later.
+}
+
+
+bool TRIANGULATION::InsertNode( const NODE_PTR& aNode )
+{
+    if( m_leadingEdges.empty() || !m_boundingNodes[0] )
+        return false;
+
+    // The dart starts at the latest created triangle, usually close to the previous insertion
+    DART dart = CreateDart();
+    NODE_PTR node = aNode;
+
+    return m_helper->InsertNode<TTLtraits>( dart, node );
+}
+
+
+bool TRIANGULATION::RemoveNode( const NODE_PTR& aNode )
+{
+    if( m_leadingEdges.empty() || !m_boundingNodes[0] || IsBoundingNode( aNode ) )
+        return false;
+
+    DART dart = CreateDart();
+
+    if( !ttl::TRIANGULATION_HELPER::LocateTriangle<TTLtraits>( aNode, dart ) )
+        return false;
+
+    // The node is one of the corners of the located triangle
+    for( int i = 0; i < 3; ++i )
+    {
+        if( dart.GetNode() == aNode )
+        {
+            m_helper->RemoveNode<TTLtraits>( dart );
+            return true;
+        }
+
+        dart.Alpha0().Alpha1();
+    }
+
+    return false;
 }
 
 
@@ -306,31 +379,31 @@ bool TRIANGULATION::removeLeadingEdgeFromList( EDGE_PTR& aLeadingEdge )
     // Remove the edge from the list of leading edges,
     // but don't delete it.
     // Also set flag for leading edge to false.
-    // Must search from start of list. Since edges are added to the
-    // start of the list during triangulation, this operation will
-    // normally be fast (when used in the triangulation algorithm)
-    std::list<EDGE_PTR>::iterator it;
-    for( it = m_leadingEdges.begin(); it != m_leadingEdges.end(); ++it )
-    {
-        EDGE_PTR edge = *it;
+    // Leading edges know their position in the list, so there is no need to search for it
+    // (the search was slow for the edges inserted long ago, e.g. when modifying an existing
+    // triangulation)
+    if( !aLeadingEdge->IsLeadingEdge() )
+        return false;
 
-        if( edge == aLeadingEdge )
-        {
-            edge->SetAsLeadingEdge( false );
-            it = m_leadingEdges.erase( it );
+    aLeadingEdge->SetAsLeadingEdge( false );
+    m_leadingEdges.erase( aLeadingEdge->m_leadingEdgePos );
 
-            return true;
-        }
-    }
-
-    return false;
+    return true;
 }
 
 
 void TRIANGULATION::cleanAll()
 {
     BOOST_FOREACH( EDGE_PTR& edge, m_leadingEdges )
+    {
         edge->SetNextEdgeInFace( EDGE_PTR() );
+        edge->SetAsLeadingEdge( false );
+    }
+
+    m_leadingEdges.clear();
+
+    for( int i = 0; i < 4; ++i )
+        m_boundingNodes[i].reset();
 }
 
 
@@ -25,6 +25,7 @@
 
 #include <vector>
 #include <cstdio>
+#include <cmath>
 #include <geometry/shape.h>
 #include <geometry/shape_line_chain.h>
 #include <set>
@@ -191,6 +192,11 @@ void SHAPE_POLY_SET::Subtract( const SHAPE_POLY_SET& b )
     booleanOp( ctDifference, b );
 }
 
+void SHAPE_POLY_SET::Intersection( const SHAPE_POLY_SET& b )
+{
+    booleanOp( ctIntersection, b );
+}
+
 
 void SHAPE_POLY_SET::Erode ( int aFactor )
 {
@@ -213,6 +219,30 @@ void SHAPE_POLY_SET::Erode ( int aFactor )
     }
 }
 
+void SHAPE_POLY_SET::Inflate( int aFactor, int aCircleSegmentsCount )
+{
+    ClipperOffset c;
+
+    BOOST_FOREACH( Paths& p, m_polys )
+        c.AddPaths(p, jtRound, etClosedPolygon );
+
+    // Clipper approximates the arcs of radius r by chords (aCircleSegmentsCount per
+    // circle for the arc tolerance r * ( 1 - cos( pi / n ) ) ), but the last chord of a
+    // corner can span up to 1.5 steps: its distance to the arc centre is then
+    // r * cos( 1.5 * pi / n ).  Offset by aFactor / cos( 1.5 * pi / n ) so the chords are
+    // outside the exact offset (+1 for the rounding of the vertices)
+    double step  = M_PI / aCircleSegmentsCount;
+    double delta = ceil( aFactor / cos( 1.5 * step ) ) + 1;
+
+    c.ArcTolerance = delta * ( 1.0 - cos( step ) );
+
+    PolyTree solution;
+
+    c.Execute ( solution, delta );
+
+    importTree( &solution );
+}
+
 void SHAPE_POLY_SET::importTree ( ClipperLib::PolyTree* tree)
 {
     m_polys.clear();
@@ -261,6 +261,12 @@ public:
     }
 
 
+    bool HasSecondItem() const
+    {
+        return m_hasSecondItem;
+    }
+
+
     /**
      * Function ShowCoord
      * formats a coordinate or position to text.
@@ -27,8 +27,15 @@
 #define __SHAPE_INDEX_H
 
 #include <vector>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
 #include <geometry/shape.h>
-#include <geometry/rtree.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
 /**
@@ -103,6 +110,17 @@ bool queryCallback( T aShape, void* aContext )
     return true;
 }
 
+/**
+ * Class SHAPE_INDEX
+ *
+ * Spatial index of shapes (or of objects having a shape).
+ * The items are kept in a packed R-tree, built at once with the Sort-Tile-Recursive
+ * algorithm and stored in flat arrays. Items added later go to an insertion buffer
+ * which is searched linearly, and removed items are only marked as such, until the
+ * next call to Reindex() (or Optimize()) packs everything again.
+ * Bounding boxes are stored as separate coordinate arrays, so the compiler can
+ * vectorize the overlap tests.
+ */
 template <class T = SHAPE*>
 class SHAPE_INDEX
 {
@@ -110,18 +128,18 @@ class SHAPE_INDEX
         class Iterator
         {
         private:
-            typedef typename RTree<T, int, 2, float>::Iterator RTreeIterator;
-            RTreeIterator iterator;
+            SHAPE_INDEX* m_index;
+            int m_pos;
 
             /**
-             * Function Init()
+             * Function skipRemoved()
              *
-             * Setup the internal tree iterator.
-             * @param aTree pointer to a RTREE object
+             * Moves the iterator to the first item not removed from the index.
              */
-            void Init( RTree<T, int, 2, float>* aTree )
+            void skipRemoved()
             {
-                aTree->GetFirst( iterator );
+                while( IsNotNull() && m_index->isRemoved( m_pos ) )
+                    m_pos++;
             }
 
         public:
@@ -131,9 +149,11 @@ class SHAPE_INDEX
              * Creates an iterator for the index object
              * @param aIndex SHAPE_INDEX object to iterate
              */
-            Iterator( SHAPE_INDEX* aIndex )
+            Iterator( SHAPE_INDEX* aIndex ) :
+                m_index( aIndex ),
+                m_pos( 0 )
             {
-                Init( aIndex->m_tree );
+                skipRemoved();
             }
 
             /**
@@ -143,7 +163,7 @@ class SHAPE_INDEX
              */
             T operator*()
             {
-                return *iterator;
+                return m_index->m_items[m_pos];
             }
 
             /**
@@ -153,7 +173,10 @@ class SHAPE_INDEX
              */
             bool operator++()
             {
-                return ++iterator;
+                m_pos++;
+                skipRemoved();
+
+                return IsNotNull();
             }
 
             /**
@@ -163,7 +186,7 @@ class SHAPE_INDEX
              */
             bool operator++( int )
             {
-                return ++iterator;
+                return ++( *this );
             }
 
             /**
@@ -174,7 +197,7 @@ class SHAPE_INDEX
              */
             bool IsNull()
             {
-                return iterator.IsNull();
+                return m_pos >= (int) m_index->m_items.size();
             }
 
             /**
@@ -185,7 +208,7 @@ class SHAPE_INDEX
              */
             bool IsNotNull()
             {
-                return iterator.IsNotNull();
+                return !IsNull();
             }
 
             /**
@@ -197,13 +220,15 @@ class SHAPE_INDEX
              */
             T Next()
             {
-                T object = *iterator;
-                ++iterator;
+                T object = **this;
+                ++( *this );
 
                 return object;
             }
         };
 
+        friend class Iterator;
+
         SHAPE_INDEX();
 
         ~SHAPE_INDEX();
@@ -258,13 +283,24 @@ class SHAPE_INDEX
          */
         void Reindex();
 
+        /**
+         * Function Optimize()
+         *
+         * Rebuilds the index if enough items have been added or removed since the
+         * last rebuild to slow down the queries.
+         */
+        void Optimize();
+
         /**
          * Function Query()
          *
          * Runs a callback on every SHAPE object contained in the bounding box of (shape).
+         * The index is not modified, so several threads can query it at the same time.
          * @param aShape shape to search against
          * @param aMinDistance distance threshold
          * @param aVisitor object to be invoked on every object contained in the search area.
+         * Return false from the visitor to stop searching.
+         * @return number of objects found.
          */
         template <class V>
         int Query( const SHAPE *aShape, int aMinDistance, V& aVisitor, bool aExact )
@@ -272,10 +308,13 @@ class SHAPE_INDEX
             BOX2I box = aShape->BBox();
             box.Inflate( aMinDistance );
 
-            int min[2] = { box.GetX(),         box.GetY() };
-            int max[2] = { box.GetRight(),     box.GetBottom() };
+            const int query[4] = { box.GetX(), box.GetY(), box.GetRight(), box.GetBottom() };
+
+            ITEM_VISITOR<V> visitor( this, aVisitor );
+
+            searchAll( query, visitor );
 
-            return this->m_tree->Search( min, max, aVisitor );
+            return visitor.m_count;
         }
 
         /**
@@ -287,7 +326,286 @@ class SHAPE_INDEX
         Iterator Begin();
 
     private:
-        RTree<T, int, 2, float>* m_tree;
+        enum
+        {
+            ///> number of children of a node of the packed tree
+            NODE_SIZE   = 16,
+
+            ///> number of items that can always be added before the index is rebuilt
+            MIN_BUFFER  = 64
+        };
+
+        ///> Bounding boxes, stored as one array per coordinate
+        struct BOXES
+        {
+            std::vector<int> m_minX, m_minY, m_maxX, m_maxY;
+
+            int Size() const
+            {
+                return m_minX.size();
+            }
+
+            void Add( int aMinX, int aMinY, int aMaxX, int aMaxY )
+            {
+                m_minX.push_back( aMinX );
+                m_minY.push_back( aMinY );
+                m_maxX.push_back( aMaxX );
+                m_maxY.push_back( aMaxY );
+            }
+
+            void Add( const BOX2I& aBox )
+            {
+                BOX2I box = aBox;
+                box.Normalize();
+
+                Add( box.GetX(), box.GetY(), box.GetRight(), box.GetBottom() );
+            }
+
+            void Clear()
+            {
+                m_minX.clear();
+                m_minY.clear();
+                m_maxX.clear();
+                m_maxY.clear();
+            }
+
+            /**
+             * Function Test()
+             *
+             * Tests the boxes aFirst .. aFirst + aCount - 1 against the box aQuery
+             * (min x, min y, max x, max y).
+             * @param aHits receives the result of each test
+             * @return true if at least one box overlaps aQuery
+             */
+            bool Test( int aFirst, int aCount, const int aQuery[4], unsigned char* aHits ) const
+            {
+                const int* minX = &m_minX[aFirst];
+                const int* minY = &m_minY[aFirst];
+                const int* maxX = &m_maxX[aFirst];
+                const int* maxY = &m_maxY[aFirst];
+                unsigned char any = 0;
+                int i = 0;
+
+#ifdef __SSE2__
+                // 4 boxes per step. A box misses the query if one of the "greater than"
+                // tests below is true. Removed items have an empty box (min x > max x).
+                const __m128i qMinX = _mm_set1_epi32( aQuery[0] );
+                const __m128i qMinY = _mm_set1_epi32( aQuery[1] );
+                const __m128i qMaxX = _mm_set1_epi32( aQuery[2] );
+                const __m128i qMaxY = _mm_set1_epi32( aQuery[3] );
+                const __m128i one = _mm_set1_epi8( 1 );
+                int anyMask = 0;
+
+                for( ; i + 4 <= aCount; i += 4 )
+                {
+                    __m128i bMinX = _mm_loadu_si128( (const __m128i*) ( minX + i ) );
+                    __m128i bMinY = _mm_loadu_si128( (const __m128i*) ( minY + i ) );
+                    __m128i bMaxX = _mm_loadu_si128( (const __m128i*) ( maxX + i ) );
+                    __m128i bMaxY = _mm_loadu_si128( (const __m128i*) ( maxY + i ) );
+
+                    __m128i miss = _mm_or_si128(
+                            _mm_or_si128( _mm_cmpgt_epi32( bMinX, qMaxX ),
+                                          _mm_cmpgt_epi32( qMinX, bMaxX ) ),
+                            _mm_or_si128( _mm_or_si128( _mm_cmpgt_epi32( bMinY, qMaxY ),
+                                                        _mm_cmpgt_epi32( qMinY, bMaxY ) ),
+                                          _mm_cmpgt_epi32( bMinX, bMaxX ) ) );
+
+                    // 4 x 32 bits masks -> 4 x 8 bits 0 or 1 values
+                    __m128i hit = _mm_andnot_si128( miss, _mm_set1_epi32( -1 ) );
+                    hit = _mm_packs_epi32( hit, hit );
+                    hit = _mm_packs_epi16( hit, hit );
+                    anyMask |= _mm_movemask_epi8( hit );
+                    hit = _mm_and_si128( hit, one );
+
+                    int hits = _mm_cvtsi128_si32( hit );
+                    memcpy( aHits + i, &hits, 4 );
+                }
+
+                any = anyMask != 0;
+#endif /* __SSE2__ */
+
+                // Scalar version (and the last boxes with SSE2)
+                for( ; i < aCount; i++ )
+                {
+                    aHits[i] = ( minX[i] <= aQuery[2] ) & ( maxX[i] >= aQuery[0] ) &
+                               ( minY[i] <= aQuery[3] ) & ( maxY[i] >= aQuery[1] ) &
+                               ( minX[i] <= maxX[i] );
+                    any |= aHits[i];
+                }
+
+                return any;
+            }
+        };
+
+        ///> Adapts a visitor of items to a visitor of item positions
+        template <class V>
+        struct ITEM_VISITOR
+        {
+            const SHAPE_INDEX* m_index;
+            V& m_visitor;
+            int m_count;
+
+            ITEM_VISITOR( const SHAPE_INDEX* aIndex, V& aVisitor ) :
+                m_index( aIndex ), m_visitor( aVisitor ), m_count( 0 )
+            {}
+
+            bool operator()( int aPos )
+            {
+                m_count++;
+                return m_visitor( m_index->m_items[aPos] );
+            }
+        };
+
+        ///> Finds the position of an item
+        struct FIND_VISITOR
+        {
+            const SHAPE_INDEX* m_index;
+            T m_item;
+            int m_pos;
+
+            FIND_VISITOR( const SHAPE_INDEX* aIndex, T aItem ) :
+                m_index( aIndex ), m_item( aItem ), m_pos( -1 )
+            {}
+
+            bool operator()( int aPos )
+            {
+                if( m_index->m_items[aPos] != m_item )
+                    return true;
+
+                m_pos = aPos;
+                return false;
+            }
+        };
+
+        ///> An item with its bounding box, used to sort the items when packing the tree
+        struct PACK_ENTRY
+        {
+            T m_item;
+            BOX2I m_box;
+            VECTOR2I m_centre;
+        };
+
+        static bool lessX( const PACK_ENTRY& aA, const PACK_ENTRY& aB )
+        {
+            return aA.m_centre.x < aB.m_centre.x;
+        }
+
+        static bool lessY( const PACK_ENTRY& aA, const PACK_ENTRY& aB )
+        {
+            return aA.m_centre.y < aB.m_centre.y;
+        }
+
+        bool isRemoved( int aPos ) const
+        {
+            return m_boxes.m_minX[aPos] > m_boxes.m_maxX[aPos];
+        }
+
+        /**
+         * Function searchItems()
+         *
+         * Calls aVisitor for the position of each of the items aFirst .. aFirst + aCount - 1
+         * overlapping aQuery.
+         * @return false if the visitor stopped the search.
+         */
+        template <class V>
+        bool searchItems( int aFirst, int aCount, const int aQuery[4], V& aVisitor ) const
+        {
+            unsigned char hits[NODE_SIZE];
+
+            if( !m_boxes.Test( aFirst, aCount, aQuery, hits ) )
+                return true;
+
+            for( int i = 0; i < aCount; i++ )
+            {
+                if( hits[i] && !aVisitor( aFirst + i ) )
+                    return false;
+            }
+
+            return true;
+        }
+
+        /**
+         * Function searchNodes()
+         *
+         * Searches the subtrees of the nodes aFirst .. aLast - 1 of the level aLevel
+         * of the packed tree.
+         * @return false if the visitor stopped the search.
+         */
+        template <class V>
+        bool searchNodes( int aLevel, int aFirst, int aLast, const int aQuery[4], V& aVisitor ) const
+        {
+            unsigned char hits[NODE_SIZE];
+
+            if( !m_levels[aLevel].Test( aFirst, aLast - aFirst, aQuery, hits ) )
+                return true;
+
+            int childCount = aLevel ? m_levels[aLevel - 1].Size() : m_packedCount;
+
+            for( int i = 0; i < aLast - aFirst; i++ )
+            {
+                if( !hits[i] )
+                    continue;
+
+                int first = ( aFirst + i ) * NODE_SIZE;
+                int last = std::min( first + (int) NODE_SIZE, childCount );
+
+                if( aLevel )
+                {
+                    if( !searchNodes( aLevel - 1, first, last, aQuery, aVisitor ) )
+                        return false;
+                }
+                else if( !searchItems( first, last - first, aQuery, aVisitor ) )
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /**
+         * Function searchAll()
+         *
+         * Calls aVisitor for the position of each item overlapping aQuery: the
+         * packed items first, then the insertion buffer.
+         */
+        template <class V>
+        void searchAll( const int aQuery[4], V& aVisitor ) const
+        {
+            if( !m_levels.empty() )
+            {
+                int top = m_levels.size() - 1;
+
+                if( !searchNodes( top, 0, m_levels[top].Size(), aQuery, aVisitor ) )
+                    return;
+            }
+
+            int count = m_items.size();
+
+            for( int first = m_packedCount; first < count; first += NODE_SIZE )
+            {
+                if( !searchItems( first, std::min( (int) NODE_SIZE, count - first ),
+                                  aQuery, aVisitor ) )
+                    return;
+            }
+        }
+
+        ///> bounding boxes of the items
+        BOXES m_boxes;
+
+        ///> the items: the ones of the packed tree in the tree order, then the insertion buffer
+        std::vector<T> m_items;
+
+        ///> number of items in the packed tree (including the removed ones)
+        int m_packedCount;
+
+        ///> number of items removed from the packed tree
+        int m_removedCount;
+
+        ///> bounding boxes of the nodes of the packed tree. The nodes of the level 0
+        ///> contain NODE_SIZE items each, the nodes of the next levels NODE_SIZE nodes
+        ///> of the previous level. The last level is the root, it has at most NODE_SIZE nodes.
+        std::vector<BOXES> m_levels;
 };
 
 /*
@@ -295,63 +613,177 @@ class SHAPE_INDEX
  */
 
 template <class T>
-SHAPE_INDEX<T>::SHAPE_INDEX()
+SHAPE_INDEX<T>::SHAPE_INDEX() :
+    m_packedCount( 0 ),
+    m_removedCount( 0 )
 {
-    this->m_tree = new RTree<T, int, 2, float>();
 }
 
 template <class T>
 SHAPE_INDEX<T>::~SHAPE_INDEX()
 {
-    delete this->m_tree;
 }
 
 template <class T>
 void SHAPE_INDEX<T>::Add( T aShape )
 {
-    BOX2I box = boundingBox( aShape );
-    int min[2] = { box.GetX(), box.GetY() };
-    int max[2] = { box.GetRight(), box.GetBottom() };
-
-    this->m_tree->Insert( min, max, aShape );
+    m_boxes.Add( boundingBox( aShape ) );
+    m_items.push_back( aShape );
 }
 
 template <class T>
 void SHAPE_INDEX<T>::Remove( T aShape )
 {
+    int count = m_items.size();
+
+    // items of the insertion buffer are simply erased
+    for( int i = m_packedCount; i < count; i++ )
+    {
+        if( m_items[i] != aShape )
+            continue;
+
+        m_items[i] = m_items[count - 1];
+        m_boxes.m_minX[i] = m_boxes.m_minX[count - 1];
+        m_boxes.m_minY[i] = m_boxes.m_minY[count - 1];
+        m_boxes.m_maxX[i] = m_boxes.m_maxX[count - 1];
+        m_boxes.m_maxY[i] = m_boxes.m_maxY[count - 1];
+
+        m_items.pop_back();
+        m_boxes.m_minX.pop_back();
+        m_boxes.m_minY.pop_back();
+        m_boxes.m_maxX.pop_back();
+        m_boxes.m_maxY.pop_back();
+        return;
+    }
+
+    // items of the packed tree are found by their bounding box, and marked as removed
     BOX2I box = boundingBox( aShape );
-    int min[2] = { box.GetX(), box.GetY() };
-    int max[2] = { box.GetRight(), box.GetBottom() };
+    box.Normalize();
+
+    const int query[4] = { box.GetX(), box.GetY(), box.GetRight(), box.GetBottom() };
+
+    FIND_VISITOR visitor( this, aShape );
 
-    this->m_tree->Remove( min, max, aShape );
+    searchAll( query, visitor );
+
+    if( visitor.m_pos < 0 )
+    {
+        // the geometry of the item changed since it was added
+        for( int i = 0; i < m_packedCount && visitor.m_pos < 0; i++ )
+        {
+            if( m_items[i] == aShape && !isRemoved( i ) )
+                visitor.m_pos = i;
+        }
+
+        if( visitor.m_pos < 0 )
+            return;
+    }
+
+    m_boxes.m_minX[visitor.m_pos] = INT_MAX;
+    m_boxes.m_minY[visitor.m_pos] = INT_MAX;
+    m_boxes.m_maxX[visitor.m_pos] = INT_MIN;
+    m_boxes.m_maxY[visitor.m_pos] = INT_MIN;
+    m_removedCount++;
 }
 
 template <class T>
 void SHAPE_INDEX<T>::RemoveAll()
 {
-    this->m_tree->RemoveAll();
+    m_boxes.Clear();
+    m_items.clear();
+    m_levels.clear();
+    m_packedCount = 0;
+    m_removedCount = 0;
 }
 
 template <class T>
 void SHAPE_INDEX<T>::Reindex()
 {
-    RTree<T, int, 2, float>* newTree;
-    newTree = new RTree<T, int, 2, float>();
+    std::vector<PACK_ENTRY> entries;
+
+    entries.reserve( m_items.size() - m_removedCount );
+
+    for( int i = 0; i < (int) m_items.size(); i++ )
+    {
+        if( isRemoved( i ) )
+            continue;
 
-    Iterator iter = this->Begin();
+        PACK_ENTRY entry;
 
-    while( !iter.IsNull() )
+        entry.m_item = m_items[i];
+        entry.m_box = boundingBox( m_items[i] );
+        entry.m_box.Normalize();
+        entry.m_centre = entry.m_box.Centre();
+        entries.push_back( entry );
+    }
+
+    // Sort-Tile-Recursive: sort the items by x, cut them in vertical slices of
+    // sqrt( leaf count ) leaves, and sort each slice by y.
+    int count = entries.size();
+    int leafCount = ( count + NODE_SIZE - 1 ) / NODE_SIZE;
+    int sliceSize = (int) ceil( sqrt( (double) leafCount ) ) * NODE_SIZE;
+
+    std::sort( entries.begin(), entries.end(), lessX );
+
+    for( int first = 0; first < count; first += sliceSize )
+    {
+        int last = std::min( first + sliceSize, count );
+        std::sort( entries.begin() + first, entries.begin() + last, lessY );
+    }
+
+    RemoveAll();
+
+    m_items.reserve( count );
+
+    for( int i = 0; i < count; i++ )
     {
-        T shape = *iter;
-        BOX2I box = boundingBox( shape );
-        int min[2] = { box.GetX(), box.GetY() };
-        int max[2] = { box.GetRight(), box.GetBottom() };
-        newTree->Insert( min, max, shape );
-        iter++;
+        m_items.push_back( entries[i].m_item );
+        m_boxes.Add( entries[i].m_box );
     }
 
-    delete this->m_tree;
-    this->m_tree = newTree;
+    m_packedCount = count;
+
+    // build the levels of nodes, up to a root level of at most NODE_SIZE nodes
+    const BOXES* children = &m_boxes;
+
+    while( children->Size() > 0 )
+    {
+        BOXES level;
+
+        for( int first = 0; first < children->Size(); first += NODE_SIZE )
+        {
+            int last = std::min( first + (int) NODE_SIZE, children->Size() );
+
+            int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+
+            for( int i = first; i < last; i++ )
+            {
+                minX = std::min( minX, children->m_minX[i] );
+                minY = std::min( minY, children->m_minY[i] );
+                maxX = std::max( maxX, children->m_maxX[i] );
+                maxY = std::max( maxY, children->m_maxY[i] );
+            }
+
+            level.Add( minX, minY, maxX, maxY );
+        }
+
+        m_levels.push_back( level );
+
+        if( level.Size() <= NODE_SIZE )
+            break;
+
+        children = &m_levels.back();
+    }
+}
+
+template <class T>
+void SHAPE_INDEX<T>::Optimize()
+{
+    int buffered = m_items.size() - m_packedCount;
+    int maxBuffered = std::max( (int) MIN_BUFFER, m_packedCount / 64 );
+
+    if( buffered > maxBuffered || m_removedCount > m_packedCount / 4 )
+        Reindex();
 }
 
 template <class T>
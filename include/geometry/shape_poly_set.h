@@ -85,12 +85,22 @@ class SHAPE_POLY_SET : public SHAPE
         ///> Performs boolean polyset union
         void Add( const SHAPE_POLY_SET& b );
 
+        ///> Performs boolean polyset intersection
+        void Intersection( const SHAPE_POLY_SET& b );
+
         ///> Performs smooth outline inflation (Minkowski sum of the outline and a circle of a given radius)
         void SmoothInflate ( int aFactor );
 
         ///> Performs outline erosion/shrinking
         void Erode ( int aFactor );
 
+        ///> Performs outline inflation with rounded corners, holes included. Arcs are
+        ///> approximated by chords (aCircleSegmentsCount per circle) outside the exact arcs,
+        ///> i.e. the result contains the exact Minkowski sum of the outline and a circle of
+        ///> radius aFactor, and is at most aFactor * ( 1 / cos( 1.5 * pi / aCircleSegmentsCount ) - 1 )
+        ///> (plus rounding) bigger
+        void Inflate( int aFactor, int aCircleSegmentsCount );
+
         ///> Converts a set of polygons with holes to a singe outline with 'slits'/'fractures' connecting the outer ring
         ///> to the inner holes
         void Fracture ();
@@ -322,6 +322,11 @@ protected:
     EDGE_PTR        m_nextEdgeInFace;
     unsigned int    m_weight;
     bool            m_isLeadingEdge;
+
+    /// Position in the list of leading edges of the triangulation (valid for leading edges only)
+    std::list<EDGE_PTR>::iterator m_leadingEdgePos;
+
+    friend class TRIANGULATION;
 };
 
 
@@ -367,12 +372,16 @@ protected:
     /// One half-edge for each arc
     std::list<EDGE_PTR> m_leadingEdges;
 
+    /// Nodes at the corners of the enclosing rectangle, when they are kept (see CreateDelaunay())
+    NODE_PTR m_boundingNodes[4];
+
     ttl::TRIANGULATION_HELPER* m_helper;
 
     void addLeadingEdge( EDGE_PTR& aEdge )
     {
         aEdge->SetAsLeadingEdge();
         m_leadingEdges.push_front( aEdge );
+        aEdge->m_leadingEdgePos = m_leadingEdges.begin();
     }
 
     bool removeLeadingEdgeFromList( EDGE_PTR& aLeadingEdge );
@@ -442,12 +451,36 @@ public:
     /// Creates a Delaunay triangulation from a set of points
     void CreateDelaunay( NODES_CONTAINER::iterator aFirst, NODES_CONTAINER::iterator aLast );
 
+    /// Creates a Delaunay triangulation from a set of points lying strictly inside a rectangle.
+    /// The nodes at the rectangle corners are kept (see IsBoundingNode()), so nodes can be
+    /// inserted and removed later with InsertNode() and RemoveNode().
+    void CreateDelaunay( NODES_CONTAINER::iterator aFirst, NODES_CONTAINER::iterator aLast,
+                         int aXmin, int aYmin, int aXmax, int aYmax );
+
     /// Creates an initial Delaunay triangulation from two enclosing triangles
     //  When using rectangular boundary - loop through all points and expand.
     //  (Called from createDelaunay(...) when starting)
     EDGE_PTR InitTwoEnclosingTriangles( NODES_CONTAINER::iterator aFirst,
                                         NODES_CONTAINER::iterator aLast );
 
+    /// Creates an initial Delaunay triangulation from two triangles making a given rectangle
+    EDGE_PTR InitTwoEnclosingTriangles( int aXmin, int aYmin, int aXmax, int aYmax );
+
+    /// Inserts a node in a triangulation created with an enclosing rectangle, keeping it Delaunay.
+    /// Returns false if the node could not be located in the triangulation.
+    bool InsertNode( const NODE_PTR& aNode );
+
+    /// Removes a node from a triangulation created with an enclosing rectangle, keeping it
+    /// Delaunay. Returns false if the node could not be found in the triangulation.
+    bool RemoveNode( const NODE_PTR& aNode );
+
+    /// Checks if a node is one of the corners of the enclosing rectangle
+    bool IsBoundingNode( const NODE_PTR& aNode ) const
+    {
+        return aNode == m_boundingNodes[0] || aNode == m_boundingNodes[1] ||
+               aNode == m_boundingNodes[2] || aNode == m_boundingNodes[3];
+    }
+
     // These two functions are required by TTL for Delaunay triangulation
 
     /// Swaps the edge associated with diagonal
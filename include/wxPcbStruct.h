@@ -52,6 +52,7 @@ class DIMENSION;
 class EDGE_MODULE;
 class DRC;
 class ZONE_CONTAINER;
+class ZONE_FILL_INDEX;
 class DRAWSEGMENT;
 class GENERAL_COLLECTOR;
 class GENERAL_COLLECTORS_GUIDE;
@@ -1391,9 +1392,10 @@ public:
      *  The filling starts from starting points like pads, tracks.
      * If exists the old filling is removed
      * @param aZone = zone to fill
+     * @param aIndex = the index of the board items when several zones are filled, or NULL
      * @return error level (0 = no error)
      */
-    int Fill_Zone( ZONE_CONTAINER* aZone );
+    int Fill_Zone( ZONE_CONTAINER* aZone, ZONE_FILL_INDEX* aIndex = NULL );
 
     /**
      * Function Fill_All_Zones
@@ -0,0 +1,156 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file board_rtree.h
+ * @brief R-trees used to find board items close to a given area.
+ */
+
+#ifndef __BOARD_RTREE_H
+#define __BOARD_RTREE_H
+
+#include <climits>
+
+#include <class_eda_rect.h>
+#include <layers_id_colors_and_visibility.h>
+
+#include <geometry/rtree.h>
+
+
+/**
+ * Class BOARD_RTREE
+ * is a non-owning R-tree of items (usually BOARD_ITEM* or an integer index into
+ * a list of items) keyed by an EDA_RECT.
+ * The bounding box of an item is given by the caller, because most users need
+ * a box inflated by a clearance value, not the item's own GetBoundingBox().
+ */
+template <class T>
+class BOARD_RTREE : public RTree<T, int, 2, float>
+{
+    typedef RTree<T, int, 2, float> BASE;
+
+public:
+
+    /**
+     * Function Insert
+     * adds aItem to the tree.
+     * @param aItem is the item to add.
+     * @param aBBox is the area covered by the item.
+     */
+    void Insert( const T& aItem, const EDA_RECT& aBBox )
+    {
+        EDA_RECT    bbox = aBBox;
+        bbox.Normalize();
+
+        const int   mmin[2] = { bbox.GetX(), bbox.GetY() };
+        const int   mmax[2] = { bbox.GetRight(), bbox.GetBottom() };
+
+        BASE::Insert( mmin, mmax, aItem );
+    }
+
+    /**
+     * Function Remove
+     * removes aItem from the tree. Removal is done by comparing values, so
+     * the bounding box used to insert the item is not needed.
+     */
+    void Remove( const T& aItem )
+    {
+        const int   mmin[2] = { INT_MIN, INT_MIN };
+        const int   mmax[2] = { INT_MAX, INT_MAX };
+
+        BASE::Remove( mmin, mmax, aItem );
+    }
+
+    /**
+     * Function Query
+     * executes a function object aVisitor for each item whose bounding box
+     * intersects aBounds. aVisitor must return false to stop the search.
+     */
+    template <class VISITOR>
+    void Query( const EDA_RECT& aBounds, VISITOR& aVisitor )
+    {
+        EDA_RECT    bbox = aBounds;
+        bbox.Normalize();
+
+        const int   mmin[2] = { bbox.GetX(), bbox.GetY() };
+        const int   mmax[2] = { bbox.GetRight(), bbox.GetBottom() };
+
+        BASE::Search( mmin, mmax, aVisitor );
+    }
+};
+
+
+/**
+ * Class LAYERED_BOARD_RTREE
+ * holds one BOARD_RTREE per copper layer.  An item living on several copper
+ * layers (a via, a through hole pad) is inserted in each of them, therefore
+ * a query on several layers can visit the same item more than once.
+ */
+template <class T>
+class LAYERED_BOARD_RTREE
+{
+public:
+
+    /**
+     * Function Insert
+     * adds aItem to the trees of every copper layer of aLayers.
+     */
+    void Insert( const T& aItem, const EDA_RECT& aBBox, LSET aLayers )
+    {
+        for( LSEQ cu_stack = aLayers.CuStack();  cu_stack;  ++cu_stack )
+            m_tree[*cu_stack].Insert( aItem, aBBox );
+    }
+
+    /**
+     * Function Remove
+     * removes aItem from the trees of every copper layer of aLayers.
+     */
+    void Remove( const T& aItem, LSET aLayers )
+    {
+        for( LSEQ cu_stack = aLayers.CuStack();  cu_stack;  ++cu_stack )
+            m_tree[*cu_stack].Remove( aItem );
+    }
+
+    /**
+     * Function Query
+     * executes aVisitor for each item found on the copper layers of aLayers
+     * whose bounding box intersects aBounds.
+     */
+    template <class VISITOR>
+    void Query( const EDA_RECT& aBounds, LSET aLayers, VISITOR& aVisitor )
+    {
+        for( LSEQ cu_stack = aLayers.CuStack();  cu_stack;  ++cu_stack )
+            m_tree[*cu_stack].Query( aBounds, aVisitor );
+    }
+
+    void RemoveAll()
+    {
+        for( int layer = 0; layer < MAX_CU_LAYERS; ++layer )
+            m_tree[layer].RemoveAll();
+    }
+
+private:
+    BOARD_RTREE<T>  m_tree[MAX_CU_LAYERS];
+};
+
+#endif  // __BOARD_RTREE_H
@@ -43,6 +43,7 @@
 #include <class_edge_mod.h>
 
 #include <ratsnest_data.h>
+#include <drc_stuff.h>
 
 #include <tools/selection_tool.h>
 #include <tool/tool_manager.h>
@@ -358,6 +359,9 @@ void PCB_EDIT_FRAME::SaveCopyInUndoList( BOARD_ITEM*    aItem,
 
     if( commandToUndo->GetCount() )
     {
+        // Remember the changed items for the next incremental DRC
+        m_drc->MarkItemsDirty( *commandToUndo );
+
         /* Save the copy in undo list */
         GetScreen()->PushCommandToUndoList( commandToUndo );
 
@@ -444,6 +448,9 @@ void PCB_EDIT_FRAME::SaveCopyInUndoList( const PICKED_ITEMS_LIST& aItemsList,
 
     if( commandToUndo->GetCount() )
     {
+        // Remember the changed items for the next incremental DRC
+        m_drc->MarkItemsDirty( *commandToUndo );
+
         /* Save the copy in undo list */
         GetScreen()->PushCommandToUndoList( commandToUndo );
 
@@ -506,6 +513,9 @@ void PCB_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool aRed
 
         item->ClearFlags();
 
+        // Remember the item area before it is restored, for the next incremental DRC
+        m_drc->MarkItemDirty( item );
+
         // see if we must rebuild ratsnets and pointers lists
         switch( item->Type() )
         {
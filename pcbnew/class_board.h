@@ -1196,6 +1196,9 @@ public:
      * tests area outlines for DRC:
      *      Tests areas inside other areas.
      *      Tests areas too close.
+     * Areas are compared with polygon booleans (intersection of the outlines, and of an
+     * outline inflated by the clearance with the other one); one error is found for each
+     * polygon of the intersection.
      *
      * @param aArea_To_Examine: area to compare with other areas, or if NULL then
      *          all areas are compared to all others.
@@ -47,7 +47,6 @@
 #include <pcbnew.h>
 #include <zones.h>
 #include <math_for_graphics.h>
-#include <polygon_test_point_inside.h>
 
 
 ZONE_CONTAINER::ZONE_CONTAINER( BOARD* aBoard ) :
@@ -55,6 +54,7 @@ ZONE_CONTAINER::ZONE_CONTAINER( BOARD* aBoard ) :
 {
     m_CornerSelection = -1;
     m_IsFilled = false;                         // fill status : true when the zone is filled
+    m_fillHash = 0;
     m_FillMode = 0;                             // How to fill areas: 0 = use filled polygons, != 0 fill with segments
     m_priority = 0;
     m_smoothedPoly = NULL;
@@ -82,6 +82,7 @@ ZONE_CONTAINER::ZONE_CONTAINER( const ZONE_CONTAINER& aZone ) :
     // For corner moving, corner index to drag, or -1 if no selection
     m_CornerSelection = -1;
     m_IsFilled = aZone.m_IsFilled;
+    m_fillHash = aZone.m_fillHash;
     m_ZoneClearance = aZone.m_ZoneClearance;     // clearance value
     m_ZoneMinThickness = aZone.m_ZoneMinThickness;
     m_FillMode = aZone.m_FillMode;               // Filling mode (segments/polygons)
@@ -91,6 +92,7 @@ ZONE_CONTAINER::ZONE_CONTAINER( const ZONE_CONTAINER& aZone ) :
     m_ThermalReliefGap = aZone.m_ThermalReliefGap;
     m_ThermalReliefCopperBridge = aZone.m_ThermalReliefCopperBridge;
     m_FilledPolysList.Append( aZone.m_FilledPolysList );
+    m_filledPolysIndex = aZone.m_filledPolysIndex;
     m_FillSegmList = aZone.m_FillSegmList;      // vector <> copy
 
     m_isKeepout = aZone.m_isKeepout;
@@ -124,8 +126,10 @@ bool ZONE_CONTAINER::UnFill()
                   ( m_FillSegmList.size() > 0 );
 
     m_FilledPolysList.RemoveAllContours();
+    buildFilledPolysIndex();
     m_FillSegmList.clear();
     m_IsFilled = false;
+    m_fillHash = 0;
 
     return change;
 }
@@ -576,26 +580,7 @@ int ZONE_CONTAINER::GetClearance( BOARD_CONNECTED_ITEM* aItem ) const
 
 bool ZONE_CONTAINER::HitTestFilledArea( const wxPoint& aRefPos ) const
 {
-    unsigned indexstart = 0, indexend;
-    bool     inside     = false;
-
-    for( indexend = 0; indexend < m_FilledPolysList.GetCornersCount(); indexend++ )
-    {
-        if( m_FilledPolysList.IsEndContour( indexend ) )       // end of a filled sub-area found
-        {
-            if( TestPointInsidePolygon( m_FilledPolysList, indexstart, indexend,
-                                        aRefPos.x, aRefPos.y ) )
-            {
-                inside = true;
-                break;
-            }
-
-            // Prepare test of next area which starts after the current index end (if exists)
-            indexstart = indexend + 1;
-        }
-    }
-
-    return inside;
+    return GetFilledPolysIndex().Contains( aRefPos.x, aRefPos.y );
 }
 
 
@@ -701,6 +686,8 @@ void ZONE_CONTAINER::Move( const wxPoint& offset )
         m_FilledPolysList.SetY( ic, m_FilledPolysList.GetY( ic ) + offset.y );
     }
 
+    buildFilledPolysIndex();
+
     for( unsigned ic = 0; ic < m_FillSegmList.size(); ic++ )
     {
         m_FillSegmList[ic].m_Start += offset;
@@ -754,6 +741,8 @@ void ZONE_CONTAINER::Rotate( const wxPoint& centre, double angle )
         m_FilledPolysList.SetY( ic, pos.y );
     }
 
+    buildFilledPolysIndex();
+
     for( unsigned ic = 0; ic < m_FillSegmList.size(); ic++ )
     {
         RotatePoint( &m_FillSegmList[ic].m_Start, centre, angle );
@@ -786,6 +775,8 @@ void ZONE_CONTAINER::Mirror( const wxPoint& mirror_ref )
         m_FilledPolysList.SetY( ic, py + mirror_ref.y );
     }
 
+    buildFilledPolysIndex();
+
     for( unsigned ic = 0; ic < m_FillSegmList.size(); ic++ )
     {
         MIRROR( m_FillSegmList[ic].m_Start.y, mirror_ref.y );
@@ -816,8 +807,10 @@ void ZONE_CONTAINER::Copy( ZONE_CONTAINER* src )
     m_Poly->m_HatchLines = src->m_Poly->m_HatchLines;   // Copy vector <CSegment>
     m_FilledPolysList.RemoveAllContours();
     m_FilledPolysList.Append( src->m_FilledPolysList );
+    buildFilledPolysIndex();
     m_FillSegmList.clear();
     m_FillSegmList = src->m_FillSegmList;
+    m_fillHash = src->m_fillHash;
 }
 
 
@@ -907,4 +900,5 @@ void ZONE_CONTAINER::CopyPolygonsFromClipperPathsToFilledPolysList(
 {
     m_FilledPolysList.RemoveAllContours();
     m_FilledPolysList.ImportFrom( aClipperPolyList );
+    buildFilledPolysIndex();
 }
@@ -38,6 +38,7 @@
 #include <class_board_connected_item.h>
 #include <layers_id_colors_and_visibility.h>
 #include <PolyLine.h>
+#include <poly_edge_grid.h>
 #include <class_zone_settings.h>
 
 
@@ -47,6 +48,7 @@ class EDA_DRAW_PANEL;
 class PCB_EDIT_FRAME;
 class BOARD;
 class ZONE_CONTAINER;
+class ZONE_FILL_INDEX;
 class MSG_PANEL_ITEM;
 
 
@@ -205,6 +207,24 @@ public:
     bool IsFilled() const { return m_IsFilled; }
     void SetIsFilled( bool isFilled ) { m_IsFilled = isFilled; }
 
+    /**
+     * Function CalculateFillHash
+     * computes a hash of all the data the filled areas are built from: the zone
+     * outline and settings, and the items of the board near the zone (pads, tracks,
+     * graphic items and other zones which can create holes or thermal reliefs).
+     * When it is equal to the hash stored by the last fill, the filled areas are
+     * up to date and the zone does not need to be refilled.
+     * @param aPcb = the board of the zone
+     * @param aIndex = the index of the board items, to hash only the items near the
+     * zone without walking the whole board, or NULL
+     * @return the hash (never 0, which means "unknown"), the same with or without aIndex
+     */
+    uint64_t CalculateFillHash( BOARD* aPcb, ZONE_FILL_INDEX* aIndex = NULL ) const;
+
+    /// Hash of the fill inputs stored when the zone was filled, 0 if unknown.
+    uint64_t GetFillHash() const { return m_fillHash; }
+    void SetFillHash( uint64_t aHash ) { m_fillHash = aHash; }
+
     int GetZoneClearance() const { return m_ZoneClearance; }
     void SetZoneClearance( int aZoneClearance ) { m_ZoneClearance = aZoneClearance; }
 
@@ -260,6 +280,19 @@ public:
      */
     bool HitTestFilledArea( const wxPoint& aRefPos ) const;
 
+    /**
+     * Function GetFilledPolysIndex
+     * returns the point location structure of the filled areas.  It is rebuilt
+     * by each change of m_FilledPolysList, so reading it does not modify the zone
+     * and can be done from any thread filling or testing other zones.
+     * The sub-area indexes it returns follow the order of the filled areas in
+     * m_FilledPolysList.
+     */
+    const POLY_EDGE_GRID& GetFilledPolysIndex() const
+    {
+        return m_filledPolysIndex;
+    }
+
      /**
      * Function TransformSolidAreasShapesToPolygonSet
      * Convert solid areas full shapes to polygon set
@@ -294,8 +327,11 @@ public:
      * When aOutlineBuffer is not null, his function calls
      * AddClearanceAreasPolygonsToPolysList() to add holes for pads and tracks
      * and other items not in net.
+     * @param aIndex: an index of the items of aPcb, used to find the items near the
+     * zone when filling several zones, or NULL to walk the whole board
      */
-    bool BuildFilledSolidAreasPolygons( BOARD* aPcb, CPOLYGONS_LIST* aOutlineBuffer = NULL );
+    bool BuildFilledSolidAreasPolygons( BOARD* aPcb, CPOLYGONS_LIST* aOutlineBuffer = NULL,
+                                        ZONE_FILL_INDEX* aIndex = NULL );
 
     /**
      * Function CopyPolygonsFromKiPolygonListToFilledPolysList
@@ -332,10 +368,11 @@ public:
      * BuildFilledSolidAreasPolygons() call this function just after creating the
      *  filled copper area polygon (without clearance areas
      * @param aPcb: the current board
+     * @param aIndex: the index of the items of aPcb, or NULL
      * _NG version uses SHAPE_POLY_SET instead of Boost.Polygon
      */
-    void AddClearanceAreasPolygonsToPolysList( BOARD* aPcb );
-    void AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb );
+    void AddClearanceAreasPolygonsToPolysList( BOARD* aPcb, ZONE_FILL_INDEX* aIndex = NULL );
+    void AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb, ZONE_FILL_INDEX* aIndex = NULL );
 
 
      /**
@@ -503,6 +540,7 @@ public:
     void ClearFilledPolysList()
     {
         m_FilledPolysList.RemoveAllContours();
+        buildFilledPolysIndex();
     }
 
    /**
@@ -522,6 +560,7 @@ public:
     void AddFilledPolysList( CPOLYGONS_LIST& aPolysList )
     {
         m_FilledPolysList = aPolysList;
+        buildFilledPolysIndex();
     }
 
     /**
@@ -551,6 +590,7 @@ public:
     void AddFilledPolygon( CPOLYGONS_LIST& aPolygon )
     {
         m_FilledPolysList.Append( aPolygon );
+        buildFilledPolysIndex();
     }
 
     void AddFillSegments( std::vector< SEGMENT >& aSegments )
@@ -584,7 +624,17 @@ public:
 
 
 private:
-    void buildFeatureHoleList( BOARD* aPcb, CPOLYGONS_LIST& aFeatures );
+    /**
+     * Function buildFilledPolysIndex
+     * must be called after each change of m_FilledPolysList.
+     */
+    void buildFilledPolysIndex()
+    {
+        m_filledPolysIndex.Build( m_FilledPolysList.GetList() );
+    }
+
+    void buildFeatureHoleList( BOARD* aPcb, CPOLYGONS_LIST& aFeatures,
+                               ZONE_FILL_INDEX* aIndex );
 
     CPolyLine*            m_Poly;                ///< Outline of the zone.
     CPolyLine*            m_smoothedPoly;        // Corner-smoothed version of m_Poly
@@ -620,6 +670,9 @@ private:
     /** True when a zone was filled, false after deleting the filled areas. */
     bool                  m_IsFilled;
 
+    /// Hash of the fill inputs when the zone was filled (see CalculateFillHash()).
+    uint64_t              m_fillHash;
+
     ///< Width of the gap in thermal reliefs.
     int                   m_ThermalReliefGap;
 
@@ -653,6 +706,9 @@ private:
      * described by m_Poly can have many filled areas
      */
     CPOLYGONS_LIST m_FilledPolysList;
+
+    /// Point location in m_FilledPolysList, see GetFilledPolysIndex()
+    POLY_EDGE_GRID m_filledPolysIndex;
 };
 
 
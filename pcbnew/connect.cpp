@@ -489,80 +489,19 @@ void CONNECTIONS::Build_CurrNet_SubNets_Connections( TRACK* aFirstTrack, TRACK*
 }
 
 
-/**
- * Change a subnet value to a new value, in m_sortedPads pad list
- * After that, 2 cluster (or subnets) are merged into only one.
- * Note: the resulting subnet value is the smallest between aOldSubNet et aNewSubNet
+/* While subnets are built, the subnet value of each track and pad of the net is
+ * its index in the item list (tracks first, then pads).
+ * Returns the index of aItem, or -1 if aItem is not an item of the list
  */
-int CONNECTIONS::Merge_PadsSubNets( int aOldSubNet, int aNewSubNet )
+static int getItemIndex( const BOARD_CONNECTED_ITEM* aItem,
+                         const std::vector<BOARD_CONNECTED_ITEM*>& aItems )
 {
-    int    change_count = 0;
-
-    if( aOldSubNet == aNewSubNet )
-        return 0;
-
-    if( (aOldSubNet > 0) && (aOldSubNet < aNewSubNet) )
-        std::swap( aOldSubNet, aNewSubNet );
-
-    // Examine connections between intersecting pads
-    for( unsigned ii = 0; ii < m_sortedPads.size(); ii++ )
-    {
-        D_PAD * curr_pad = m_sortedPads[ii];
-        if( curr_pad->GetSubNet() != aOldSubNet )
-            continue;
+    int index = aItem->GetSubNet();
 
-        change_count++;
-        curr_pad->SetSubNet( aNewSubNet );
-    }
+    if( index < 0 || index >= (int) aItems.size() || aItems[index] != aItem )
+        return -1;
 
-    return change_count;
-}
-
-/*
- * Change a subnet value to a new value, for tracks and pads which are connected to.
- * The result is merging 2 clusters (or subnets) into only one cluster.
- * Note: the resulting sub net value is the smallest between aOldSubNet et aNewSubNet
- */
-int CONNECTIONS::Merge_SubNets( int aOldSubNet, int aNewSubNet )
-{
-    TRACK* curr_track;
-    int    change_count = 0;
-
-    if( aOldSubNet == aNewSubNet )
-        return 0;
-
-    if( (aOldSubNet > 0) && (aOldSubNet < aNewSubNet) )
-        std::swap( aOldSubNet, aNewSubNet );
-
-    curr_track = (TRACK*)m_firstTrack;
-
-    for( ; curr_track != NULL; curr_track = curr_track->Next() )
-    {
-        if( curr_track->GetSubNet() != aOldSubNet )
-        {
-            if( curr_track == m_lastTrack )
-                break;
-
-            continue;
-        }
-
-        change_count++;
-        curr_track->SetSubNet( aNewSubNet );
-
-        for( unsigned ii = 0; ii < curr_track->m_PadsConnected.size(); ii++ )
-        {
-            D_PAD * pad = curr_track->m_PadsConnected[ii];
-            if( pad->GetSubNet() == aOldSubNet )
-            {
-                pad->SetSubNet( curr_track->GetSubNet() );
-            }
-        }
-
-        if( curr_track == m_lastTrack )
-            break;
-    }
-
-    return change_count;
+    return index;
 }
 
 
@@ -577,150 +516,92 @@ int CONNECTIONS::Merge_SubNets( int aOldSubNet, int aNewSubNet )
  * but if not all tracks are created, there are more than one cluster,
  * and some ratsnests will be left active.
  * A ratsnest is active when it "connect" 2 items having different subnet id
+ *
+ * Clusters are built in a disjoint-set structure (m_subnets), and the subnet ids
+ * are written to tracks and pads only once, at the end, so the calculation time
+ * grows linearly with the item count.
  */
 void CONNECTIONS::Propagate_SubNets()
 {
-    int sub_netcode = 1;
+    // List of items of the net: tracks, then pads
+    std::vector<BOARD_CONNECTED_ITEM*> items;
+
+    for( TRACK* track = (TRACK*) m_firstTrack; track != NULL; track = track->Next() )
+    {
+        items.push_back( track );
+
+        if( track == m_lastTrack )
+            break;
+    }
 
-    TRACK* curr_track = (TRACK*)m_firstTrack;
-    if( curr_track )
-        curr_track->SetSubNet( sub_netcode );
+    unsigned trackCount = items.size();
 
-    // Examine connections between tracks and pads
-    for( ; curr_track != NULL; curr_track = curr_track->Next() )
+    items.insert( items.end(), m_sortedPads.begin(), m_sortedPads.end() );
+
+    // Until the subnets are known, the subnet of an item is its index
+    for( unsigned ii = 0; ii < items.size(); ii++ )
+        items[ii]->SetSubNet( ii );
+
+    m_subnets.Reset( items.size() );
+
+    // Examine connections between tracks and pads, and between segments
+    for( unsigned ii = 0; ii < trackCount; ii++ )
     {
-        // First: handling connections to pads
-        for( unsigned ii = 0; ii < curr_track->m_PadsConnected.size(); ii++ )
+        TRACK* curr_track = (TRACK*) items[ii];
+
+        for( unsigned jj = 0; jj < curr_track->m_PadsConnected.size(); jj++ )
         {
-            D_PAD * pad = curr_track->m_PadsConnected[ii];
+            int index = getItemIndex( curr_track->m_PadsConnected[jj], items );
 
-            if( curr_track->GetSubNet() )        // the track segment is already a cluster member
-            {
-                if( pad->GetSubNet() > 0 )
-                {
-                    // The pad is already a cluster member, so we can merge the 2 clusters
-                    Merge_SubNets( pad->GetSubNet(), curr_track->GetSubNet() );
-                }
-                else
-                {
-                    /* The pad is not yet attached to a cluster , so we can add this pad to
-                     * the cluster */
-                    pad->SetSubNet( curr_track->GetSubNet() );
-                }
-            }
-            else                              // the track segment is not attached to a cluster
-            {
-                if( pad->GetSubNet() > 0 )
-                {
-                    // it is connected to a pad in a cluster, merge this track
-                    curr_track->SetSubNet( pad->GetSubNet() );
-                }
-                else
-                {
-                    /* it is connected to a pad not in a cluster, so we must create a new
-                     * cluster (only with the 2 items: the track and the pad) */
-                    sub_netcode++;
-                    curr_track->SetSubNet( sub_netcode );
-                    pad->SetSubNet( curr_track->GetSubNet() );
-                }
-            }
+            if( index >= 0 )
+                m_subnets.Merge( ii, index );
         }
 
-        // Test connections between segments
-        for( unsigned ii = 0; ii < curr_track->m_TracksConnected.size(); ii++ )
+        for( unsigned jj = 0; jj < curr_track->m_TracksConnected.size(); jj++ )
         {
-            BOARD_CONNECTED_ITEM* track = curr_track->m_TracksConnected[ii];
+            int index = getItemIndex( curr_track->m_TracksConnected[jj], items );
 
-            if( curr_track->GetSubNet() )   // The current track is already a cluster member
-            {
-                // The other track is already a cluster member, so we can merge the 2 clusters
-                if( track->GetSubNet() )
-                {
-                    Merge_SubNets( track->GetSubNet(), curr_track->GetSubNet() );
-                }
-                else
-                {
-                    // The other track is not yet attached to a cluster , so we can add this
-                    // other track to the cluster
-                    track->SetSubNet( curr_track->GetSubNet() );
-                }
-            }
-            else        // the current track segment is not yet attached to a cluster
-            {
-                if( track->GetSubNet() )
-                {
-                    // The other track is already a cluster member, so we can add
-                    // the current segment to the cluster
-                    curr_track->SetSubNet( track->GetSubNet() );
-                }
-                else
-                {
-                    // it is connected to an other segment not in a cluster, so we must
-                    // create a new cluster (only with the 2 track segments)
-                    sub_netcode++;
-                    curr_track->SetSubNet( sub_netcode );
-                    track->SetSubNet( curr_track->GetSubNet() );
-                }
-            }
+            if( index >= 0 )
+                m_subnets.Merge( ii, index );
         }
-
-        if( curr_track == m_lastTrack )
-            break;
     }
 
-    // Examine connections between intersecting pads, and propagate
-    // sub_netcodes to intersecting pads
+    // Examine connections between intersecting pads
     for( unsigned ii = 0; ii < m_sortedPads.size(); ii++ )
     {
         D_PAD* curr_pad = m_sortedPads[ii];
 
         for( unsigned jj = 0; jj < curr_pad->m_PadsConnected.size(); jj++ )
         {
-            D_PAD* pad = curr_pad->m_PadsConnected[jj];
+            int index = getItemIndex( curr_pad->m_PadsConnected[jj], items );
 
-            if( curr_pad->GetSubNet() )   // the current pad is already attached to a cluster
-            {
-                if( pad->GetSubNet() > 0 )
-                {
-                    // The pad is already a cluster member, so we can merge the 2 clusters
-                    // Store the initial subnets, which will be modified by Merge_PadsSubNets
-                    int subnet1 = pad->GetSubNet();
-                    int subnet2 = curr_pad->GetSubNet();
+            if( index >= 0 )
+                m_subnets.Merge( trackCount + ii, index );
+        }
+    }
 
-                    // merge subnets of pads only, even those not connected by tracks
-                    Merge_PadsSubNets( subnet1, subnet2 );
+    // Now give a sub netcode to each cluster, starting from 1.
+    // Items connected to nothing are not in a cluster (sub netcode = 0),
+    // except the first track, which always starts the cluster 1
+    std::vector<int> clusterCodes( items.size(), 0 );
+    int sub_netcode = 0;
 
-                    // merge subnets of tracks (and pads, which are already merged)
-                    Merge_SubNets( subnet1, subnet2 );
-                }
-                else
-                {
-                    // The pad is not yet attached to a cluster,
-                    // so we can add this pad to the cluster
-                    pad->SetSubNet( curr_pad->GetSubNet() );
-                }
-            }
-            else   // the current pad is not attached to a cluster
-            {
-                if( pad->GetSubNet() > 0 )
-                {
-                    // the connected pad is in a cluster,
-                    // so we can add the current pad to the cluster
-                    curr_pad->SetSubNet( pad->GetSubNet() );
-                }
-                else
-                {
-                    // the connected pad is not in a cluster,
-                    // so we must create a new cluster, with the 2 pads.
-                    sub_netcode++;
-                    curr_pad->SetSubNet( sub_netcode );
-                    pad->SetSubNet( curr_pad->GetSubNet() );
-                }
-            }
+    for( unsigned ii = 0; ii < items.size(); ii++ )
+    {
+        int root = m_subnets.Find( ii );
+
+        if( clusterCodes[root] == 0 && ( ( ii == 0 && trackCount > 0 )
+                                         || m_subnets.GetSize( root ) > 1 ) )
+        {
+            clusterCodes[root] = ++sub_netcode;
         }
     }
+
+    for( unsigned ii = 0; ii < items.size(); ii++ )
+        items[ii]->SetSubNet( clusterCodes[m_subnets.Find( ii )] );
 }
 
+
 /*
  * Test all connections of the board,
  * and update subnet variable of pads and tracks
@@ -87,6 +87,83 @@ public:
     const wxPoint & GetPoint() const { return m_point; }
 };
 
+/* class SUBNET_SETS is a disjoint-set (union-find) structure used to build the
+ * subnets (clusters of connected items) of a net.
+ * Items are identified by an index. Merging 2 subnets is a (nearly) constant time
+ * operation, instead of a scan of all items of the net to change their subnet value.
+ */
+class SUBNET_SETS
+{
+private:
+    std::vector<int> m_parent;      // parent of each item, an item is its own parent if it is a root
+    std::vector<int> m_size;        // item count of the subnet, for roots only
+
+public:
+    /**
+     * Function Reset
+     * initializes the structure with aCount items, each one in its own subnet
+     */
+    void Reset( int aCount )
+    {
+        m_parent.resize( aCount );
+        m_size.assign( aCount, 1 );
+
+        for( int ii = 0; ii < aCount; ii++ )
+            m_parent[ii] = ii;
+    }
+
+    /**
+     * Function Find
+     * @return the root item of the subnet containing aItem
+     */
+    int Find( int aItem )
+    {
+        int root = aItem;
+
+        while( m_parent[root] != root )
+            root = m_parent[root];
+
+        // Path compression
+        while( m_parent[aItem] != root )
+        {
+            int next = m_parent[aItem];
+            m_parent[aItem] = root;
+            aItem = next;
+        }
+
+        return root;
+    }
+
+    /**
+     * Function Merge
+     * merges the subnets containing aItem1 and aItem2 into only one
+     */
+    void Merge( int aItem1, int aItem2 )
+    {
+        int root1 = Find( aItem1 );
+        int root2 = Find( aItem2 );
+
+        if( root1 == root2 )
+            return;
+
+        // The smallest subnet is attached to the biggest one
+        if( m_size[root1] < m_size[root2] )
+            std::swap( root1, root2 );
+
+        m_parent[root2] = root1;
+        m_size[root1] += m_size[root2];
+    }
+
+    /**
+     * Function GetSize
+     * @return the item count of the subnet containing aItem
+     */
+    int GetSize( int aItem )
+    {
+        return m_size[Find( aItem )];
+    }
+};
+
 // A helper class to handle connections calculations:
 class CONNECTIONS
 {
@@ -99,6 +176,7 @@ private:
     const TRACK * m_firstTrack;                 // The first track used to build m_Candidates
     const TRACK * m_lastTrack;                  // The last track used to build m_Candidates
     std::vector<D_PAD*> m_sortedPads;           // list of sorted pads by X (then Y) coordinate
+    SUBNET_SETS m_subnets;                      // subnets of the current net, while they are built
 
 public:
     CONNECTIONS( BOARD * aBrd );
@@ -234,30 +312,6 @@ private:
      * @return the index of item found or -1 if no candidate
      */
     int searchEntryPointInCandidatesList( const wxPoint & aPoint);
-
-    /**
-     * Function Merge_SubNets
-     * Change a subnet old value to a new value, for tracks and pads which are connected to
-     * tracks from m_firstTrack to m_lastTrack and their connected pads.
-     * and modify the subnet parameter (change the old value to the new value).
-     * After that, 2 cluster (or subnets) are merged into only one.
-     * Note: the resulting sub net value is the smallest between aOldSubNet and aNewSubNet
-     * @return modification count
-     * @param aOldSubNet = subnet value to modify
-     * @param aNewSubNet = new subnet value for each item which have old_val as subnet value
-     */
-    int Merge_SubNets( int aOldSubNet, int aNewSubNet );
-
-    /**
-     * Function Merge_PadsSubNets
-     * Change a subnet value to a new value, in m_sortedPads pad list
-     * After that, 2 cluster (or subnets) are merged into only one.
-     * Note: the resulting subnet value is the smallest between aOldSubNet et aNewSubNet
-     * @return modification count
-     * @param aOldSubNet = subnet value to modify
-     * @param aNewSubNet = new subnet value for each item which have old_val as subnet value
-     */
-    int Merge_PadsSubNets( int aOldSubNet, int aNewSubNet );
 };
 
 #endif      //  ifndef CONNECT_H
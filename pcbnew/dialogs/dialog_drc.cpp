@@ -99,9 +99,19 @@ void DIALOG_DRC_CONTROL::InitValues()
 */
 void DIALOG_DRC_CONTROL::SetDrcParmeters( )
 {
-     m_BrdSettings.m_TrackMinWidth = ValueFromTextCtrl( *m_SetTrackMinWidthCtrl );
-     m_BrdSettings.m_ViasMinSize = ValueFromTextCtrl( *m_SetViaMinSizeCtrl );
-     m_BrdSettings.m_MicroViasMinSize = ValueFromTextCtrl( *m_SetMicroViakMinSizeCtrl );
+     int trackMinWidth    = ValueFromTextCtrl( *m_SetTrackMinWidthCtrl );
+     int viasMinSize      = ValueFromTextCtrl( *m_SetViaMinSizeCtrl );
+     int microViasMinSize = ValueFromTextCtrl( *m_SetMicroViakMinSizeCtrl );
+
+     // New limits can change the result of tests of any item
+     if( trackMinWidth != m_BrdSettings.m_TrackMinWidth
+         || viasMinSize != m_BrdSettings.m_ViasMinSize
+         || microViasMinSize != m_BrdSettings.m_MicroViasMinSize )
+         m_tester->SetFullDrcNeeded();
+
+     m_BrdSettings.m_TrackMinWidth = trackMinWidth;
+     m_BrdSettings.m_ViasMinSize = viasMinSize;
+     m_BrdSettings.m_MicroViasMinSize = microViasMinSize;
 
      m_Parent->GetBoard()->SetDesignSettings( m_BrdSettings );
 }
@@ -136,7 +146,20 @@ void DIALOG_DRC_CONTROL::OnStartdrcClick( wxCommandEvent& event )
                            true,        // DRC test for keepout areas enabled
                            reportName, m_CreateRptCtrl->IsChecked() );
 
-    DelDRCMarkers();
+    // When only some items were changed since the last run, keep the markers
+    // of the other items and test only the changed ones
+    bool incremental = m_tester->CanRunIncrementalTests();
+
+    if( incremental )
+    {
+        m_Parent->SetCurItem( NULL );       // clear curr item, because it could be a DRC marker
+        m_UnconnectedListBox->DeleteAllItems();
+        m_DeleteCurrentMarkerButton->Enable( false );
+    }
+    else
+    {
+        DelDRCMarkers();
+    }
 
     wxBeginBusyCursor();
 
@@ -144,7 +167,11 @@ void DIALOG_DRC_CONTROL::OnStartdrcClick( wxCommandEvent& event )
     m_Messages->Clear();
     wxSafeYield();                          // Allows time slice to refresh the m_Messages window
     m_tester->m_pcb->m_Status_Pcb = 0;      // Force full connectivity and ratsnest recalculations
-    m_tester->RunTests(m_Messages);
+
+    if( incremental )
+        m_tester->RunIncrementalTests( m_Messages );
+    else
+        m_tester->RunTests( m_Messages );
 
 #if wxCHECK_VERSION( 2, 8, 0 )
     m_Notebook->ChangeSelection( 0 );       // display the 1at tab "...Markers ..."
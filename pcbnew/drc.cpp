@@ -39,9 +39,15 @@
 #include <class_pad.h>
 #include <class_zone.h>
 #include <class_pcb_text.h>
+#include <class_marker_pcb.h>
+#include <class_undoredo_container.h>
 #include <class_draw_panel_gal.h>
 #include <view/view.h>
 #include <geometry/seg.h>
+#include <board_rtree.h>
+#include <zone_fill_index.h>
+#include <ratsnest_data.h>
+#include <profile.h>
 
 #include <pcbnew.h>
 #include <drc_stuff.h>
@@ -50,6 +56,88 @@
 #include <wx/progdlg.h>
 
 
+/* Returns the area where a pad can create a DRC error with a track:
+ * the pad shape (centered on ShapePos()) and its hole (centered on GetPosition()),
+ * inflated by the pad clearance.
+ * The track bounding box already contains the track clearance, so a track
+ * outside this area cannot be too close to the pad or to its hole.
+ */
+static EDA_RECT padClearanceBBox( D_PAD* aPad )
+{
+    EDA_RECT bbox( aPad->ShapePos(), wxSize( 0, 0 ) );
+    bbox.Inflate( aPad->GetBoundingRadius() + aPad->GetClearance() + 1 );
+
+    int drill = std::max( aPad->GetDrillSize().x, aPad->GetDrillSize().y );
+
+    if( drill )
+    {
+        EDA_RECT hole( aPad->GetPosition(), wxSize( 0, 0 ) );
+        hole.Inflate( drill / 2 + 1 );
+        bbox.Merge( hole );
+    }
+
+    return bbox;
+}
+
+
+/* Returns the area where an item can create a DRC error with the items tested
+ * by the pad, track and text tests. It is used to find the items to retest
+ * in an incremental DRC.
+ */
+static EDA_RECT itemDrcArea( BOARD_ITEM* aItem )
+{
+    switch( aItem->Type() )
+    {
+    case PCB_PAD_T:
+        return padClearanceBBox( static_cast<D_PAD*>( aItem ) );
+
+    case PCB_MODULE_T:
+    {
+        MODULE*  module = static_cast<MODULE*>( aItem );
+        EDA_RECT area = module->GetBoundingBox();
+
+        for( D_PAD* pad = module->Pads(); pad; pad = pad->Next() )
+            area.Merge( padClearanceBBox( pad ) );
+
+        return area;
+    }
+
+    case PCB_TEXT_T:
+    {
+        TEXTE_PCB* text = static_cast<TEXTE_PCB*>( aItem );
+        EDA_RECT   area = text->GetBoundingBox();
+        area.Inflate( text->GetThickness() );
+
+        return area;
+    }
+
+    default:
+        // tracks and vias bounding boxes already include their clearance
+        return aItem->GetBoundingBox();
+    }
+}
+
+
+/**
+ * Class DRC_AREA_FINDER
+ * is the visitor used to know if a BOARD_RTREE query finds at least one item.
+ */
+struct DRC_AREA_FINDER
+{
+    bool m_found;
+
+    DRC_AREA_FINDER() :
+        m_found( false )
+    {}
+
+    bool operator()( int aIndex )
+    {
+        m_found = true;
+        return false;   // stop the search
+    }
+};
+
+
 void DRC::ShowDialog()
 {
     if( !m_ui )
@@ -97,6 +185,22 @@ DRC::DRC( PCB_EDIT_FRAME* aPcbWindow )
 {
     m_mainWindow = aPcbWindow;
     m_pcb = aPcbWindow->GetBoard();
+
+    init();
+}
+
+
+DRC::DRC( BOARD* aPcb )
+{
+    m_mainWindow = NULL;
+    m_pcb = aPcb;
+
+    init();
+}
+
+
+void DRC::init()
+{
     m_ui  = 0;
 
     // establish initial values for everything:
@@ -116,10 +220,56 @@ DRC::DRC( PCB_EDIT_FRAME* aPcbWindow )
     m_segmAngle  = 0;
     m_segmLength = 0;
 
+    m_useClearanceKernels = true;
+
     m_xcliplo = 0;
     m_ycliplo = 0;
     m_xcliphi = 0;
     m_ycliphi = 0;
+
+    m_fullDrcNeeded = true;
+    m_lastTestedPcb = NULL;
+    m_areasToTest   = NULL;
+    m_padPolygons   = NULL;
+}
+
+
+DRC::DRC( const DRC& aDrc )
+{
+    m_mainWindow = aDrc.m_mainWindow;
+    m_pcb = aDrc.m_pcb;
+    m_ui  = 0;      // only the master DRC object drives the dialog
+
+    m_doPad2PadTest     = aDrc.m_doPad2PadTest;
+    m_doUnconnectedTest = aDrc.m_doUnconnectedTest;
+    m_doZonesTest       = aDrc.m_doZonesTest;
+    m_doKeepoutTest     = aDrc.m_doKeepoutTest;
+    m_abortDRC          = false;
+    m_drcInProgress     = aDrc.m_drcInProgress;
+
+    m_doCreateRptFile   = false;
+
+    // m_unconnected is left empty: it is owned by the master DRC object
+
+    m_currentMarker = NULL;
+
+    m_segmAngle  = 0;
+    m_segmLength = 0;
+
+    m_useClearanceKernels = aDrc.m_useClearanceKernels;
+
+    m_xcliplo = 0;
+    m_ycliplo = 0;
+    m_xcliphi = 0;
+    m_ycliphi = 0;
+
+    // a worker does not run tests by itself, so has no incremental data
+    m_fullDrcNeeded = true;
+    m_lastTestedPcb = NULL;
+    m_areasToTest   = NULL;
+
+    // the pad polygons are built by the master DRC object, and only read by workers
+    m_padPolygons   = aDrc.m_padPolygons;
 }
 
 
@@ -172,8 +322,239 @@ int DRC::Drc( ZONE_CONTAINER* aArea, int aCornerIndex )
 
 void DRC::RunTests( wxTextCtrl* aMessages )
 {
+    // All the items are tested: forget the markers of the previous run
+    m_markerOwners.clear();
+    m_areasToTest = NULL;
+
+    if( runTests( aMessages ) )
+        clearIncrementalData();
+    else
+        m_fullDrcNeeded = true;
+}
+
+
+bool DRC::CanRunIncrementalTests()
+{
+    BOARD* board = m_mainWindow ? m_mainWindow->GetBoard() : m_pcb;
+
+    return !m_fullDrcNeeded && m_lastTestedPcb == board;
+}
+
+
+void DRC::RunIncrementalTests( wxTextCtrl* aMessages )
+{
+    updatePointers();
+
+    if( !CanRunIncrementalTests() )
+    {
+        m_pcb->DeleteMARKERs();
+        RunTests( aMessages );
+        return;
+    }
+
+    // Areas where the results of the last run can have changed: the areas of the
+    // changed items before their change, and their current areas.
+    std::vector<EDA_RECT> areas = m_dirtyAreas;
+
+    for( TRACK* track = m_pcb->m_Track; track; track = track->Next() )
+    {
+        if( m_dirtyItems.count( track ) )
+            areas.push_back( itemDrcArea( track ) );
+    }
+
+    for( MODULE* module = m_pcb->m_Modules; module; module = module->Next() )
+    {
+        if( m_dirtyItems.count( module ) )
+            areas.push_back( itemDrcArea( module ) );
+    }
+
+    for( BOARD_ITEM* item = m_pcb->m_Drawings; item; item = item->Next() )
+    {
+        if( m_dirtyItems.count( item ) )
+            areas.push_back( itemDrcArea( item ) );
+    }
+
+    BOARD_RTREE<int> areasToTest;
+
+    for( unsigned ii = 0; ii < areas.size(); ++ii )
+        areasToTest.Insert( ii, areas[ii] );
+
+    m_areasToTest = &areasToTest;
+
+    // The items which can own a marker, with their area.
+    // Changed or deleted items must not be dereferenced, so only items found
+    // on the board are used.
+    std::map<BOARD_ITEM*, EDA_RECT> owners;
+
+    for( TRACK* track = m_pcb->m_Track; track; track = track->Next() )
+        owners[track] = itemDrcArea( track );
+
+    for( unsigned ii = 0; ii < m_pcb->GetPadCount(); ++ii )
+        owners[m_pcb->GetPad( ii )] = itemDrcArea( m_pcb->GetPad( ii ) );
+
+    for( BOARD_ITEM* item = m_pcb->m_Drawings; item; item = item->Next() )
+    {
+        if( item->Type() == PCB_TEXT_T )
+            owners[item] = itemDrcArea( item );
+    }
+
+    // Keep the markers of the items which are not retested. Markers deleted
+    // by the user since the last run are no more in the board marker list.
+    std::set<MARKER_PCB*> boardMarkers;
+
+    for( int ii = 0; ii < m_pcb->GetMARKERCount(); ++ii )
+        boardMarkers.insert( m_pcb->GetMARKER( ii ) );
+
+    std::multimap<BOARD_ITEM*, MARKER_PCB*> keptOwners;
+    std::set<MARKER_PCB*>                   keptMarkers;
+    std::multimap<BOARD_ITEM*, MARKER_PCB*>::iterator it;
+
+    for( it = m_markerOwners.begin(); it != m_markerOwners.end(); ++it )
+    {
+        std::map<BOARD_ITEM*, EDA_RECT>::iterator owner = owners.find( it->first );
+
+        if( owner == owners.end() || !boardMarkers.count( it->second ) )
+            continue;
+
+        if( isAreaToTest( owner->second ) )
+            continue;
+
+        keptOwners.insert( *it );
+        keptMarkers.insert( it->second );
+    }
+
+    m_markerOwners.swap( keptOwners );
+
+    // All the other markers are created again by the tests
+    for( int ii = m_pcb->GetMARKERCount() - 1; ii >= 0; --ii )
+    {
+        MARKER_PCB* marker = m_pcb->GetMARKER( ii );
+
+        if( !keptMarkers.count( marker ) )
+            removeMarkerFromPcb( marker );
+    }
+
+    for( unsigned ii = 0; ii < m_unconnected.size(); ++ii )
+        delete m_unconnected[ii];
+
+    m_unconnected.clear();
+
+    bool success = runTests( aMessages );
+
+    m_areasToTest = NULL;
+
+    if( success )
+        clearIncrementalData();
+    else
+        m_fullDrcNeeded = true;
+}
+
+
+void DRC::MarkItemsDirty( const PICKED_ITEMS_LIST& aList )
+{
+    for( unsigned ii = 0; ii < aList.GetCount(); ++ii )
+    {
+        BOARD_ITEM* item = (BOARD_ITEM*) aList.GetPickedItem( ii );
+
+        if( !item )
+            continue;
+
+        MarkItemDirty( item );
+
+        // Moves and rotations can be recorded after the change: also mark the
+        // area the item had before the transform.
+        EDA_RECT area = itemDrcArea( item );
+
+        switch( aList.GetPickedItemStatus( ii ) )
+        {
+        case UR_MOVED:
+            area.Move( -aList.m_TransformPoint );
+            m_dirtyAreas.push_back( area );
+            break;
+
+        case UR_ROTATED:
+        case UR_ROTATED_CLOCKWISE:
+        case UR_FLIPPED:
+        case UR_MIRRORED_X:
+        case UR_MIRRORED_Y:
+        {
+            // The area covered by any rotation of the item around the transform point
+            const wxPoint& centre = aList.m_TransformPoint;
+            double radius = 0;
+
+            radius = std::max( radius, GetLineLength( centre, area.GetOrigin() ) );
+            radius = std::max( radius, GetLineLength( centre, area.GetEnd() ) );
+            radius = std::max( radius, GetLineLength( centre,
+                                        wxPoint( area.GetX(), area.GetBottom() ) ) );
+            radius = std::max( radius, GetLineLength( centre,
+                                        wxPoint( area.GetRight(), area.GetY() ) ) );
+
+            EDA_RECT rotated( centre, wxSize( 0, 0 ) );
+            rotated.Inflate( KiROUND( radius ) + 1 );
+            m_dirtyAreas.push_back( rotated );
+        }
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+
+void DRC::MarkItemDirty( BOARD_ITEM* aItem )
+{
+    switch( aItem->Type() )
+    {
+    case PCB_MARKER_T:
+        return;
+
+    case PCB_PAD_T:
+    case PCB_MODULE_TEXT_T:
+    case PCB_MODULE_EDGE_T:
+        // footprint items are tested with their footprint
+        if( aItem->GetParent() )
+            aItem = (BOARD_ITEM*) aItem->GetParent();
+        break;
+
+    default:
+        break;
+    }
+
+    m_dirtyItems.insert( aItem );
+    m_dirtyAreas.push_back( itemDrcArea( aItem ) );
+}
+
+
+void DRC::clearIncrementalData()
+{
+    m_dirtyItems.clear();
+    m_dirtyAreas.clear();
+    m_fullDrcNeeded = false;
+    m_lastTestedPcb = m_pcb;
+}
+
+
+bool DRC::isAreaToTest( const EDA_RECT& aArea )
+{
+    if( !m_areasToTest )
+        return true;
+
+    DRC_AREA_FINDER finder;
+    m_areasToTest->Query( aArea, finder );
+
+    return finder.m_found;
+}
+
+
+bool DRC::runTests( wxTextCtrl* aMessages )
+{
+    prof_counter phase;
+
+    m_phaseTimes.clear();
+
     // Ensure ratsnest is up to date:
-    if( (m_pcb->m_Status_Pcb & LISTE_RATSNEST_ITEM_OK) == 0 )
+    if( (m_pcb->m_Status_Pcb & LISTE_RATSNEST_ITEM_OK) == 0 && m_mainWindow )
     {
         if( aMessages )
         {
@@ -181,12 +562,20 @@ void DRC::RunTests( wxTextCtrl* aMessages )
             wxSafeYield();
         }
 
+        prof_start( &phase );
         m_mainWindow->Compile_Ratsnest( NULL, true );
+        prof_end( &phase );
+        addPhaseTime( wxT( "ratsnest" ), phase );
     }
 
     // someone should have cleared the two lists before calling this.
 
-    if( !testNetClasses() )
+    prof_start( &phase );
+    bool netclassesOk = testNetClasses();
+    prof_end( &phase );
+    addPhaseTime( wxT( "netclasses" ), phase );
+
+    if( !netclassesOk )
     {
         // testing the netclasses is a special case because if the netclasses
         // do not pass the BOARD_DESIGN_SETTINGS checks, then every member of a net
@@ -198,7 +587,7 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         // update the m_ui listboxes
         updatePointers();
 
-        return;
+        return false;
     }
 
     // test pad to pad clearances, nothing to do with tracks, vias or zones.
@@ -210,7 +599,10 @@ void DRC::RunTests( wxTextCtrl* aMessages )
             wxSafeYield();
         }
 
+        prof_start( &phase );
         testPad2Pad();
+        prof_end( &phase );
+        addPhaseTime( wxT( "pad_clearances" ), phase );
     }
 
     // test track and via clearances to other tracks, pads, and vias
@@ -220,7 +612,10 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         wxSafeYield();
     }
 
+    prof_start( &phase );
     testTracks( true );
+    prof_end( &phase );
+    addPhaseTime( wxT( "track_clearances" ), phase );
 
     // Before testing segments and unconnected, refill all zones:
     // this is a good caution, because filled areas can be outdated.
@@ -230,8 +625,16 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         wxSafeYield();
     }
 
-    m_mainWindow->Fill_All_Zones( aMessages ? aMessages->GetParent() : m_mainWindow,
-                                  false );
+    prof_start( &phase );
+
+    if( m_mainWindow )
+        m_mainWindow->Fill_All_Zones( aMessages ? aMessages->GetParent() : m_mainWindow,
+                                      false );
+    else
+        fillAllZones();
+
+    prof_end( &phase );
+    addPhaseTime( wxT( "zone_fill" ), phase );
 
     // test zone clearances to other zones
     if( aMessages )
@@ -240,7 +643,10 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         wxSafeYield();
     }
 
+    prof_start( &phase );
     testZones();
+    prof_end( &phase );
+    addPhaseTime( wxT( "zones" ), phase );
 
     // find and gather unconnected pads.
     if( m_doUnconnectedTest )
@@ -251,7 +657,10 @@ void DRC::RunTests( wxTextCtrl* aMessages )
             aMessages->Refresh();
         }
 
+        prof_start( &phase );
         testUnconnected();
+        prof_end( &phase );
+        addPhaseTime( wxT( "unconnected" ), phase );
     }
 
     // find and gather vias, tracks, pads inside keepout areas.
@@ -263,7 +672,10 @@ void DRC::RunTests( wxTextCtrl* aMessages )
             aMessages->Refresh();
         }
 
+        prof_start( &phase );
         testKeepoutAreas();
+        prof_end( &phase );
+        addPhaseTime( wxT( "keepout_areas" ), phase );
     }
 
     // find and gather vias, tracks, pads inside text boxes.
@@ -273,7 +685,10 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         wxSafeYield();
     }
 
+    prof_start( &phase );
     testTexts();
+    prof_end( &phase );
+    addPhaseTime( wxT( "texts" ), phase );
 
     // update the m_ui listboxes
     updatePointers();
@@ -284,6 +699,51 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         // to unnecessarily scroll.
         aMessages->AppendText( _( "Finished" ) );
     }
+
+    return true;
+}
+
+
+void DRC::addPhaseTime( const wxString& aName, const prof_counter& aCounter )
+{
+    DRC_PHASE_TIME phaseTime;
+
+    phaseTime.m_Name  = aName;
+    phaseTime.m_Usecs = aCounter.usecs();
+
+    m_phaseTimes.push_back( phaseTime );
+}
+
+
+void DRC::fillAllZones()
+{
+    // Same as PCB_EDIT_FRAME::Fill_All_Zones(), without the UI
+
+    // Remove segment zones
+    m_pcb->m_Zone.DeleteAll();
+
+    ZONE_FILL_INDEX fillIndex( m_pcb );
+
+    for( int ii = 0; ii < m_pcb->GetAreaCount(); ii++ )
+    {
+        ZONE_CONTAINER* zone = m_pcb->GetArea( ii );
+
+        // Zones not changed since their last fill are skipped (see Fill_Zone())
+        uint64_t fillHash = zone->CalculateFillHash( m_pcb, &fillIndex );
+
+        if( !zone->GetIsKeepout() && zone->IsFilled() && zone->GetFillHash() == fillHash )
+            continue;
+
+        zone->ClearFilledPolysList();
+        zone->UnFill();
+
+        // Cannot fill keepout zones:
+        if( zone->GetIsKeepout() )
+            continue;
+
+        zone->BuildFilledSolidAreasPolygons( m_pcb, NULL, &fillIndex );
+        zone->SetFillHash( fillHash );
+    }
 }
 
 
@@ -299,7 +759,9 @@ void DRC::ListUnconnectedPads()
 void DRC::updatePointers()
 {
     // update my pointers, m_mainWindow is the only unchangeable one
-    m_pcb = m_mainWindow->GetBoard();
+    // (without a main window, m_pcb is given by the constructor and never changes)
+    if( m_mainWindow )
+        m_pcb = m_mainWindow->GetBoard();
 
     if( m_ui )  // Use diag list boxes only in DRC dialog
     {
@@ -309,6 +771,29 @@ void DRC::updatePointers()
 }
 
 
+void DRC::addMarkerToPcb( MARKER_PCB* aMarker )
+{
+    m_pcb->Add( aMarker );
+
+    if( m_mainWindow )
+        m_mainWindow->GetGalCanvas()->GetView()->Add( aMarker );
+}
+
+
+void DRC::addMarkerToPcb( MARKER_PCB* aMarker, BOARD_ITEM* aOwner )
+{
+    addMarkerToPcb( aMarker );
+    m_markerOwners.insert( std::make_pair( aOwner, aMarker ) );
+}
+
+
+void DRC::removeMarkerFromPcb( MARKER_PCB* aMarker )
+{
+    // The view item is removed from the view by its destructor
+    m_pcb->Delete( aMarker );
+}
+
+
 bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
 {
     bool ret = true;
@@ -327,8 +812,7 @@ bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
                     );
 
         m_currentMarker = fillMarker( DRCE_NETCLASS_CLEARANCE, msg, m_currentMarker );
-        m_pcb->Add( m_currentMarker );
-        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+        addMarkerToPcb( m_currentMarker );
         m_currentMarker = 0;
         ret = false;
     }
@@ -343,8 +827,7 @@ bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
                     );
 
         m_currentMarker = fillMarker( DRCE_NETCLASS_TRACKWIDTH, msg, m_currentMarker );
-        m_pcb->Add( m_currentMarker );
-        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+        addMarkerToPcb( m_currentMarker );
         m_currentMarker = 0;
         ret = false;
     }
@@ -358,8 +841,7 @@ bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
                     );
 
         m_currentMarker = fillMarker( DRCE_NETCLASS_VIASIZE, msg, m_currentMarker );
-        m_pcb->Add( m_currentMarker );
-        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+        addMarkerToPcb( m_currentMarker );
         m_currentMarker = 0;
         ret = false;
     }
@@ -373,8 +855,7 @@ bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
                     );
 
         m_currentMarker = fillMarker( DRCE_NETCLASS_VIADRILLSIZE, msg, m_currentMarker );
-        m_pcb->Add( m_currentMarker );
-        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+        addMarkerToPcb( m_currentMarker );
         m_currentMarker = 0;
         ret = false;
     }
@@ -388,8 +869,7 @@ bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
                     );
 
         m_currentMarker = fillMarker( DRCE_NETCLASS_uVIASIZE, msg, m_currentMarker );
-        m_pcb->Add( m_currentMarker );
-        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+        addMarkerToPcb( m_currentMarker );
         m_currentMarker = 0;
         ret = false;
     }
@@ -403,8 +883,7 @@ bool DRC::doNetClass( NETCLASSPTR nc, wxString& msg )
                     );
 
         m_currentMarker = fillMarker( DRCE_NETCLASS_uVIADRILLSIZE, msg, m_currentMarker );
-        m_pcb->Add( m_currentMarker );
-        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+        addMarkerToPcb( m_currentMarker );
         m_currentMarker = 0;
         ret = false;
     }
@@ -436,43 +915,117 @@ bool DRC::testNetClasses()
 }
 
 
+/**
+ * Class DRC_INDEX_COLLECTOR
+ * is the visitor used to gather the item indices found by a BOARD_RTREE<int>
+ * query. Only indices greater than m_after are kept.
+ */
+struct DRC_INDEX_COLLECTOR
+{
+    std::vector<int>&   m_found;
+    int                 m_after;
+
+    DRC_INDEX_COLLECTOR( std::vector<int>& aFound, int aAfter ) :
+        m_found( aFound ),
+        m_after( aAfter )
+    {}
+
+    bool operator()( int aIndex )
+    {
+        if( aIndex > m_after )
+            m_found.push_back( aIndex );
+
+        return true;
+    }
+};
+
+
 void DRC::testPad2Pad()
 {
     std::vector<D_PAD*> sortedPads;
 
     m_pcb->GetSortedPadListByXthenYCoord( sortedPads );
 
-    // find the max size of the pads (used to stop the test)
-    int max_size = 0;
+    int padCount = sortedPads.size();
+
+    // Index the pads by their own clearance area, so a pad is only compared to the
+    // pads close to it, whatever the size of the biggest pad of the board.
+    // The corners of the rectangular and trapezoidal pads are built only once,
+    // not for each tested pair.
+    BOARD_RTREE<int>        padTree;
+    DRC_PAD_POLYGON_CACHE   padPolygons;
 
-    for( unsigned i = 0; i < sortedPads.size(); ++i )
+    for( int i = 0; i < padCount; ++i )
     {
         D_PAD* pad = sortedPads[i];
 
-        // GetBoundingRadius() is the radius of the minimum sized circle fully containing the pad
-        int radius = pad->GetBoundingRadius();
-        if( radius > max_size )
-            max_size = radius;
+        // Note: padClearanceBBox() also computes the pad bounding radius, which is
+        // cached by the pad: this must be done before the parallel tests.
+        padTree.Insert( i, padClearanceBBox( pad ) );
+
+        if( pad->GetShape() == PAD_RECT || pad->GetShape() == PAD_TRAPEZOID )
+            pad->BuildPadPolygon( padPolygons[pad].m_Corners, wxSize( 0, 0 ),
+                                  pad->GetOrientation() );
     }
 
-    // Test the pads
-    D_PAD** listEnd = &sortedPads[ sortedPads.size() ];
+    m_padPolygons = &padPolygons;
+
+    // Pads are tested in parallel. Each marker is stored at the index of its
+    // reference pad, so markers are added to the board in the same order
+    // as a serial test would do.
+    std::vector<MARKER_PCB*> markers( padCount, (MARKER_PCB*) NULL );
 
-    for( unsigned i = 0; i< sortedPads.size(); ++i )
+#ifdef USE_OPENMP
+    #pragma omp parallel
+#endif /* USE_OPENMP */
     {
-        D_PAD* pad = sortedPads[i];
+        DRC                 worker( *this );
+        std::vector<int>    found;
+        std::vector<D_PAD*> candidates;
+
+#ifdef USE_OPENMP
+        #pragma omp for schedule(dynamic, 64)
+#endif /* USE_OPENMP */
+        for( int i = 0; i < padCount; ++i )
+        {
+            D_PAD*   pad = sortedPads[i];
+            EDA_RECT bbox = padClearanceBBox( pad );
 
-        int    x_limit = max_size + pad->GetClearance() +
-                         pad->GetBoundingRadius() + pad->GetPosition().x;
+            if( !isAreaToTest( bbox ) )
+                continue;
 
-        if( !doPadToPadsDrc( pad, &sortedPads[i], listEnd, x_limit ) )
-        {
-            wxASSERT( m_currentMarker );
-            m_pcb->Add( m_currentMarker );
-            m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
-            m_currentMarker = 0;
+            // Each pair of pads is tested once: only the pads after the reference
+            // pad in the sorted list are candidates, and they are tested in list order.
+            found.clear();
+            DRC_INDEX_COLLECTOR collector( found, i );
+            padTree.Query( bbox, collector );
+
+            if( found.empty() )
+                continue;
+
+            std::sort( found.begin(), found.end() );
+
+            candidates.clear();
+
+            for( unsigned jj = 0; jj < found.size(); ++jj )
+                candidates.push_back( sortedPads[found[jj]] );
+
+            if( !worker.doPadToPadsDrc( pad, candidates ) )
+            {
+                wxASSERT( worker.m_currentMarker );
+                markers[i] = worker.m_currentMarker;
+                worker.m_currentMarker = 0;
+            }
         }
     }
+
+    m_padPolygons = NULL;
+
+    for( unsigned i = 0; i < markers.size(); ++i )
+    {
+        if( markers[i] )
+            addMarkerToPcb( markers[i], sortedPads[i] );
+    }
 }
 
 
@@ -481,13 +1034,35 @@ void DRC::testTracks( bool aShowProgressBar )
     wxProgressDialog * progressDialog = NULL;
     const int delta = 500;  // This is the number of tests between 2 calls to the
                             // progress bar
-    int count = 0;
-    for( TRACK* segm = m_pcb->m_Track; segm && segm->Next(); segm = segm->Next() )
-        count++;
+
+    // Margin added to the search area, to absorb the rounding errors of the
+    // rotated coordinates used in clearance tests
+    const int queryMargin = 2;
+
+    // Index tracks and vias by copper layer, and pads (with their holes).
+    // Tracks are stored by their rank in m_Track, and pads by their rank in the
+    // board pad list, so candidates can be tested in the same order as the
+    // full list walk, and give the same markers.
+    std::vector<TRACK*>         tracks;
+    LAYERED_BOARD_RTREE<int>    trackIndex;
+
+    for( TRACK* segm = m_pcb->m_Track; segm; segm = segm->Next() )
+    {
+        trackIndex.Insert( tracks.size(), segm->GetBoundingBox(), segm->GetLayerSet() );
+        tracks.push_back( segm );
+    }
+
+    BOARD_RTREE<int> padIndex;
+
+    for( unsigned ii = 0; ii < m_pcb->GetPadCount(); ++ii )
+        padIndex.Insert( ii, padClearanceBBox( m_pcb->GetPad( ii ) ) );
+
+    // The last segment has no following segment to be compared to
+    int count = tracks.empty() ? 0 : tracks.size() - 1;
 
     int deltamax = count/delta;
 
-    if( aShowProgressBar && deltamax > 3 )
+    if( aShowProgressBar && m_mainWindow && deltamax > 3 )
     {
         progressDialog = new wxProgressDialog( _( "Track clearances" ), wxEmptyString,
                                                deltamax, m_mainWindow,
@@ -495,32 +1070,90 @@ void DRC::testTracks( bool aShowProgressBar )
         progressDialog->Update( 0, wxEmptyString );
     }
 
-    int ii = 0;
+    // Segments are tested by blocks of delta segments, the segments of a block
+    // being tested in parallel. Each marker is stored at the index of its
+    // reference segment, so markers are added to the board in the same order
+    // as a serial test would do, whatever the number of threads.
+    int segmCount = count;
+    std::vector<MARKER_PCB*> markers( segmCount, (MARKER_PCB*) NULL );
+
     count = 0;
 
-    for( TRACK* segm = m_pcb->m_Track; segm && segm->Next(); segm = segm->Next() )
+    for( int first = 0; first < segmCount; first += delta )
     {
-        if ( ii++ > delta )
+        int last = std::min( first + delta, segmCount );
+
+#ifdef USE_OPENMP
+        #pragma omp parallel
+#endif /* USE_OPENMP */
         {
-            ii = 0;
-            count++;
+            DRC worker( *this );
 
-            if( progressDialog )
+            std::vector<int>    found;
+            std::vector<D_PAD*> padCandidates;
+            std::vector<TRACK*> trackCandidates;
+
+#ifdef USE_OPENMP
+            #pragma omp for schedule(dynamic, 8)
+#endif /* USE_OPENMP */
+            for( int jj = first; jj < last; ++jj )
             {
-                if( !progressDialog->Update( count, wxEmptyString ) )
-                    break;  // Aborted by user
+                TRACK*   segm = tracks[jj];
+                EDA_RECT area = segm->GetBoundingBox();
+
+                if( !isAreaToTest( area ) )
+                    continue;
+
+                area.Inflate( queryMargin );
+
+                // Candidate pads: all the pads near the segment
+                found.clear();
+                DRC_INDEX_COLLECTOR padCollector( found, -1 );
+                padIndex.Query( area, padCollector );
+                std::sort( found.begin(), found.end() );
+
+                padCandidates.clear();
+
+                for( unsigned kk = 0; kk < found.size(); ++kk )
+                    padCandidates.push_back( m_pcb->GetPad( found[kk] ) );
+
+                // Candidate tracks: the tracks near the segment and after it in m_Track.
+                // A via is stored on each of its layers, so remove duplicates
+                found.clear();
+                DRC_INDEX_COLLECTOR trackCollector( found, jj );
+                trackIndex.Query( area, segm->GetLayerSet(), trackCollector );
+                std::sort( found.begin(), found.end() );
+                found.erase( std::unique( found.begin(), found.end() ), found.end() );
+
+                trackCandidates.clear();
+
+                for( unsigned kk = 0; kk < found.size(); ++kk )
+                    trackCandidates.push_back( tracks[found[kk]] );
+
+                if( !worker.doTrackDrc( segm, padCandidates, trackCandidates ) )
+                {
+                    wxASSERT( worker.m_currentMarker );
+                    markers[jj] = worker.m_currentMarker;
+                    worker.m_currentMarker = 0;
+                }
             }
-        }
+        }   /* end of parallel section */
 
-        if( !doTrackDrc( segm, segm->Next(), true ) )
+        count++;
+
+        if( progressDialog )
         {
-            wxASSERT( m_currentMarker );
-            m_pcb->Add( m_currentMarker );
-            m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
-            m_currentMarker = 0;
+            if( !progressDialog->Update( std::min( count, deltamax ), wxEmptyString ) )
+                break;  // Aborted by user
         }
     }
 
+    for( unsigned jj = 0; jj < markers.size(); ++jj )
+    {
+        if( markers[jj] )
+            addMarkerToPcb( markers[jj], tracks[jj] );
+    }
+
     if( progressDialog )
         progressDialog->Destroy();
 }
@@ -528,6 +1161,12 @@ void DRC::testTracks( bool aShowProgressBar )
 
 void DRC::testUnconnected()
 {
+    if( !m_mainWindow )
+    {
+        testUnconnectedItems();
+        return;
+    }
+
     if( (m_pcb->m_Status_Pcb & LISTE_RATSNEST_ITEM_OK) == 0 )
     {
         wxClientDC dc( m_mainWindow->GetCanvas() );
@@ -561,6 +1200,53 @@ void DRC::testUnconnected()
 }
 
 
+void DRC::testUnconnectedItems()
+{
+    // The old style ratsnest needs a main window: use the connectivity data
+    // of the board, built from the current tracks and filled zones
+    RN_DATA* ratsnest = m_pcb->GetRatsnest();
+
+    ratsnest->ProcessBoard();
+
+    wxString msg;
+
+    for( int netcode = 1; netcode < ratsnest->GetNetCount(); ++netcode )
+    {
+        const RN_NET& rnNet = ratsnest->GetNet( netcode );
+        const std::vector<RN_EDGE>& edges = rnNet.GetUnconnected();
+
+        if( edges.empty() )
+            continue;
+
+        NETINFO_ITEM* net = m_pcb->FindNet( netcode );
+
+        for( unsigned ii = 0; ii < edges.size(); ++ii )
+        {
+            const RN_NODE& source = rnNet.GetNode( edges[ii].GetSourceNode() );
+            const RN_NODE& target = rnNet.GetNode( edges[ii].GetTargetNode() );
+
+            wxPoint posStart( source.GetX(), source.GetY() );
+            wxPoint posEnd( target.GetX(), target.GetY() );
+
+            // The ratsnest ends are pads, or vias and track ends
+            D_PAD*  padStart = m_pcb->GetPad( posStart );
+            D_PAD*  padEnd   = m_pcb->GetPad( posEnd );
+
+            msg = padStart ? padStart->GetSelectMenuText() : DRC_ITEM::ShowCoord( posStart );
+            msg += wxT( " net " ) + ( net ? net->GetNetname() : wxString() );
+
+            DRC_ITEM* uncItem = new DRC_ITEM( DRCE_UNCONNECTED_PADS,
+                                              msg,
+                                              padEnd ? padEnd->GetSelectMenuText() :
+                                                       DRC_ITEM::ShowCoord( posEnd ),
+                                              posStart, posEnd );
+
+            m_unconnected.push_back( uncItem );
+        }
+    }
+}
+
+
 void DRC::testZones()
 {
     // Test copper areas for valid netcodes
@@ -590,8 +1276,7 @@ void DRC::testZones()
         {
             m_currentMarker = fillMarker( test_area,
                                           DRCE_SUSPICIOUS_NET_FOR_ZONE_OUTLINE, m_currentMarker );
-            m_pcb->Add( m_currentMarker );
-            m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+            addMarkerToPcb( m_currentMarker );
             m_currentMarker = NULL;
         }
     }
@@ -626,8 +1311,7 @@ void DRC::testKeepoutAreas()
                 {
                     m_currentMarker = fillMarker( segm, NULL,
                                                   DRCE_TRACK_INSIDE_KEEPOUT, m_currentMarker );
-                    m_pcb->Add( m_currentMarker );
-                    m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+                    addMarkerToPcb( m_currentMarker );
                     m_currentMarker = 0;
                 }
             }
@@ -643,8 +1327,7 @@ void DRC::testKeepoutAreas()
                 {
                     m_currentMarker = fillMarker( segm, NULL,
                                                   DRCE_VIA_INSIDE_KEEPOUT, m_currentMarker );
-                    m_pcb->Add( m_currentMarker );
-                    m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
+                    addMarkerToPcb( m_currentMarker );
                     m_currentMarker = 0;
                 }
             }
@@ -654,12 +1337,62 @@ void DRC::testKeepoutAreas()
 }
 
 
+bool DRC_TEXT_SHAPE::IsUpToDate( const TEXTE_PCB* aText ) const
+{
+    return m_text == aText->GetText()
+        && m_pos == aText->GetTextPosition()
+        && m_size == aText->GetSize()
+        && m_thickness == aText->GetThickness()
+        && m_orient == aText->GetOrientation()
+        && m_hJustify == aText->GetHorizJustify()
+        && m_vJustify == aText->GetVertJustify()
+        && m_italic == aText->IsItalic()
+        && m_bold == aText->IsBold()
+        && m_mirror == aText->IsMirrored()
+        && m_multiline == aText->IsMultilineAllowed();
+}
+
+
+void DRC_TEXT_SHAPE::Build( const TEXTE_PCB* aText )
+{
+    m_text      = aText->GetText();
+    m_pos       = aText->GetTextPosition();
+    m_size      = aText->GetSize();
+    m_thickness = aText->GetThickness();
+    m_orient    = aText->GetOrientation();
+    m_hJustify  = aText->GetHorizJustify();
+    m_vJustify  = aText->GetVertJustify();
+    m_italic    = aText->IsItalic();
+    m_bold      = aText->IsBold();
+    m_mirror    = aText->IsMirrored();
+    m_multiline = aText->IsMultilineAllowed();
+
+    m_segments.clear();
+    aText->TransformTextShapeToSegmentList( m_segments );
+
+    m_bbox = EDA_RECT();
+
+    for( unsigned ii = 0; ii < m_segments.size(); ++ii )
+    {
+        if( ii == 0 )
+            m_bbox = EDA_RECT( m_segments[ii], wxSize( 0, 0 ) );
+        else
+            m_bbox.Merge( m_segments[ii] );
+    }
+}
+
+
 void DRC::testTexts()
 {
-    std::vector<wxPoint> textShape;      // a buffer to store the text shape (set of segments)
     std::vector<D_PAD*> padList = m_pcb->GetPads();
 
-    // Test text areas for vias, tracks and pads inside text areas
+    // Get the text shapes first: TransformTextShapeToSegmentList() uses a static
+    // buffer and cannot be called from several threads.
+    // The shapes are kept from one run to the next one, and only the shapes of
+    // the new or modified texts are built.
+    std::vector<TEXTE_PCB*>     texts;
+    std::set<const TEXTE_PCB*>  textSet;
+
     for( BOARD_ITEM* item = m_pcb->m_Drawings; item; item = item->Next() )
     {
         // Drc test only items on copper layers
@@ -670,115 +1403,207 @@ void DRC::testTexts()
         if( item->Type() !=  PCB_TEXT_T )
             continue;
 
-        textShape.clear();
+        TEXTE_PCB*      text = (TEXTE_PCB*) item;
+        DRC_TEXT_SHAPE& shape = m_textShapes[text];
 
-        // So far the bounding box makes up the text-area
-        TEXTE_PCB* text = (TEXTE_PCB*) item;
-        text->TransformTextShapeToSegmentList( textShape );
+        if( !shape.IsUpToDate( text ) )
+            shape.Build( text );
 
-        if( textShape.size() == 0 )     // Should not happen (empty text?)
-            continue;
+        texts.push_back( text );
+        textSet.insert( text );
+    }
+
+    // Forget the shapes of the deleted texts
+    for( DRC_TEXT_SHAPE_CACHE::iterator it = m_textShapes.begin(); it != m_textShapes.end(); )
+    {
+        if( textSet.count( it->first ) )
+            ++it;
+        else
+            it = m_textShapes.erase( it );
+    }
+
+    // Index tracks and vias by copper layer, and pads. The bounding boxes of
+    // tracks and pads include their clearance. Items are stored by their rank in
+    // their list, so candidates are tested in the list order, and give the same
+    // markers as the full list walk.
+    std::vector<TRACK*>         tracks;
+    LAYERED_BOARD_RTREE<int>    trackIndex;
 
-        for( TRACK* track = m_pcb->m_Track; track != NULL; track = track->Next() )
+    for( TRACK* track = m_pcb->m_Track; track; track = track->Next() )
+    {
+        trackIndex.Insert( tracks.size(), track->GetBoundingBox(), track->GetLayerSet() );
+        tracks.push_back( track );
+    }
+
+    BOARD_RTREE<int> padIndex;
+
+    for( unsigned ii = 0; ii < padList.size(); ++ii )
+        padIndex.Insert( ii, padClearanceBBox( padList[ii] ) );
+
+    // Margin added to the search area, to absorb the rounding errors of the
+    // rotated coordinates used in clearance tests
+    const int queryMargin = 2;
+
+    // Test text areas for vias, tracks and pads inside text areas.
+    // Markers are stored by text, and added to the board in the text order.
+    int textCount = texts.size();
+    std::vector< std::vector<MARKER_PCB*> > markers( textCount );
+
+#ifdef USE_OPENMP
+    #pragma omp parallel
+#endif /* USE_OPENMP */
+    {
+        DRC worker( *this );
+
+        std::vector<int>    found;
+        std::vector<TRACK*> trackCandidates;
+        std::vector<D_PAD*> padCandidates;
+
+#ifdef USE_OPENMP
+        #pragma omp for schedule(dynamic, 1)
+#endif /* USE_OPENMP */
+        for( int ii = 0; ii < textCount; ++ii )
         {
-            if( ! track->IsOnLayer( item->GetLayer() ) )
-                    continue;
+            const DRC_TEXT_SHAPE& shape = m_textShapes.find( texts[ii] )->second;
+
+            if( shape.GetSegments().size() == 0 )     // Should not happen (empty text?)
+                continue;
+
+            if( !isAreaToTest( itemDrcArea( texts[ii] ) ) )
+                continue;
+
+            EDA_RECT area = shape.GetBoundingBox();
+            area.Inflate( texts[ii]->GetThickness() / 2 + queryMargin );
+
+            found.clear();
+            DRC_INDEX_COLLECTOR trackCollector( found, -1 );
+            trackIndex.Query( area, LSET( texts[ii]->GetLayer() ), trackCollector );
+            std::sort( found.begin(), found.end() );
+
+            trackCandidates.clear();
+
+            for( unsigned jj = 0; jj < found.size(); ++jj )
+                trackCandidates.push_back( tracks[found[jj]] );
+
+            found.clear();
+            DRC_INDEX_COLLECTOR padCollector( found, -1 );
+            padIndex.Query( area, padCollector );
+            std::sort( found.begin(), found.end() );
+
+            padCandidates.clear();
+
+            for( unsigned jj = 0; jj < found.size(); ++jj )
+                padCandidates.push_back( padList[found[jj]] );
+
+            worker.doTextDrc( texts[ii], shape.GetSegments(), trackCandidates, padCandidates,
+                              markers[ii] );
+        }
+    }
+
+    for( unsigned ii = 0; ii < markers.size(); ++ii )
+    {
+        for( unsigned jj = 0; jj < markers[ii].size(); ++jj )
+            addMarkerToPcb( markers[ii][jj], texts[ii] );
+    }
+}
+
+
+void DRC::doTextDrc( TEXTE_PCB* aText, const std::vector<wxPoint>& aTextShape,
+                     const std::vector<TRACK*>& aTracks, const std::vector<D_PAD*>& aPads,
+                     std::vector<MARKER_PCB*>& aMarkers )
+{
+    LAYER_ID layer = aText->GetLayer();
+
+    for( unsigned ii = 0; ii < aTracks.size(); ii++ )
+    {
+        TRACK* track = aTracks[ii];
+
+        if( ! track->IsOnLayer( layer ) )
+                continue;
 
-            // Test the distance between each segment and the current track/via
-            int min_dist = ( track->GetWidth() + text->GetThickness() ) /2 +
-                           track->GetClearance(NULL);
+        // Test the distance between each segment and the current track/via
+        int min_dist = ( track->GetWidth() + aText->GetThickness() ) /2 +
+                       track->GetClearance(NULL);
 
-            if( track->Type() == PCB_TRACE_T )
+        if( track->Type() == PCB_TRACE_T )
+        {
+            SEG segref( track->GetStart(), track->GetEnd() );
+
+            // Error condition: Distance between text segment and track segment is
+            // smaller than the clearance of the segment
+            for( unsigned jj = 0; jj < aTextShape.size(); jj += 2 )
             {
-                SEG segref( track->GetStart(), track->GetEnd() );
+                SEG segtest( aTextShape[jj], aTextShape[jj+1] );
+                int dist = segref.Distance( segtest );
 
-                // Error condition: Distance between text segment and track segment is
-                // smaller than the clearance of the segment
-                for( unsigned jj = 0; jj < textShape.size(); jj += 2 )
+                if( dist < min_dist )
                 {
-                    SEG segtest( textShape[jj], textShape[jj+1] );
-                    int dist = segref.Distance( segtest );
-
-                    if( dist < min_dist )
-                    {
-                        m_currentMarker = fillMarker( track, text,
-                                                      DRCE_TRACK_INSIDE_TEXT,
-                                                      m_currentMarker );
-                        m_pcb->Add( m_currentMarker );
-                        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
-                        m_currentMarker = NULL;
-                        break;
-                    }
+                    aMarkers.push_back( fillMarker( track, aText,
+                                                    DRCE_TRACK_INSIDE_TEXT, NULL ) );
+                    break;
                 }
             }
-            else if( track->Type() == PCB_VIA_T )
+        }
+        else if( track->Type() == PCB_VIA_T )
+        {
+            // Error condition: Distance between text segment and via is
+            // smaller than the clearance of the via
+            for( unsigned jj = 0; jj < aTextShape.size(); jj += 2 )
             {
-                // Error condition: Distance between text segment and via is
-                // smaller than the clearance of the via
-                for( unsigned jj = 0; jj < textShape.size(); jj += 2 )
+                SEG segtest( aTextShape[jj], aTextShape[jj+1] );
+
+                if( segtest.PointCloserThan( track->GetPosition(), min_dist ) )
                 {
-                    SEG segtest( textShape[jj], textShape[jj+1] );
-
-                    if( segtest.PointCloserThan( track->GetPosition(), min_dist ) )
-                    {
-                        m_currentMarker = fillMarker( track, text,
-                                                      DRCE_VIA_INSIDE_TEXT, m_currentMarker );
-                        m_pcb->Add( m_currentMarker );
-                        m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
-                        m_currentMarker = NULL;
-                        break;
-                    }
+                    aMarkers.push_back( fillMarker( track, aText,
+                                                    DRCE_VIA_INSIDE_TEXT, NULL ) );
+                    break;
                 }
             }
         }
+    }
 
-        // Test pads
-        for( unsigned ii = 0; ii < padList.size(); ii++ )
-        {
-            D_PAD* pad = padList[ii];
+    // Test pads
+    for( unsigned ii = 0; ii < aPads.size(); ii++ )
+    {
+        D_PAD* pad = aPads[ii];
 
-            if( ! pad->IsOnLayer( item->GetLayer() ) )
-                    continue;
+        if( ! pad->IsOnLayer( layer ) )
+                continue;
 
-            wxPoint shape_pos = pad->ShapePos();
+        wxPoint shape_pos = pad->ShapePos();
 
-            for( unsigned jj = 0; jj < textShape.size(); jj += 2 )
+        for( unsigned jj = 0; jj < aTextShape.size(); jj += 2 )
+        {
+            /* In order to make some calculations more easier or faster,
+             * pads and tracks coordinates will be made relative
+             * to the segment origin
+             */
+            wxPoint origin = aTextShape[jj];  // origin will be the origin of other coordinates
+            m_segmEnd = aTextShape[jj+1] - origin;
+            wxPoint delta = m_segmEnd;
+            m_segmAngle = 0;
+
+            // for a non horizontal or vertical segment Compute the segment angle
+            // in tenths of degrees and its length
+            if( delta.x || delta.y )    // delta.x == delta.y == 0 for vias
             {
-                SEG segtest( textShape[jj], textShape[jj+1] );
-                /* In order to make some calculations more easier or faster,
-                 * pads and tracks coordinates will be made relative
-                 * to the segment origin
-                 */
-                wxPoint origin = textShape[jj];  // origin will be the origin of other coordinates
-                m_segmEnd = textShape[jj+1] - origin;
-                wxPoint delta = m_segmEnd;
-                m_segmAngle = 0;
-
-                // for a non horizontal or vertical segment Compute the segment angle
-                // in tenths of degrees and its length
-                if( delta.x || delta.y )    // delta.x == delta.y == 0 for vias
-                {
-                    // Compute the segment angle in 0,1 degrees
-                    m_segmAngle = ArcTangente( delta.y, delta.x );
+                // Compute the segment angle in 0,1 degrees
+                m_segmAngle = ArcTangente( delta.y, delta.x );
 
-                    // Compute the segment length: we build an equivalent rotated segment,
-                    // this segment is horizontal, therefore dx = length
-                    RotatePoint( &delta, m_segmAngle );    // delta.x = length, delta.y = 0
-                }
+                // Compute the segment length: we build an equivalent rotated segment,
+                // this segment is horizontal, therefore dx = length
+                RotatePoint( &delta, m_segmAngle );    // delta.x = length, delta.y = 0
+            }
 
-                m_segmLength = delta.x;
-                m_padToTestPos = shape_pos - origin;
+            m_segmLength = delta.x;
+            m_padToTestPos = shape_pos - origin;
 
-                if( !checkClearanceSegmToPad( pad, text->GetThickness(),
-                                              pad->GetClearance(NULL) ) )
-                {
-                    m_currentMarker = fillMarker( pad, text,
-                                                  DRCE_PAD_INSIDE_TEXT, m_currentMarker );
-                    m_pcb->Add( m_currentMarker );
-                    m_mainWindow->GetGalCanvas()->GetView()->Add( m_currentMarker );
-                    m_currentMarker = NULL;
-                    break;
-                }
+            if( !checkClearanceSegmToPad( pad, aText->GetThickness(),
+                                          pad->GetClearance(NULL) ) )
+            {
+                aMarkers.push_back( fillMarker( pad, aText,
+                                                DRCE_PAD_INSIDE_TEXT, NULL ) );
+                break;
             }
         }
     }
@@ -832,7 +1657,7 @@ bool DRC::doTrackKeepoutDrc( TRACK* aRefSeg )
 }
 
 
-bool DRC::doPadToPadsDrc( D_PAD* aRefPad, D_PAD** aStart, D_PAD** aEnd, int x_limit )
+bool DRC::doPadToPadsDrc( D_PAD* aRefPad, const std::vector<D_PAD*>& aPads )
 {
     const static LSET all_cu = LSET::AllCuMask();
 
@@ -855,18 +1680,13 @@ bool DRC::doPadToPadsDrc( D_PAD* aRefPad, D_PAD** aStart, D_PAD** aEnd, int x_li
     // (a value = 0 means use netclass value)
     dummypad.SetLocalClearance( 1 );
 
-    for( D_PAD** pad_list = aStart;  pad_list<aEnd;  ++pad_list )
+    for( unsigned ii = 0; ii < aPads.size(); ++ii )
     {
-        D_PAD* pad = *pad_list;
+        D_PAD* pad = aPads[ii];
 
         if( pad == aRefPad )
             continue;
 
-        // We can stop the test when pad->GetPosition().x > x_limit
-        // because the list is sorted by X values
-        if( pad->GetPosition().x > x_limit )
-            break;
-
         // No problem if pads are on different copper layers,
         // but their hole (if any ) can create DRC error because they are on all
         // copper layers, so we test them
@@ -0,0 +1,464 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file drc_bench.cpp
+ * @brief DRC benchmark on synthetic boards.
+ *
+ * Usage: drc_bench [--tracks N] [--pads M] [--zones K] [--layers L] [--seed S]
+ *                  [--scale MAX_ITEMS] [--save board_file] [--no-pad2pad]
+ *                  [--no-unconnected] [--no-zones] [--no-keepout]
+ *
+ * A board is generated from the given parameters: nets are clustered in small
+ * areas, each one with its tracks, vias and pads, and the zones tile the board.
+ * The same seed always gives the same board.  The DRC is then run on this board,
+ * and the wall time of each phase is written to the standard output, as CSV lines:
+ *
+ *      items,tracks,pads,zones,layers,phase,ms,peak_rss_kb,markers
+ *
+ * The "generate" line is the time taken by the board generator, and the "total" line
+ * is the whole DRC run; only this line gives the number of markers and unconnected items.
+ *
+ * With --scale, boards of 1000, 10000 ... up to MAX_ITEMS items are tested, with the
+ * same proportions of tracks, pads and zones, to give the scaling curve of each phase.
+ *
+ * peak_rss_kb is the peak resident memory of the process since its start (0 when not
+ * available): the boards being tested by increasing size, it is the peak of the
+ * current run.
+ */
+
+#include <cmath>
+
+#include <fctsys.h>
+#include <wx/cmdline.h>
+
+#include <common.h>
+#include <macros.h>
+#include <convert_to_biu.h>
+#include <io_mgr.h>
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <class_zone.h>
+#include <class_netinfo.h>
+#include <profile.h>
+
+#include <drc_stuff.h>
+#include <pcbnew_tool.h>
+
+#ifndef __WINDOWS__
+#include <sys/resource.h>
+#endif
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    { wxCMD_LINE_OPTION, NULL, "tracks", "number of tracks and vias (default 6000)",
+      wxCMD_LINE_VAL_NUMBER, 0 },
+    { wxCMD_LINE_OPTION, NULL, "pads", "number of pads (default 3000)",
+      wxCMD_LINE_VAL_NUMBER, 0 },
+    { wxCMD_LINE_OPTION, NULL, "zones", "number of zones (default 4)",
+      wxCMD_LINE_VAL_NUMBER, 0 },
+    { wxCMD_LINE_OPTION, NULL, "layers", "number of copper layers (default 4)",
+      wxCMD_LINE_VAL_NUMBER, 0 },
+    { wxCMD_LINE_OPTION, NULL, "seed", "seed of the board generator (default 1)",
+      wxCMD_LINE_VAL_NUMBER, 0 },
+    { wxCMD_LINE_OPTION, NULL, "scale", "test boards of 1000 items up to this number of items",
+      wxCMD_LINE_VAL_NUMBER, 0 },
+    { wxCMD_LINE_OPTION, NULL, "save", "save the (last) generated board to this file",
+      wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_SWITCH, NULL, "no-pad2pad", "do not run the pad to pad test",
+      wxCMD_LINE_VAL_NONE, 0 },
+    { wxCMD_LINE_SWITCH, NULL, "no-unconnected", "do not run the unconnected items test",
+      wxCMD_LINE_VAL_NONE, 0 },
+    { wxCMD_LINE_SWITCH, NULL, "no-zones", "do not run the zone tests",
+      wxCMD_LINE_VAL_NONE, 0 },
+    { wxCMD_LINE_SWITCH, NULL, "no-keepout", "do not run the keepout area test",
+      wxCMD_LINE_VAL_NONE, 0 },
+    { wxCMD_LINE_NONE }
+};
+
+
+/**
+ * Struct BENCH_PARAMS
+ * are the parameters of a synthetic board.
+ */
+struct BENCH_PARAMS
+{
+    int m_Tracks;       ///< number of track segments and vias (1 via every 10 items)
+    int m_Pads;         ///< number of pads (footprints of 10 pads)
+    int m_Zones;        ///< number of zones
+    int m_Layers;       ///< number of copper layers
+    int m_Seed;         ///< seed of the random generator
+
+    int GetItemCount() const { return m_Tracks + m_Pads + m_Zones; }
+};
+
+
+/**
+ * Class BENCH_RANDOM
+ * is a small linear congruential generator, giving the same boards on every platform
+ * (rand() does not).
+ */
+class BENCH_RANDOM
+{
+public:
+    BENCH_RANDOM( unsigned aSeed ) : m_state( aSeed ) {}
+
+    ///> @return a value in [0, aRange[
+    int Get( int aRange )
+    {
+        m_state = m_state * 1103515245u + 12345u;
+        return ( ( m_state >> 8 ) % (unsigned) aRange );
+    }
+
+private:
+    unsigned m_state;
+};
+
+
+static LAYER_ID copperLayer( int aIndex, int aLayerCount )
+{
+    if( aIndex == 0 )
+        return F_Cu;
+
+    if( aIndex == aLayerCount - 1 )
+        return B_Cu;
+
+    return ToLAYER_ID( In1_Cu + aIndex - 1 );
+}
+
+
+/**
+ * Function generateBoard
+ * @return a new board built from aParams.
+ * The board is a square, its size growing with the number of items to keep the
+ * same item density.  Each net has its tracks, vias and pads in a 10 mm square.
+ */
+static BOARD* generateBoard( const BENCH_PARAMS& aParams )
+{
+    BOARD*          board = new BOARD();
+    BENCH_RANDOM    random( aParams.m_Seed );
+
+    board->SetCopperLayerCount( aParams.m_Layers );
+
+    const int boardSize = KiROUND( sqrt( (double) aParams.GetItemCount() ) * 2.5 * IU_PER_MM ) +
+                          Millimeter2iu( 20 );
+    const int netArea   = Millimeter2iu( 10 );
+    const int netCount  = std::max( 1, ( aParams.m_Tracks + aParams.m_Pads ) / 20 );
+
+    std::vector<wxPoint> netOrigins;
+
+    for( int net = 1; net <= netCount; ++net )
+    {
+        board->AppendNet( new NETINFO_ITEM( board, wxString::Format( wxT( "N%d" ), net ), net ) );
+        netOrigins.push_back( wxPoint( random.Get( boardSize - netArea ),
+                                       random.Get( boardSize - netArea ) ) );
+    }
+
+    // Tracks and vias, by increasing net code, as expected in BOARD::m_Track
+    const int length = Millimeter2iu( 3 );
+
+    for( int ii = 0; ii < aParams.m_Tracks; ++ii )
+    {
+        int     net = 1 + (int) ( (int64_t) ii * netCount / aParams.m_Tracks );
+        wxPoint start = netOrigins[net - 1] + wxPoint( random.Get( netArea ),
+                                                       random.Get( netArea ) );
+        TRACK*  track;
+
+        if( ii % 10 == 9 )
+        {
+            VIA* via = new VIA( board );
+
+            via->SetViaType( VIA_THROUGH );
+            via->SetLayerPair( F_Cu, B_Cu );
+            via->SetWidth( Millimeter2iu( 0.6 ) );
+            via->SetDrill( Millimeter2iu( 0.3 ) );
+            via->SetPosition( start );
+            track = via;
+        }
+        else
+        {
+            // Horizontal, vertical and 45 degree segments
+            static const int dirs[8][2] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 },
+                                            { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+            int     dir = random.Get( 8 );
+            int     len = Millimeter2iu( 0.5 ) + random.Get( length );
+
+            track = new TRACK( board );
+            track->SetLayer( copperLayer( random.Get( aParams.m_Layers ), aParams.m_Layers ) );
+            track->SetWidth( Millimeter2iu( 0.25 ) );
+            track->SetStart( start );
+            track->SetEnd( start + wxPoint( dirs[dir][0] * len, dirs[dir][1] * len ) );
+        }
+
+        track->SetNetCode( net );
+        board->Add( track, ADD_APPEND );
+    }
+
+    // Footprints of 10 pads, half SMD and half through hole
+    const int padsPerModule = 10;
+    const int pitch = Millimeter2iu( 1.27 );
+
+    for( int ii = 0; ii < aParams.m_Pads; ii += padsPerModule )
+    {
+        int     net = 1 + (int) ( (int64_t) ii * netCount / aParams.m_Pads );
+        wxPoint origin = netOrigins[net - 1] + wxPoint( random.Get( netArea ),
+                                                        random.Get( netArea ) );
+        bool    smd = ( ii / padsPerModule ) % 2 == 0;
+        MODULE* module = new MODULE( board );
+
+        module->SetPosition( origin );
+        module->SetReference( wxString::Format( wxT( "U%d" ), ii / padsPerModule + 1 ) );
+
+        for( int jj = 0; jj < padsPerModule && ii + jj < aParams.m_Pads; ++jj )
+        {
+            D_PAD*  pad = new D_PAD( module );
+            wxPoint pos0( jj * pitch, 0 );
+
+            pad->SetPadName( wxString::Format( wxT( "%d" ), jj + 1 ) );
+            pad->SetPos0( pos0 );
+            pad->SetPosition( origin + pos0 );
+
+            if( smd )
+            {
+                pad->SetShape( PAD_RECT );
+                pad->SetAttribute( PAD_SMD );
+                pad->SetLayerSet( D_PAD::SMDMask() );
+                pad->SetSize( wxSize( Millimeter2iu( 0.6 ), Millimeter2iu( 1.5 ) ) );
+            }
+            else
+            {
+                pad->SetShape( PAD_CIRCLE );
+                pad->SetAttribute( PAD_STANDARD );
+                pad->SetLayerSet( D_PAD::StandardMask() );
+                pad->SetSize( wxSize( Millimeter2iu( 0.9 ), Millimeter2iu( 0.9 ) ) );
+                pad->SetDrillSize( wxSize( Millimeter2iu( 0.5 ), Millimeter2iu( 0.5 ) ) );
+            }
+
+            // Most pads are on the footprint net, some ones are on the next net
+            pad->SetNetCode( jj % 4 == 3 ? net % netCount + 1 : net );
+            module->Add( pad );
+        }
+
+        board->Add( module, ADD_APPEND );
+    }
+
+    // Zones tile the board, with a 1 mm gap between them
+    int columns = std::max( 1, (int) ceil( sqrt( (double) aParams.m_Zones ) ) );
+    int rows    = ( aParams.m_Zones + columns - 1 ) / std::max( 1, columns );
+    int gap     = Millimeter2iu( 1 );
+
+    for( int ii = 0; ii < aParams.m_Zones; ++ii )
+    {
+        int x0 = ( ii % columns ) * boardSize / columns;
+        int y0 = ( ii / columns ) * boardSize / rows;
+        int x1 = ( ii % columns + 1 ) * boardSize / columns - gap;
+        int y1 = ( ii / columns + 1 ) * boardSize / rows - gap;
+
+        ZONE_CONTAINER* zone = new ZONE_CONTAINER( board );
+
+        zone->SetLayer( copperLayer( ii % aParams.m_Layers, aParams.m_Layers ) );
+        zone->SetNetCode( 1 + ii % netCount );
+        zone->SetZoneClearance( Millimeter2iu( 0.3 ) );
+        zone->SetMinThickness( Millimeter2iu( 0.25 ) );
+
+        std::vector<wxPoint> corners;
+        corners.push_back( wxPoint( x0, y0 ) );
+        corners.push_back( wxPoint( x1, y0 ) );
+        corners.push_back( wxPoint( x1, y1 ) );
+        corners.push_back( wxPoint( x0, y1 ) );
+        zone->AddPolygon( corners );
+
+        board->Add( zone );
+    }
+
+    // As done after loading a board
+    board->BuildListOfNets();
+    board->SynchronizeNetsAndNetClasses();
+    board->GetDesignSettings().SetCurrentNetClass( NETCLASS::Default );
+
+    return board;
+}
+
+
+/**
+ * Function peakMemory
+ * @return the peak resident memory of the process in kilobytes, or 0 if unknown.
+ */
+static long peakMemory()
+{
+#ifndef __WINDOWS__
+    struct rusage usage;
+
+    if( getrusage( RUSAGE_SELF, &usage ) == 0 )
+    {
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;     // in bytes on OS X
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+
+    return 0;
+}
+
+
+static void writePhase( const BENCH_PARAMS& aParams, const wxString& aPhase, uint64_t aUsecs,
+                        int aMarkers )
+{
+    printf( "%d,%d,%d,%d,%d,%s,%.3f,%ld,%d\n",
+            aParams.GetItemCount(), aParams.m_Tracks, aParams.m_Pads, aParams.m_Zones,
+            aParams.m_Layers, TO_UTF8( aPhase ), aUsecs / 1000.0, peakMemory(), aMarkers );
+    fflush( stdout );
+}
+
+
+/**
+ * Function runBench
+ * generates a board from aParams, runs the DRC on it and writes the phase times.
+ * @return the generated board, which is owned by the caller.
+ */
+static BOARD* runBench( const BENCH_PARAMS& aParams, const wxCmdLineParser& aParser )
+{
+    prof_counter counter;
+
+    prof_start( &counter );
+    BOARD* board = generateBoard( aParams );
+    prof_end( &counter );
+
+    writePhase( aParams, wxT( "generate" ), counter.usecs(), 0 );
+
+    DRC drc( board );
+
+    drc.SetSettings( !aParser.Found( wxT( "no-pad2pad" ) ),
+                     !aParser.Found( wxT( "no-unconnected" ) ),
+                     !aParser.Found( wxT( "no-zones" ) ),
+                     !aParser.Found( wxT( "no-keepout" ) ),
+                     wxEmptyString, false );
+
+    prof_start( &counter );
+    drc.RunTests();
+    prof_end( &counter );
+
+    const std::vector<DRC_PHASE_TIME>& phases = drc.GetPhaseTimes();
+
+    for( unsigned ii = 0; ii < phases.size(); ++ii )
+        writePhase( aParams, phases[ii].m_Name, phases[ii].m_Usecs, 0 );
+
+    writePhase( aParams, wxT( "total" ), counter.usecs(),
+                board->GetMARKERCount() + drc.GetUnconnectedItems().size() );
+
+    return board;
+}
+
+
+int main( int argc, char** argv )
+{
+    if( !InitPcbnewTool( argc, argv, "drc_bench" ) )
+        return 1;
+
+    wxCmdLineParser parser( g_cmdLineDesc, argc, argv );
+
+    if( parser.Parse() != 0 )
+        return 1;
+
+    long tracks = 6000;
+    long pads   = 3000;
+    long zones  = 4;
+    long layers = 4;
+    long seed   = 1;
+    long scale  = 0;
+
+    parser.Found( wxT( "tracks" ), &tracks );
+    parser.Found( wxT( "pads" ), &pads );
+    parser.Found( wxT( "zones" ), &zones );
+    parser.Found( wxT( "layers" ), &layers );
+    parser.Found( wxT( "seed" ), &seed );
+    parser.Found( wxT( "scale" ), &scale );
+
+    if( tracks < 0 || pads < 0 || zones < 0 || layers < 2 || layers > MAX_CU_LAYERS
+        || layers % 2 )
+    {
+        fprintf( stderr, "drc_bench: bad board parameters\n" );
+        return 1;
+    }
+
+    BENCH_PARAMS params;
+
+    params.m_Tracks = tracks;
+    params.m_Pads   = pads;
+    params.m_Zones  = zones;
+    params.m_Layers = layers;
+    params.m_Seed   = seed;
+
+    // The list of boards to test: the given one, or boards of 10^3 ... items
+    // keeping the proportions of the given parameters
+    std::vector<BENCH_PARAMS> runs;
+
+    if( scale > 0 )
+    {
+        double total = std::max( 1, params.GetItemCount() );
+
+        for( long items = 1000; items <= scale; items *= 10 )
+        {
+            BENCH_PARAMS run = params;
+
+            run.m_Tracks = KiROUND( items * params.m_Tracks / total );
+            run.m_Pads   = KiROUND( items * params.m_Pads / total );
+            run.m_Zones  = std::max( params.m_Zones ? 1 : 0,
+                                     KiROUND( items * params.m_Zones / total ) );
+            runs.push_back( run );
+        }
+    }
+    else
+    {
+        runs.push_back( params );
+    }
+
+    printf( "items,tracks,pads,zones,layers,phase,ms,peak_rss_kb,markers\n" );
+
+    for( unsigned ii = 0; ii < runs.size(); ++ii )
+    {
+        BOARD*      board = runBench( runs[ii], parser );
+        wxString    saveName;
+
+        if( ii == runs.size() - 1 && parser.Found( wxT( "save" ), &saveName ) )
+        {
+            try
+            {
+                IO_MGR::Save( IO_MGR::KICAD, saveName, board );
+            }
+            catch( const IO_ERROR& ioe )
+            {
+                fprintf( stderr, "drc_bench: error saving board '%s':\n%s\n",
+                         TO_UTF8( saveName ), TO_UTF8( ioe.errorText ) );
+            }
+        }
+
+        delete board;
+    }
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file drc_clearance_kernels.cpp
+ */
+
+#include <algorithm>
+
+#include <drc_clearance_kernels.h>
+
+
+/**
+ * Function pointToSegmentDist2
+ * @return the squared distance between the point aP and the segment starting at aA,
+ * of vector aAB. aInvLen2 is 1 / |aAB|^2, or 0 for a null segment.
+ */
+static inline double pointToSegmentDist2( double aPx, double aPy, double aAx, double aAy,
+                                          double aABx, double aABy, double aInvLen2 )
+{
+    double t = ( ( aPx - aAx ) * aABx + ( aPy - aAy ) * aABy ) * aInvLen2;
+
+    t = std::min( std::max( t, 0.0 ), 1.0 );
+
+    double dx = aAx + t * aABx - aPx;
+    double dy = aAy + t * aABy - aPy;
+
+    return dx * dx + dy * dy;
+}
+
+
+void DRC_SEGMENT_BATCH::TestSegment( const wxPoint& aRefStart, const wxPoint& aRefEnd,
+                                     int aMargin, std::vector<unsigned char>& aMayCollide ) const
+{
+    const int count = GetCount();
+
+    aMayCollide.resize( count );
+
+    if( count == 0 )
+        return;
+
+    const double ax  = aRefStart.x;
+    const double ay  = aRefStart.y;
+    const double bx  = aRefEnd.x;
+    const double by  = aRefEnd.y;
+    const double abx = bx - ax;
+    const double aby = by - ay;
+    const double abLen2 = abx * abx + aby * aby;
+    const double invAbLen2 = abLen2 > 0.0 ? 1.0 / abLen2 : 0.0;
+
+    const double*  sx = &m_startX[0];
+    const double*  sy = &m_startY[0];
+    const double*  ex = &m_endX[0];
+    const double*  ey = &m_endY[0];
+    const double*  minDist = &m_minDist[0];
+    unsigned char* result = &aMayCollide[0];
+
+    // No branch in this loop, so it can be vectorized
+#if defined( USE_OPENMP ) && _OPENMP >= 201307
+    #pragma omp simd
+#endif /* USE_OPENMP */
+    for( int ii = 0; ii < count; ++ii )
+    {
+        const double cdx = ex[ii] - sx[ii];
+        const double cdy = ey[ii] - sy[ii];
+        const double cdLen2 = cdx * cdx + cdy * cdy;
+        const double invCdLen2 = cdLen2 > 0.0 ? 1.0 / cdLen2 : 0.0;
+
+        // When the segments do not cross, their distance is the distance
+        // from one of the 4 ends to the other segment
+        double dist2 = std::min(
+                std::min( pointToSegmentDist2( sx[ii], sy[ii], ax, ay, abx, aby, invAbLen2 ),
+                          pointToSegmentDist2( ex[ii], ey[ii], ax, ay, abx, aby, invAbLen2 ) ),
+                std::min( pointToSegmentDist2( ax, ay, sx[ii], sy[ii], cdx, cdy, invCdLen2 ),
+                          pointToSegmentDist2( bx, by, sx[ii], sy[ii], cdx, cdy, invCdLen2 ) ) );
+
+        // Crossing test (only meaningful for 2 segments of non null length)
+        const double o1 = abx * ( sy[ii] - ay ) - aby * ( sx[ii] - ax );
+        const double o2 = abx * ( ey[ii] - ay ) - aby * ( ex[ii] - ax );
+        const double o3 = cdx * ( ay - sy[ii] ) - cdy * ( ax - sx[ii] );
+        const double o4 = cdx * ( by - sy[ii] ) - cdy * ( bx - sx[ii] );
+
+        const bool crossing = ( abLen2 > 0.0 ) & ( cdLen2 > 0.0 )
+                              & ( o1 * o2 <= 0.0 ) & ( o3 * o4 <= 0.0 );
+
+        const double limit = minDist[ii] + aMargin;
+
+        result[ii] = crossing | ( dist2 < limit * limit );
+    }
+}
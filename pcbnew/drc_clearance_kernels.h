@@ -0,0 +1,110 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file drc_clearance_kernels.h
+ * @brief Batched distance tests used to skip the candidates of a DRC test
+ * which are certainly far enough from the reference item.
+ */
+
+#ifndef DRC_CLEARANCE_KERNELS_H
+#define DRC_CLEARANCE_KERNELS_H
+
+#include <vector>
+#include <wx/gdicmn.h>
+
+
+/**
+ * Class DRC_SEGMENT_BATCH
+ * holds a list of candidate segments as a structure of arrays, each one with
+ * the minimum distance it must keep from a reference segment.
+ *
+ * A segment of null length is a circle, therefore a via or a pad (using its
+ * bounding radius) is stored like a track segment, with its radius added to the
+ * minimum distance.
+ *
+ * TestSegment() computes the exact distance between the reference segment and
+ * all the candidates in one loop without branches, which the compiler can
+ * vectorize.  It is only a filter: the candidates it reports as possibly too
+ * close must be checked with the usual DRC functions, which give the error
+ * type and position.
+ */
+class DRC_SEGMENT_BATCH
+{
+public:
+
+    void Clear()
+    {
+        m_startX.clear();
+        m_startY.clear();
+        m_endX.clear();
+        m_endY.clear();
+        m_minDist.clear();
+    }
+
+    /**
+     * Function Add
+     * appends a candidate segment.
+     * @param aStart is the start point of the segment axis.
+     * @param aEnd is the end point of the segment axis (same as aStart for a circle).
+     * @param aMinDist is the minimum distance between the segment axis and the
+     *                 reference segment axis, i.e. the clearance plus the half
+     *                 widths of both segments.
+     */
+    void Add( const wxPoint& aStart, const wxPoint& aEnd, int aMinDist )
+    {
+        m_startX.push_back( aStart.x );
+        m_startY.push_back( aStart.y );
+        m_endX.push_back( aEnd.x );
+        m_endY.push_back( aEnd.y );
+        m_minDist.push_back( aMinDist );
+    }
+
+    int GetCount() const
+    {
+        return m_startX.size();
+    }
+
+    /**
+     * Function TestSegment
+     * finds the candidates which can be closer to the reference segment than
+     * their minimum distance.
+     * @param aRefStart is the start point of the reference segment axis.
+     * @param aRefEnd is the end point of the reference segment axis.
+     * @param aMargin is added to the minimum distances, to absorb the rounding
+     *                errors of the DRC functions working on integer coordinates.
+     * @param aMayCollide is filled with one value per candidate, in insertion order:
+     *                    0 if the candidate is certainly far enough, 1 otherwise.
+     */
+    void TestSegment( const wxPoint& aRefStart, const wxPoint& aRefEnd, int aMargin,
+                      std::vector<unsigned char>& aMayCollide ) const;
+
+private:
+    std::vector<double> m_startX;
+    std::vector<double> m_startY;
+    std::vector<double> m_endX;
+    std::vector<double> m_endY;
+    std::vector<double> m_minDist;
+};
+
+#endif  // DRC_CLEARANCE_KERNELS_H
@@ -47,6 +47,11 @@
 #include <polygon_test_point_inside.h>
 
 
+// Margin added to the minimum distances of the batched quick tests, to absorb
+// the rounding errors of the exact tests (which use rotated integer coordinates)
+static const int DRC_KERNEL_MARGIN = 10;
+
+
 /* compare 2 trapezoids (can be rectangle) and return true if distance > aDist
  * i.e if for each edge of the first polygon distance from each edge of the other polygon
  * is >= aDist
@@ -146,9 +151,97 @@ bool trapezoid2pointDRC( wxPoint aTref[4], wxPoint aPcompare, int aDist )
 }
 
 
+/* The pad and track lists tested by DRC::doTrackDrcCandidates().
+ * The board lists are walked in place: the interactive DRC (DRC::Drc(), called
+ * for each track edit) does not copy them for each tested segment.
+ */
+
+/**
+ * Struct DRC_PAD_VECTOR
+ * gives the pads found by a spatial query to DRC::doTrackDrcCandidates().
+ */
+struct DRC_PAD_VECTOR
+{
+    const std::vector<D_PAD*>& m_pads;
+
+    DRC_PAD_VECTOR( const std::vector<D_PAD*>& aPads ) : m_pads( aPads ) {}
+
+    unsigned size() const { return m_pads.size(); }
+    D_PAD* operator[]( unsigned aIdx ) const { return m_pads[aIdx]; }
+};
+
+
+/**
+ * Struct DRC_BOARD_PADS
+ * gives the board pad list to DRC::doTrackDrcCandidates(), or no pad if m_board
+ * is NULL.
+ */
+struct DRC_BOARD_PADS
+{
+    const BOARD* m_board;
+
+    DRC_BOARD_PADS( const BOARD* aBoard ) : m_board( aBoard ) {}
+
+    unsigned size() const { return m_board ? m_board->GetPadCount() : 0; }
+    D_PAD* operator[]( unsigned aIdx ) const { return m_board->GetPad( aIdx ); }
+};
+
+
+/**
+ * Struct DRC_TRACK_VECTOR
+ * gives the tracks found by a spatial query to DRC::doTrackDrcCandidates().
+ * Get() returns the track aIdx, which follows aPrevious, or NULL after the last one.
+ */
+struct DRC_TRACK_VECTOR
+{
+    const std::vector<TRACK*>& m_tracks;
+
+    DRC_TRACK_VECTOR( const std::vector<TRACK*>& aTracks ) : m_tracks( aTracks ) {}
+
+    TRACK* Get( unsigned aIdx, TRACK* aPrevious ) const
+    {
+        return aIdx < m_tracks.size() ? m_tracks[aIdx] : NULL;
+    }
+};
+
+
+/**
+ * Struct DRC_TRACK_LIST
+ * gives a linked list of tracks, from m_start to its end, to
+ * DRC::doTrackDrcCandidates().
+ */
+struct DRC_TRACK_LIST
+{
+    TRACK* m_start;
+
+    DRC_TRACK_LIST( TRACK* aStart ) : m_start( aStart ) {}
+
+    TRACK* Get( unsigned aIdx, TRACK* aPrevious ) const
+    {
+        return aPrevious ? aPrevious->Next() : m_start;
+    }
+};
+
+
 bool DRC::doTrackDrc( TRACK* aRefSeg, TRACK* aStart, bool testPads )
 {
-    TRACK*    track;
+    return doTrackDrcCandidates( aRefSeg, DRC_BOARD_PADS( testPads ? m_pcb : NULL ),
+                                 DRC_TRACK_LIST( aStart ) );
+}
+
+
+bool DRC::doTrackDrc( TRACK* aRefSeg, const std::vector<D_PAD*>& aPads,
+                      const std::vector<TRACK*>& aTracks )
+{
+    return doTrackDrcCandidates( aRefSeg, DRC_PAD_VECTOR( aPads ),
+                                 DRC_TRACK_VECTOR( aTracks ) );
+}
+
+
+template <class PADS, class TRACKS>
+bool DRC::doTrackDrcCandidates( TRACK* aRefSeg, const PADS& aPads, const TRACKS& aTracks )
+{
+    TRACK*    track = NULL;
     wxPoint   delta;           // lenght on X and Y axis of segments
     LSET layerMask;
     int       net_code_ref;
@@ -252,6 +345,59 @@ bool DRC::doTrackDrc( TRACK* aRefSeg, TRACK* aStart, bool testPads )
 
     m_segmLength = delta.x;
 
+    /* The exact tests below are slow (rotations, clipping).  Find at once the
+     * candidates which are certainly far enough from the reference segment,
+     * and skip them.
+     */
+    const int refHalfWidth = aRefSeg->GetWidth() / 2;
+
+    if( m_useClearanceKernels )
+    {
+        m_candidates.Clear();
+
+        for( unsigned ii = 0;  ii < aPads.size();  ++ii )
+        {
+            D_PAD*  pad = aPads[ii];
+            wxPoint shapePos = pad->ShapePos();
+
+            // The radius of a circle containing the pad shape and its hole
+            int holeRadius = KiROUND( EuclideanNorm( shapePos - pad->GetPosition() ) ) +
+                             std::max( pad->GetDrillSize().x, pad->GetDrillSize().y ) / 2;
+            int radius = std::max( pad->GetBoundingRadius(), holeRadius );
+
+            // Pads use their own clearance, and holes the reference segment clearance
+            int clearance = std::max( aRefSeg->GetClearance( pad ), netclass->GetClearance() );
+
+            m_candidates.Add( shapePos, shapePos, clearance + refHalfWidth + radius );
+        }
+
+        m_candidates.TestSegment( aRefSeg->GetStart(), aRefSeg->GetEnd(), DRC_KERNEL_MARGIN,
+                                  m_padMayCollide );
+
+        // Tracks have no local clearance: the biggest netclass clearance is
+        // never smaller than the clearance between 2 tracks
+        const int maxClearance = dsnSettings.GetBiggestClearanceValue();
+
+        m_candidates.Clear();
+
+        for( unsigned jj = 0;  ( track = aTracks.Get( jj, track ) ) != NULL;  ++jj )
+        {
+            m_candidates.Add( track->GetStart(), track->GetEnd(),
+                              maxClearance + refHalfWidth + track->GetWidth() / 2 );
+        }
+
+        m_candidates.TestSegment( aRefSeg->GetStart(), aRefSeg->GetEnd(), DRC_KERNEL_MARGIN,
+                                  m_trackMayCollide );
+    }
+    else
+    {
+        m_padMayCollide.assign( aPads.size(), 1 );
+        m_trackMayCollide.clear();
+
+        for( unsigned jj = 0;  ( track = aTracks.Get( jj, track ) ) != NULL;  ++jj )
+            m_trackMayCollide.push_back( 1 );
+    }
+
     /******************************************/
     /* Phase 1 : test DRC track to pads :     */
     /******************************************/
@@ -270,60 +416,60 @@ bool DRC::doTrackDrc( TRACK* aRefSeg, TRACK* aStart, bool testPads )
     dummypad.SetLayerSet( LSET::AllCuMask() );     // Ensure the hole is on all layers
 
     // Compute the min distance to pads
-    if( testPads )
+    for( unsigned ii = 0;  ii < aPads.size();  ++ii )
     {
-        for( unsigned ii = 0;  ii<m_pcb->GetPadCount();  ++ii )
-        {
-            D_PAD* pad = m_pcb->GetPad( ii );
+        D_PAD* pad = aPads[ii];
 
-            /* No problem if pads are on an other layer,
-             * But if a drill hole exists	(a pad on a single layer can have a hole!)
-             * we must test the hole
-             */
-            if( !( pad->GetLayerSet() & layerMask ).any() )
-            {
-                /* We must test the pad hole. In order to use the function
-                 * checkClearanceSegmToPad(),a pseudo pad is used, with a shape and a
-                 * size like the hole
-                 */
-                if( pad->GetDrillSize().x == 0 )
-                    continue;
-
-                dummypad.SetSize( pad->GetDrillSize() );
-                dummypad.SetPosition( pad->GetPosition() );
-                dummypad.SetShape( pad->GetDrillShape()  == PAD_DRILL_OBLONG ?
-                                   PAD_OVAL : PAD_CIRCLE );
-                dummypad.SetOrientation( pad->GetOrientation() );
-
-                m_padToTestPos = dummypad.GetPosition() - origin;
-
-                if( !checkClearanceSegmToPad( &dummypad, aRefSeg->GetWidth(),
-                                              netclass->GetClearance() ) )
-                {
-                    m_currentMarker = fillMarker( aRefSeg, pad,
-                                                  DRCE_TRACK_NEAR_THROUGH_HOLE, m_currentMarker );
-                    return false;
-                }
+        if( !m_padMayCollide[ii] )
+            continue;
 
+        /* No problem if pads are on an other layer,
+         * But if a drill hole exists	(a pad on a single layer can have a hole!)
+         * we must test the hole
+         */
+        if( !( pad->GetLayerSet() & layerMask ).any() )
+        {
+            /* We must test the pad hole. In order to use the function
+             * checkClearanceSegmToPad(),a pseudo pad is used, with a shape and a
+             * size like the hole
+             */
+            if( pad->GetDrillSize().x == 0 )
                 continue;
-            }
 
-            // The pad must be in a net (i.e pt_pad->GetNet() != 0 )
-            // but no problem if the pad netcode is the current netcode (same net)
-            if( pad->GetNetCode()                       // the pad must be connected
-               && net_code_ref == pad->GetNetCode() )   // the pad net is the same as current net -> Ok
-                continue;
+            dummypad.SetSize( pad->GetDrillSize() );
+            dummypad.SetPosition( pad->GetPosition() );
+            dummypad.SetShape( pad->GetDrillShape()  == PAD_DRILL_OBLONG ?
+                               PAD_OVAL : PAD_CIRCLE );
+            dummypad.SetOrientation( pad->GetOrientation() );
 
-            // DRC for the pad
-            shape_pos = pad->ShapePos();
-            m_padToTestPos = shape_pos - origin;
+            m_padToTestPos = dummypad.GetPosition() - origin;
 
-            if( !checkClearanceSegmToPad( pad, aRefSeg->GetWidth(), aRefSeg->GetClearance( pad ) ) )
+            if( !checkClearanceSegmToPad( &dummypad, aRefSeg->GetWidth(),
+                                          netclass->GetClearance() ) )
             {
                 m_currentMarker = fillMarker( aRefSeg, pad,
-                                              DRCE_TRACK_NEAR_PAD, m_currentMarker );
+                                              DRCE_TRACK_NEAR_THROUGH_HOLE, m_currentMarker );
                 return false;
             }
+
+            continue;
+        }
+
+        // The pad must be in a net (i.e pt_pad->GetNet() != 0 )
+        // but no problem if the pad netcode is the current netcode (same net)
+        if( pad->GetNetCode()                       // the pad must be connected
+           && net_code_ref == pad->GetNetCode() )   // the pad net is the same as current net -> Ok
+            continue;
+
+        // DRC for the pad
+        shape_pos = pad->ShapePos();
+        m_padToTestPos = shape_pos - origin;
+
+        if( !checkClearanceSegmToPad( pad, aRefSeg->GetWidth(), aRefSeg->GetClearance( pad ) ) )
+        {
+            m_currentMarker = fillMarker( aRefSeg, pad,
+                                          DRCE_TRACK_NEAR_PAD, m_currentMarker );
+            return false;
         }
     }
 
@@ -336,8 +482,13 @@ bool DRC::doTrackDrc( TRACK* aRefSeg, TRACK* aStart, bool testPads )
     // Test the reference segment with other track segments
     wxPoint segStartPoint;
     wxPoint segEndPoint;
-    for( track = aStart; track; track = track->Next() )
+    track = NULL;
+
+    for( unsigned jj = 0;  ( track = aTracks.Get( jj, track ) ) != NULL;  ++jj )
     {
+        if( !m_trackMayCollide[jj] )
+            continue;
+
         // No problem if segments have the same net code:
         if( net_code_ref == track->GetNetCode() )
             continue;
@@ -697,8 +848,8 @@ bool DRC::checkClearancePadToPad( D_PAD* aRefPad, D_PAD* aPad )
             {   // Use the trapezoid2trapezoidDRC which also compare 2 rectangles with any orientation
                 wxPoint polyref[4];         // Shape of aRefPad
                 wxPoint polycompare[4];     // Shape of aPad
-                aRefPad->BuildPadPolygon( polyref, wxSize( 0, 0 ), aRefPad->GetOrientation() );
-                aPad->BuildPadPolygon( polycompare, wxSize( 0, 0 ), aPad->GetOrientation() );
+                buildPadPolygon( aRefPad, polyref );
+                buildPadPolygon( aPad, polycompare );
 
                 // Move aPad shape to relativePadPos
                 for( int ii = 0; ii < 4; ii++ )
@@ -713,8 +864,8 @@ bool DRC::checkClearancePadToPad( D_PAD* aRefPad, D_PAD* aPad )
         {
             wxPoint polyref[4];         // Shape of aRefPad
             wxPoint polycompare[4];     // Shape of aPad
-            aRefPad->BuildPadPolygon( polyref, wxSize( 0, 0 ), aRefPad->GetOrientation() );
-            aPad->BuildPadPolygon( polycompare, wxSize( 0, 0 ), aPad->GetOrientation() );
+            buildPadPolygon( aRefPad, polyref );
+            buildPadPolygon( aPad, polycompare );
 
             // Move aPad shape to relativePadPos
             for( int ii = 0; ii < 4; ii++ )
@@ -784,8 +935,8 @@ bool DRC::checkClearancePadToPad( D_PAD* aRefPad, D_PAD* aPad )
         {
             wxPoint polyref[4];         // Shape of aRefPad
             wxPoint polycompare[4];     // Shape of aPad
-            aRefPad->BuildPadPolygon( polyref, wxSize( 0, 0 ), aRefPad->GetOrientation() );
-            aPad->BuildPadPolygon( polycompare, wxSize( 0, 0 ), aPad->GetOrientation() );
+            buildPadPolygon( aRefPad, polyref );
+            buildPadPolygon( aPad, polycompare );
 
             // Move aPad shape to relativePadPos
             for( int ii = 0; ii < 4; ii++ )
@@ -806,6 +957,25 @@ bool DRC::checkClearancePadToPad( D_PAD* aRefPad, D_PAD* aPad )
 }
 
 
+void DRC::buildPadPolygon( const D_PAD* aPad, wxPoint aCoord[4] )
+{
+    if( m_padPolygons )
+    {
+        DRC_PAD_POLYGON_CACHE::const_iterator it = m_padPolygons->find( aPad );
+
+        if( it != m_padPolygons->end() )
+        {
+            for( int ii = 0; ii < 4; ii++ )
+                aCoord[ii] = it->second.m_Corners[ii];
+
+            return;
+        }
+    }
+
+    aPad->BuildPadPolygon( aCoord, wxSize( 0, 0 ), aPad->GetOrientation() );
+}
+
+
 /* test if distance between a segment is > aMinDist
  * segment start point is assumed in (0,0) and  segment start point in m_segmEnd
  * and its orientation is m_segmAngle (m_segmAngle must be already initialized)
@@ -0,0 +1,257 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file drc_kernels_bench.cpp
+ * @brief Micro benchmark of the batched clearance test of DRC::doTrackDrc().
+ *
+ * Usage: drc_kernels_bench
+ *
+ * Random tracks and pads are tested against random reference segments by
+ * DRC::doTrackDrc(), given the same candidates as a R-tree query would do:
+ * - without DRC_SEGMENT_BATCH: the exact tests (checkClearanceSegmToPad(),
+ *   checkMarginToCircle(), checkLine()) are run on all the candidates;
+ * - with DRC_SEGMENT_BATCH: they are run only on the candidates it reports.
+ * Then each candidate is tested alone both ways: both must find the same pairs too
+ * close, otherwise the exit code is 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include <fctsys.h>
+#include <common.h>
+#include <class_board.h>
+#include <class_module.h>
+#include <class_pad.h>
+#include <class_track.h>
+#include <class_netinfo.h>
+#include <profile.h>
+
+#include <drc_stuff.h>
+#include <pcbnew_tool.h>
+
+#define REF_SEGMENTS    2000
+#define TRACKS          200     // candidates per reference segment, like a R-tree query result
+#define PADS            50
+#define AREA            5000000 // candidates are placed in a 5 mm square
+#define MAX_LENGTH      2000000
+
+
+/**
+ * Class DRC_KERNELS_BENCH
+ * runs DRC::doTrackDrc() with or without DRC_SEGMENT_BATCH (it is a friend of DRC).
+ */
+class DRC_KERNELS_BENCH
+{
+public:
+    DRC_KERNELS_BENCH( BOARD* aBoard ) : m_drc( aBoard ) {}
+
+    ~DRC_KERNELS_BENCH()
+    {
+        delete m_drc.m_currentMarker;
+    }
+
+    /**
+     * Function TestTrack
+     * @return true if aRefSeg is far enough from all the candidates.
+     */
+    bool TestTrack( TRACK* aRefSeg, const std::vector<D_PAD*>& aPads,
+                    const std::vector<TRACK*>& aTracks, bool aUseKernels )
+    {
+        m_drc.m_useClearanceKernels = aUseKernels;
+
+        return m_drc.doTrackDrc( aRefSeg, aPads, aTracks );
+    }
+
+    /**
+     * Function GetExactTestCount
+     * @return the number of candidates given to the exact tests by the last TestTrack().
+     */
+    int GetExactTestCount() const
+    {
+        int count = 0;
+
+        for( unsigned ii = 0; ii < m_drc.m_padMayCollide.size(); ++ii )
+            count += m_drc.m_padMayCollide[ii];
+
+        for( unsigned ii = 0; ii < m_drc.m_trackMayCollide.size(); ++ii )
+            count += m_drc.m_trackMayCollide[ii];
+
+        return count;
+    }
+
+private:
+    DRC m_drc;
+};
+
+
+static wxPoint randomPoint( const wxPoint& aCentre, int aRange )
+{
+    return wxPoint( aCentre.x + rand() % aRange - aRange / 2,
+                    aCentre.y + rand() % aRange - aRange / 2 );
+}
+
+
+static TRACK* newTrack( BOARD* aBoard, int aNetCode )
+{
+    wxPoint centre( AREA / 2, AREA / 2 );
+    TRACK*  track = new TRACK( aBoard );
+
+    track->SetLayer( F_Cu );
+    track->SetWidth( Millimeter2iu( 0.25 ) );
+    track->SetStart( randomPoint( centre, AREA ) );
+    track->SetEnd( randomPoint( track->GetStart(), MAX_LENGTH ) );
+    track->SetNetCode( aNetCode );
+    aBoard->Add( track, ADD_APPEND );
+
+    return track;
+}
+
+
+int main( int argc, char** argv )
+{
+    if( !InitPcbnewTool( argc, argv, "drc_kernels_bench" ) )
+        return 1;
+
+    // The reference segments are on net 1, the candidates on net 2
+    BOARD* board = new BOARD();
+
+    board->AppendNet( new NETINFO_ITEM( board, wxT( "REF" ), 1 ) );
+    board->AppendNet( new NETINFO_ITEM( board, wxT( "CANDIDATE" ), 2 ) );
+
+    srand( 1 );
+
+    std::vector<TRACK*> refSegments;
+    std::vector<TRACK*> tracks;
+    std::vector<D_PAD*> pads;
+
+    for( int ii = 0; ii < REF_SEGMENTS; ++ii )
+        refSegments.push_back( newTrack( board, 1 ) );
+
+    for( int ii = 0; ii < TRACKS; ++ii )
+        tracks.push_back( newTrack( board, 2 ) );
+
+    MODULE* module = new MODULE( board );
+
+    for( int ii = 0; ii < PADS; ++ii )
+    {
+        D_PAD*  pad = new D_PAD( module );
+        wxPoint pos = randomPoint( wxPoint( AREA / 2, AREA / 2 ), AREA );
+
+        pad->SetPos0( pos );
+        pad->SetPosition( pos );
+        pad->SetShape( ii % 2 ? PAD_RECT : PAD_CIRCLE );
+        pad->SetAttribute( PAD_STANDARD );
+        pad->SetLayerSet( D_PAD::StandardMask() );
+        pad->SetSize( wxSize( Millimeter2iu( 0.9 ), Millimeter2iu( 1.2 ) ) );
+        pad->SetDrillSize( wxSize( Millimeter2iu( 0.5 ), Millimeter2iu( 0.5 ) ) );
+        pad->SetOrientation( ( ii % 4 ) * 300 );
+        pad->SetNetCode( 2 );
+        module->Add( pad );
+        pads.push_back( pad );
+    }
+
+    board->Add( module, ADD_APPEND );
+
+    // As done after loading a board
+    board->BuildListOfNets();
+    board->SynchronizeNetsAndNetClasses();
+    board->GetDesignSettings().SetCurrentNetClass( NETCLASS::Default );
+
+    DRC_KERNELS_BENCH   bench( board );
+    prof_counter        counter;
+    double              pairs = (double) REF_SEGMENTS * ( TRACKS + PADS );
+    int                 exactErrors = 0;
+    int                 batchErrors = 0;
+    int                 batchExactTests = 0;
+
+    // All the candidates of each reference segment, both ways
+    prof_start( &counter );
+
+    for( int ii = 0; ii < REF_SEGMENTS; ++ii )
+    {
+        if( !bench.TestTrack( refSegments[ii], pads, tracks, false ) )
+            exactErrors++;
+    }
+
+    prof_end( &counter );
+
+    printf( "exact tests only:  %llu usecs, %.2f nsecs/pair, %d segments too close\n",
+            (unsigned long long) counter.usecs(), counter.usecs() * 1000.0 / pairs,
+            exactErrors );
+
+    prof_start( &counter );
+
+    for( int ii = 0; ii < REF_SEGMENTS; ++ii )
+    {
+        if( !bench.TestTrack( refSegments[ii], pads, tracks, true ) )
+            batchErrors++;
+
+        batchExactTests += bench.GetExactTestCount();
+    }
+
+    prof_end( &counter );
+
+    printf( "batched + exact:   %llu usecs, %.2f nsecs/pair, %d exact tests, "
+            "%d segments too close\n",
+            (unsigned long long) counter.usecs(), counter.usecs() * 1000.0 / pairs,
+            batchExactTests, batchErrors );
+
+    // Each pair alone: the batched test must not hide any pair too close
+    std::vector<D_PAD*> noPad, onePad( 1 );
+    std::vector<TRACK*> noTrack, oneTrack( 1 );
+    int                 tooClose = 0;
+    int                 missed = 0;
+
+    for( int ii = 0; ii < REF_SEGMENTS; ++ii )
+    {
+        for( int jj = 0; jj < PADS; ++jj )
+        {
+            onePad[0] = pads[jj];
+            bool exact = bench.TestTrack( refSegments[ii], onePad, noTrack, false );
+            bool batch = bench.TestTrack( refSegments[ii], onePad, noTrack, true );
+
+            tooClose += !exact;
+            missed += exact != batch;
+        }
+
+        for( int jj = 0; jj < TRACKS; ++jj )
+        {
+            oneTrack[0] = tracks[jj];
+            bool exact = bench.TestTrack( refSegments[ii], noPad, oneTrack, false );
+            bool batch = bench.TestTrack( refSegments[ii], noPad, oneTrack, true );
+
+            tooClose += !exact;
+            missed += exact != batch;
+        }
+    }
+
+    printf( "pairs too close: %d, found differently with the batched test: %d\n",
+            tooClose, missed );
+
+    delete board;
+
+    return missed || batchErrors != exactErrors ? 1 : 0;
+}
@@ -30,7 +30,14 @@
 #define _DRC_STUFF_H
 
 #include <vector>
+#include <set>
+#include <map>
+#include <stdint.h>
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <class_eda_rect.h>
+#include <drc_clearance_kernels.h>
 
 #define OK_DRC  0
 #define BAD_DRC 1
@@ -88,9 +95,13 @@ class BOARD;
 class D_PAD;
 class ZONE_CONTAINER;
 class TRACK;
+class TEXTE_PCB;
 class MARKER_PCB;
 class DRC_ITEM;
 class NETCLASS;
+class PICKED_ITEMS_LIST;
+template <class T> class BOARD_RTREE;
+struct prof_counter;
 
 
 /**
@@ -140,6 +151,84 @@ public:
 typedef std::vector<DRC_ITEM*> DRC_LIST;
 
 
+/**
+ * Struct DRC_PAD_POLYGON
+ * is the shape of a rectangular or trapezoidal pad, as built by
+ * D_PAD::BuildPadPolygon() with its own orientation, relative to its shape position.
+ */
+struct DRC_PAD_POLYGON
+{
+    wxPoint m_Corners[4];
+};
+
+typedef boost::unordered_map<const D_PAD*, DRC_PAD_POLYGON> DRC_PAD_POLYGON_CACHE;
+
+
+/**
+ * Class DRC_TEXT_SHAPE
+ * is the stroke shape of a text on a copper layer, as built by
+ * EDA_TEXT::TransformTextShapeToSegmentList(), with the text parameters it was
+ * built from.  The DRC keeps the shapes from one run to the next one, and a shape
+ * is built again only when its text has changed.
+ */
+class DRC_TEXT_SHAPE
+{
+public:
+    DRC_TEXT_SHAPE() :
+        m_thickness( 0 ), m_orient( 0.0 ), m_hJustify( 0 ), m_vJustify( 0 ),
+        m_italic( false ), m_bold( false ), m_mirror( false ), m_multiline( false )
+    {}
+
+    /**
+     * Function IsUpToDate
+     * @return true if the shape was built from aText in its current state.
+     */
+    bool IsUpToDate( const TEXTE_PCB* aText ) const;
+
+    /**
+     * Function Build
+     * builds the segments of the shape of aText, and stores its parameters.
+     * Not thread safe (TransformTextShapeToSegmentList() uses a static buffer).
+     */
+    void Build( const TEXTE_PCB* aText );
+
+    ///> The segments of the shape, as pairs of points
+    const std::vector<wxPoint>& GetSegments() const { return m_segments; }
+
+    ///> The bounding box of the segment axes (the text thickness is not included)
+    const EDA_RECT& GetBoundingBox() const          { return m_bbox; }
+
+private:
+    wxString                m_text;
+    wxPoint                 m_pos;
+    wxSize                  m_size;
+    int                     m_thickness;
+    double                  m_orient;
+    int                     m_hJustify;
+    int                     m_vJustify;
+    bool                    m_italic;
+    bool                    m_bold;
+    bool                    m_mirror;
+    bool                    m_multiline;
+
+    std::vector<wxPoint>    m_segments;
+    EDA_RECT                m_bbox;
+};
+
+typedef boost::unordered_map<const TEXTE_PCB*, DRC_TEXT_SHAPE> DRC_TEXT_SHAPE_CACHE;
+
+
+/**
+ * Struct DRC_PHASE_TIME
+ * is the wall time taken by one phase (a group of tests) of a DRC run.
+ */
+struct DRC_PHASE_TIME
+{
+    wxString    m_Name;     ///< phase identifier, like "track_clearances"
+    uint64_t    m_Usecs;    ///< wall time in microseconds
+};
+
+
 /**
  * Class DRC
  * is the Design Rule Checker, and performs all the DRC tests.  The output of
@@ -152,6 +241,7 @@ typedef std::vector<DRC_ITEM*> DRC_LIST;
 class DRC
 {
     friend class DIALOG_DRC_CONTROL;
+    friend class DRC_KERNELS_BENCH;
 
 private:
 
@@ -199,6 +289,56 @@ private:
 
     DRC_LIST            m_unconnected;  ///< list of unconnected pads, as DRC_ITEMs
 
+    std::vector<DRC_PHASE_TIME> m_phaseTimes;   ///< wall times of the last run phases
+
+    /* Incremental DRC data.
+     * The items changed since the last run are given by the undo/redo commands.
+     * A rerun only tests the pads, tracks and texts close to these items, and keeps the
+     * markers created for the other ones by a previous run.
+     */
+    bool                    m_fullDrcNeeded;    ///< true when all items must be tested
+    BOARD*                  m_lastTestedPcb;    ///< the board of the last run
+    std::set<BOARD_ITEM*>   m_dirtyItems;       ///< items changed since the last run
+    std::vector<EDA_RECT>   m_dirtyAreas;       ///< areas of these items before their change
+
+    ///< The markers created by the pad, track and text tests, by reference item
+    std::multimap<BOARD_ITEM*, MARKER_PCB*> m_markerOwners;
+
+    ///< When not NULL, only the items inside these areas are tested (incremental run)
+    BOARD_RTREE<int>*       m_areasToTest;
+
+    ///< When not NULL, the polygons of the pads tested by testPad2Pad()
+    const DRC_PAD_POLYGON_CACHE* m_padPolygons;
+
+    /* Buffers of doTrackDrc(), kept to avoid an allocation for each tested segment:
+     * the candidates, and the result of their quick distance test
+     */
+    DRC_SEGMENT_BATCH           m_candidates;
+    std::vector<unsigned char>  m_padMayCollide;
+    std::vector<unsigned char>  m_trackMayCollide;
+
+    ///< When false, doTrackDrc() runs the exact tests on all the candidates, without
+    ///< DRC_SEGMENT_BATCH (only used by drc_kernels_bench to compare both ways)
+    bool                        m_useClearanceKernels;
+
+    ///< The stroke shapes of the copper texts, kept from one run to the next one
+    DRC_TEXT_SHAPE_CACHE        m_textShapes;
+
+
+    /**
+     * Constructor DRC
+     * creates a worker sharing the board, the frame and the settings of aDrc.
+     * Workers are used by the parallel tests: each thread needs its own copy of the
+     * intermediate values (m_segmAngle, m_xcliplo ...) used by the single tests.
+     * A worker does not own the dialog nor the list of unconnected items.
+     */
+    DRC( const DRC& aDrc );
+
+    /**
+     * Function init
+     * sets the default settings, common to all the constructors.
+     */
+    void init();
 
     /**
      * Function updatePointers
@@ -207,6 +347,60 @@ private:
      */
     void updatePointers();
 
+    /**
+     * Function addMarkerToPcb
+     * adds a DRC marker to the PCB and to the GAL view.
+     * Must be called from the main thread only.
+     * @param aMarker is the marker to add.
+     */
+    void addMarkerToPcb( MARKER_PCB* aMarker );
+
+    /**
+     * Function addMarkerToPcb
+     * adds a DRC marker created by the test of aOwner to the PCB and to the GAL view.
+     * The marker will be kept by an incremental run if aOwner is not changed.
+     */
+    void addMarkerToPcb( MARKER_PCB* aMarker, BOARD_ITEM* aOwner );
+
+    /**
+     * Function removeMarkerFromPcb
+     * removes a DRC marker from the PCB and from the GAL view, and deletes it.
+     */
+    void removeMarkerFromPcb( MARKER_PCB* aMarker );
+
+    /**
+     * Function isAreaToTest
+     * @return true if an item covering aArea must be tested by the current run:
+     * always during a full run, and only if aArea is near a changed item
+     * during an incremental run.
+     */
+    bool isAreaToTest( const EDA_RECT& aArea );
+
+    /**
+     * Function clearIncrementalData
+     * forgets the changed items, once all of them are tested.
+     */
+    void clearIncrementalData();
+
+    /**
+     * Function runTests
+     * runs all the tests. This is the common part of RunTests() and RunIncrementalTests().
+     * @return false if the tests were aborted because of netclass errors.
+     */
+    bool runTests( wxTextCtrl* aMessages );
+
+    /**
+     * Function addPhaseTime
+     * records the wall time of a phase of the current run.
+     */
+    void addPhaseTime( const wxString& aName, const prof_counter& aCounter );
+
+    /**
+     * Function fillAllZones
+     * refills all the zones of the board when there is no main window to do it.
+     */
+    void fillAllZones();
+
 
     /**
      * Function fillMarker
@@ -270,22 +464,56 @@ private:
     /**
      * Function testTracks
      * performs the DRC on all tracks.
+     * Each segment is only compared to the pads and to the following segments
+     * found near it by a per layer R-tree query, which gives the same markers
+     * as comparing it to the whole track list.
      * because this test can take a while, a progress bar can be displayed
      * @param aShowProgressBar = true to show a progrsse bar
      * (Note: it is shown only if there are many tracks)
      */
     void testTracks( bool aShowProgressBar );
 
+    /**
+     * Function testPad2Pad
+     * performs the DRC between pads.
+     * Each pad is only compared to the following pads (in X then Y order)
+     * whose clearance area intersects its own clearance area, found by an R-tree
+     * query, so the per pad size and clearance are used instead of the board
+     * biggest pad size.
+     */
     void testPad2Pad();
 
     void testUnconnected();
 
+    /**
+     * Function testUnconnectedItems
+     * gathers the unconnected items from the connectivity data of the board (RN_DATA).
+     * Used instead of testUnconnected() when there is no main window to build the
+     * board ratsnest.
+     */
+    void testUnconnectedItems();
+
     void testZones();
 
     void testKeepoutAreas();
 
     void testTexts();
 
+    /**
+     * Function doTextDrc
+     * tests the clearance between a text on a copper layer and the tracks, vias
+     * and pads of this layer.
+     * @param aText The text to test
+     * @param aTextShape The segments of the text shape, as built by
+     *                   TransformTextShapeToSegmentList()
+     * @param aTracks The tracks and vias to test, usually the ones found near the text
+     * @param aPads The pads to test, usually the ones found near the text
+     * @param aMarkers The list where the created markers are stored
+     */
+    void doTextDrc( TEXTE_PCB* aText, const std::vector<wxPoint>& aTextShape,
+                    const std::vector<TRACK*>& aTracks, const std::vector<D_PAD*>& aPads,
+                    std::vector<MARKER_PCB*>& aMarkers );
+
     //-----<single "item" tests>-----------------------------------------
 
     bool doNetClass( boost::shared_ptr<NETCLASS> aNetClass, wxString& msg );
@@ -293,13 +521,11 @@ private:
     /**
      * Function doPadToPadsDrc
      * tests the clearance between aRefPad and other pads.
-     * The pad list must be sorted by x coordinate.
      * @param aRefPad The pad to test
-     * @param aStart The start of the pad list to test against
-     * @param aEnd Marks the end of the list and is not included
-     * @param x_limit is used to stop the test (when the any pad's X coord exceeds this)
+     * @param aPads The pads to test against, usually the pads found near aRefPad.
+     *              The test stops at the first error, in list order.
      */
-    bool doPadToPadsDrc( D_PAD* aRefPad, D_PAD** aStart, D_PAD** aEnd, int x_limit );
+    bool doPadToPadsDrc( D_PAD* aRefPad, const std::vector<D_PAD*>& aPads );
 
     /**
      * Function DoTrackDrc
@@ -312,6 +538,28 @@ private:
      */
     bool doTrackDrc( TRACK* aRefSeg, TRACK* aStart, bool doPads = true );
 
+    /**
+     * Function doTrackDrc
+     * tests the current segment against a given set of candidates, usually the
+     * result of a spatial query around aRefSeg.
+     * @param aRefSeg The segment to test
+     * @param aPads The pads to test against, in board pad list order
+     * @param aTracks The tracks and vias to test against, in board track list order
+     * @return bool - true if no poblems, else false and m_currentMarker is
+     *          filled in with the problem information.
+     */
+    bool doTrackDrc( TRACK* aRefSeg, const std::vector<D_PAD*>& aPads,
+                     const std::vector<TRACK*>& aTracks );
+
+    /**
+     * Function doTrackDrcCandidates
+     * the tests of both doTrackDrc() functions.
+     * @param aPads The pads to test against: size() and operator[]
+     * @param aTracks The tracks to test against: Get( index, previous track )
+     */
+    template <class PADS, class TRACKS>
+    bool doTrackDrcCandidates( TRACK* aRefSeg, const PADS& aPads, const TRACKS& aTracks );
+
     /**
      * Function doTrackKeepoutDrc
      * tests the current segment or via.
@@ -343,6 +591,15 @@ private:
      */
     bool checkClearancePadToPad( D_PAD* aRefPad, D_PAD* aPad );
 
+    /**
+     * Function buildPadPolygon
+     * gives the corners of a rectangular or trapezoidal pad, relative to its shape
+     * position, from m_padPolygons when the pad is found there.
+     * @param aPad The pad
+     * @param aCoord The buffer to fill with the 4 corners
+     */
+    void buildPadPolygon( const D_PAD* aPad, wxPoint aCoord[4] );
+
 
     /**
      * Function checkClearanceSegmToPad
@@ -392,6 +649,15 @@ private:
 public:
     DRC( PCB_EDIT_FRAME* aPcbWindow );
 
+    /**
+     * Constructor DRC
+     * creates a DRC without any UI, used to run the tests of a board loaded
+     * outside of the board editor, for instance from the command line.
+     * Markers are added to aPcb only, and the unconnected items are found
+     * with the board connectivity data.
+     */
+    DRC( BOARD* aPcb );
+
     ~DRC();
 
     /**
@@ -483,6 +749,44 @@ public:
      */
     void RunTests( wxTextCtrl* aMessages = NULL );
 
+    /**
+     * Function RunIncrementalTests
+     * runs all the tests like RunTests(), but the pad, track and text clearances
+     * are only tested for the items close to the items changed since the last run.
+     * The markers of the other items, created by the last run, are kept.
+     * When an incremental run is not possible (see CanRunIncrementalTests()),
+     * all the markers are removed and all the items are tested.
+     * @param aMessages = a wxTextControl where to display some activity messages. Can be NULL
+     */
+    void RunIncrementalTests( wxTextCtrl* aMessages = NULL );
+
+    /**
+     * Function CanRunIncrementalTests
+     * @return true if a previous run can be used by RunIncrementalTests().
+     */
+    bool CanRunIncrementalTests();
+
+    /**
+     * Function MarkItemsDirty
+     * records the items of an undo/redo command as changed since the last run.
+     * Must be called before the items are changed, to remember their previous area.
+     */
+    void MarkItemsDirty( const PICKED_ITEMS_LIST& aList );
+
+    /**
+     * Function MarkItemDirty
+     * records aItem as changed since the last run.
+     * Must be called before aItem is changed, to remember its previous area.
+     */
+    void MarkItemDirty( BOARD_ITEM* aItem );
+
+    /**
+     * Function SetFullDrcNeeded
+     * tells the next run must test all the items, after changes not recorded
+     * by MarkItemDirty(), like a board reload or a design rules change.
+     */
+    void SetFullDrcNeeded() { m_fullDrcNeeded = true; }
+
     /**
      * Function ListUnconnectedPad
      * gathers a list of all the unconnected pads and shows them in the
@@ -490,6 +794,24 @@ public:
      */
     void ListUnconnectedPads();
 
+    /**
+     * Function GetUnconnectedItems
+     * @return the list of unconnected items found by the last run.
+     */
+    const DRC_LIST& GetUnconnectedItems() const
+    {
+        return m_unconnected;
+    }
+
+    /**
+     * Function GetPhaseTimes
+     * @return the wall times of the phases of the last run, in run order.
+     */
+    const std::vector<DRC_PHASE_TIME>& GetPhaseTimes() const
+    {
+        return m_phaseTimes;
+    }
+
     /**
      * @return a pointer to the current marker (last created marker
      */
@@ -1567,6 +1567,12 @@ void PCB_IO::format( ZONE_CONTAINER* aZone, int aNestLevel ) const
                           FMT_IU( aZone->GetCornerRadius() ).c_str() );
     }
 
+    // Hash of the fill inputs, allowing to skip the refill of unchanged zones.
+    if( aZone->IsFilled() && aZone->GetFillHash() )
+        m_out->Print( 0, " (hash %08x%08x)",
+                      (unsigned) ( aZone->GetFillHash() >> 32 ),
+                      (unsigned) ( aZone->GetFillHash() & 0xFFFFFFFF ) );
+
     m_out->Print( 0, ")\n" );
 
     const CPOLYGONS_LIST& cv = aZone->Outline()->m_CornersList;
@@ -45,6 +45,7 @@
 #include <class_board.h>
 #include <class_module.h>
 #include <ratsnest_data.h>
+#include <drc_stuff.h>
 #include <pcbnew.h>
 #include <io_mgr.h>
 
@@ -121,6 +122,9 @@ void PCB_EDIT_FRAME::ReadPcbNetlist( const wxString& aNetlistFileName,
 
     OnModify();
 
+    // Nets and footprints can have changed without undo commands
+    m_drc->SetFullDrcNeeded();
+
     SetCurItem( NULL );
 
     // Reload modules
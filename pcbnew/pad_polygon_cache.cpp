@@ -0,0 +1,180 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file pad_polygon_cache.cpp
+ */
+
+#include <algorithm>
+
+#include <fctsys.h>
+
+#include <class_pad.h>
+
+#include <pad_polygon_cache.h>
+
+extern void CreateThermalReliefPadPolygon( CPOLYGONS_LIST& aCornerBuffer,
+                                           D_PAD&                aPad,
+                                           int                   aThermalGap,
+                                           int                   aCopperThickness,
+                                           int                   aMinThicknessValue,
+                                           int                   aCircleToSegmentsCount,
+                                           double                aCorrectionFactor,
+                                           double                aThermalRot );
+
+
+/**
+ * Function appendMoved
+ * appends the polygons of aShape to aCornerBuffer, moved by aOffset.
+ */
+static void appendMoved( CPOLYGONS_LIST& aCornerBuffer, const CPOLYGONS_LIST& aShape,
+                         const wxPoint& aOffset )
+{
+    aCornerBuffer.reserve( aCornerBuffer.GetCornersCount() + aShape.GetCornersCount() );
+
+    for( unsigned ii = 0; ii < aShape.GetCornersCount(); ii++ )
+    {
+        CPolyPt corner = aShape.GetCorner( ii );
+        corner.x += aOffset.x;
+        corner.y += aOffset.y;
+        aCornerBuffer.Append( corner );
+    }
+}
+
+
+PAD_POLYGON_CACHE::KEY::KEY( bool aThermal, const D_PAD& aPad, int aGap,
+                             int aCopperThickness, int aMinThicknessValue,
+                             int aCircleToSegmentsCount, double aCorrectionFactor,
+                             double aThermalRot )
+{
+    // The offset does not change the shape around the shape position, but the pad
+    // bounding box used to build the thermal reliefs of trapezoidal pads depends on it
+    int* ints = m_ints;
+    *ints++ = aThermal;
+    *ints++ = aPad.GetShape();
+    *ints++ = aPad.GetSize().x;
+    *ints++ = aPad.GetSize().y;
+    *ints++ = aPad.GetDelta().x;
+    *ints++ = aPad.GetDelta().y;
+    *ints++ = aPad.GetOffset().x;
+    *ints++ = aPad.GetOffset().y;
+    *ints++ = aGap;
+    *ints++ = aCopperThickness;
+    *ints++ = aMinThicknessValue;
+    *ints++ = aCircleToSegmentsCount;
+
+    m_doubles[0] = aPad.GetOrientation();
+    m_doubles[1] = aCorrectionFactor;
+    m_doubles[2] = aThermalRot;
+}
+
+
+bool PAD_POLYGON_CACHE::KEY::operator<( const KEY& aOther ) const
+{
+    for( int ii = 0; ii < INT_COUNT; ii++ )
+    {
+        if( m_ints[ii] != aOther.m_ints[ii] )
+            return m_ints[ii] < aOther.m_ints[ii];
+    }
+
+    return std::lexicographical_compare( m_doubles, m_doubles + DOUBLE_COUNT,
+                                         aOther.m_doubles, aOther.m_doubles + DOUBLE_COUNT );
+}
+
+
+const CPOLYGONS_LIST* PAD_POLYGON_CACHE::find( const KEY& aKey )
+{
+    MUTLOCK lock( m_lock );
+
+    SHAPE_MAP::const_iterator it = m_shapes.find( aKey );
+
+    return it == m_shapes.end() ? NULL : &it->second;
+}
+
+
+const CPOLYGONS_LIST* PAD_POLYGON_CACHE::store( const KEY& aKey, const CPOLYGONS_LIST& aShape,
+                                                const wxPoint& aOrigin )
+{
+    CPOLYGONS_LIST shape;
+    appendMoved( shape, aShape, wxPoint( -aOrigin.x, -aOrigin.y ) );
+
+    MUTLOCK lock( m_lock );
+
+    // Stored polygons are never modified, so they can be read without lock
+    return &m_shapes.insert( std::make_pair( aKey, shape ) ).first->second;
+}
+
+
+void PAD_POLYGON_CACHE::TransformPadShapeWithClearanceToPolygon( CPOLYGONS_LIST& aCornerBuffer,
+                                                                 const D_PAD& aPad,
+                                                                 int aClearanceValue,
+                                                                 int aCircleToSegmentsCount,
+                                                                 double aCorrectionFactor )
+{
+    KEY key( false, aPad, aClearanceValue, 0, 0, aCircleToSegmentsCount, aCorrectionFactor, 0 );
+    const CPOLYGONS_LIST* shape = find( key );
+
+    if( !shape )
+    {
+        CPOLYGONS_LIST buffer;
+        aPad.TransformShapeWithClearanceToPolygon( buffer, aClearanceValue,
+                                                   aCircleToSegmentsCount, aCorrectionFactor );
+        shape = store( key, buffer, aPad.ShapePos() );
+    }
+
+    appendMoved( aCornerBuffer, *shape, aPad.ShapePos() );
+}
+
+
+void PAD_POLYGON_CACHE::CreateThermalReliefPadPolygon( CPOLYGONS_LIST& aCornerBuffer,
+                                                       D_PAD& aPad,
+                                                       int aThermalGap,
+                                                       int aCopperThickness,
+                                                       int aMinThicknessValue,
+                                                       int aCircleToSegmentsCount,
+                                                       double aCorrectionFactor,
+                                                       double aThermalRot )
+{
+    KEY key( true, aPad, aThermalGap, aCopperThickness, aMinThicknessValue,
+             aCircleToSegmentsCount, aCorrectionFactor, aThermalRot );
+    const CPOLYGONS_LIST* shape = find( key );
+
+    if( !shape )
+    {
+        CPOLYGONS_LIST buffer;
+        ::CreateThermalReliefPadPolygon( buffer, aPad, aThermalGap, aCopperThickness,
+                                         aMinThicknessValue, aCircleToSegmentsCount,
+                                         aCorrectionFactor, aThermalRot );
+        shape = store( key, buffer, aPad.ShapePos() );
+    }
+
+    appendMoved( aCornerBuffer, *shape, aPad.ShapePos() );
+}
+
+
+void PAD_POLYGON_CACHE::Clear()
+{
+    MUTLOCK lock( m_lock );
+
+    m_shapes.clear();
+}
@@ -0,0 +1,121 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file pad_polygon_cache.h
+ * @brief Cache of the pad clearance and thermal relief polygons used to fill zones.
+ */
+
+#ifndef PAD_POLYGON_CACHE_H
+#define PAD_POLYGON_CACHE_H
+
+#include <map>
+
+#include <PolyLine.h>
+#include <ki_mutex.h>
+
+class D_PAD;
+
+
+/**
+ * Class PAD_POLYGON_CACHE
+ * stores the clearance and thermal relief polygons of pads, built around the pad
+ * shape position, and copies them moved to the position of the next pads having the
+ * same shape, size, orientation and clearance (for instance the pads of a BGA).
+ *
+ * The polygons are the ones of D_PAD::TransformShapeWithClearanceToPolygon() and
+ * CreateThermalReliefPadPolygon(). They only depend on the pad shape and parameters,
+ * not on the pad position.
+ *
+ * The cache can be used by several threads.
+ */
+class PAD_POLYGON_CACHE
+{
+public:
+    /**
+     * Function TransformPadShapeWithClearanceToPolygon
+     * same as D_PAD::TransformShapeWithClearanceToPolygon(), using the cache.
+     */
+    void TransformPadShapeWithClearanceToPolygon( CPOLYGONS_LIST& aCornerBuffer,
+                                                  const D_PAD& aPad,
+                                                  int aClearanceValue,
+                                                  int aCircleToSegmentsCount,
+                                                  double aCorrectionFactor );
+
+    /**
+     * Function CreateThermalReliefPadPolygon
+     * same as the global CreateThermalReliefPadPolygon(), using the cache.
+     */
+    void CreateThermalReliefPadPolygon( CPOLYGONS_LIST& aCornerBuffer,
+                                        D_PAD& aPad,
+                                        int aThermalGap,
+                                        int aCopperThickness,
+                                        int aMinThicknessValue,
+                                        int aCircleToSegmentsCount,
+                                        double aCorrectionFactor,
+                                        double aThermalRot );
+
+    /**
+     * Function Clear
+     * removes all the stored polygons.
+     */
+    void Clear();
+
+private:
+    ///> Everything a polygon depends on, except the pad position.
+    struct KEY
+    {
+        enum { INT_COUNT = 12, DOUBLE_COUNT = 3 };
+
+        int     m_ints[INT_COUNT];
+        double  m_doubles[DOUBLE_COUNT];
+
+        KEY( bool aThermal, const D_PAD& aPad, int aGap, int aCopperThickness,
+             int aMinThicknessValue, int aCircleToSegmentsCount,
+             double aCorrectionFactor, double aThermalRot );
+
+        bool operator<( const KEY& aOther ) const;
+    };
+
+    typedef std::map<KEY, CPOLYGONS_LIST> SHAPE_MAP;
+
+    /**
+     * Function find
+     * @return the polygons stored for aKey, or NULL.
+     */
+    const CPOLYGONS_LIST* find( const KEY& aKey );
+
+    /**
+     * Function store
+     * stores the polygons built for aKey, moved to be relative to aOrigin, unless
+     * another thread stored them first.
+     * @return the polygons stored for aKey.
+     */
+    const CPOLYGONS_LIST* store( const KEY& aKey, const CPOLYGONS_LIST& aShape,
+                                 const wxPoint& aOrigin );
+
+    SHAPE_MAP   m_shapes;
+    MUTEX       m_lock;
+};
+
+#endif  // PAD_POLYGON_CACHE_H
@@ -2711,9 +2711,15 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER() throw( IO_ERROR, PARSE_ERROR )
                     NeedRIGHT();
                     break;
 
+                case T_hash:
+                    NextTok();
+                    zone->SetFillHash( strtoull( CurText(), NULL, 16 ) );
+                    NeedRIGHT();
+                    break;
+
                 default:
                     Expecting( "mode, arc_segments, thermal_gap, thermal_bridge_width, "
-                               "smoothing, or radius" );
+                               "smoothing, radius, or hash" );
                 }
             }
             break;
@@ -320,6 +320,7 @@ PCB_EDIT_FRAME::PCB_EDIT_FRAME( KIWAY* aKiway, wxWindow* aParent ) :
     m_hasAutoSave = true;
     m_RecordingMacros = -1;
     m_microWaveToolBar = NULL;
+    m_drc = NULL;
 
     m_rotationAngle = 900;
 
@@ -471,6 +472,10 @@ void PCB_EDIT_FRAME::SetBoard( BOARD* aBoard )
 
     PCB_BASE_FRAME::SetBoard( aBoard );
 
+    // The results of the last DRC cannot be used for a new board
+    if( m_drc )
+        m_drc->SetFullDrcNeeded();
+
     if( IsGalCanvasActive() )
     {
         PCB_DRAW_PANEL_GAL* drawPanel = static_cast<PCB_DRAW_PANEL_GAL*>( GetGalCanvas() );
@@ -745,6 +750,7 @@ void PCB_EDIT_FRAME::ShowDesignRulesEditor( wxCommandEvent& event )
 
     if( returncode == wxID_OK )     // New rules, or others changes.
     {
+        m_drc->SetFullDrcNeeded();
         ReCreateLayerBox();
         ReCreateAuxiliaryToolbar();
         OnModify();
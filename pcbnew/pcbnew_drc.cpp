@@ -0,0 +1,310 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file pcbnew_drc.cpp
+ * @brief Command line tool running the design rules check on a board file.
+ *
+ * Usage: pcbnew_drc [-f text|json] [-o report_file] [--no-unconnected] board_file
+ *
+ * The report lists the DRC markers, the unconnected items and the wall time
+ * of each phase of the run (board loading included).
+ * The exit code is 0 if the board has no error, 1 if errors were found and
+ * 2 if the tests could not be run.
+ */
+
+#include <fctsys.h>
+#include <wx/cmdline.h>
+#include <wx/datetime.h>
+
+#include <common.h>
+#include <macros.h>
+#include <convert_to_biu.h>
+#include <io_mgr.h>
+#include <class_board.h>
+#include <class_marker_pcb.h>
+#include <class_drc_item.h>
+#include <profile.h>
+
+#include <drc_stuff.h>
+#include <pcbnew_tool.h>
+
+
+enum DRC_EXIT_CODE
+{
+    DRC_EXIT_OK     = 0,    ///< no DRC error
+    DRC_EXIT_ERRORS = 1,    ///< DRC errors or unconnected items found
+    DRC_EXIT_FAILED = 2     ///< bad command line, or the board cannot be loaded
+};
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    { wxCMD_LINE_OPTION, "f", "format", "report format: text (default) or json",
+      wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_OPTION, "o", "output", "report file name (default: standard output)",
+      wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_SWITCH, NULL, "no-unconnected", "do not list unconnected items",
+      wxCMD_LINE_VAL_NONE, 0 },
+    { wxCMD_LINE_PARAM, NULL, NULL, "board file (.kicad_pcb or .brd)",
+      wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_NONE }
+};
+
+
+/**
+ * Function jsonString
+ * @return aText as a quoted and escaped JSON string.
+ */
+static std::string jsonString( const wxString& aText )
+{
+    std::string utf8 = TO_UTF8( aText );
+    std::string ret = "\"";
+
+    for( unsigned ii = 0; ii < utf8.size(); ++ii )
+    {
+        char c = utf8[ii];
+
+        switch( c )
+        {
+        case '"':   ret += "\\\"";  break;
+        case '\\':  ret += "\\\\";  break;
+        case '\n':  ret += "\\n";   break;
+        case '\r':  ret += "\\r";   break;
+        case '\t':  ret += "\\t";   break;
+
+        default:
+            if( (unsigned char) c < 0x20 )
+            {
+                char buf[8];
+                sprintf( buf, "\\u%04x", c );
+                ret += buf;
+            }
+            else
+            {
+                ret += c;
+            }
+        }
+    }
+
+    return ret + "\"";
+}
+
+
+static void writeJsonItem( FILE* aFile, const DRC_ITEM& aItem, bool aLast )
+{
+    fprintf( aFile, "    { \"code\": %d, \"description\": %s, \"items\": [\n",
+             aItem.GetErrorCode(), jsonString( aItem.GetErrorText() ).c_str() );
+
+    fprintf( aFile, "        { \"text\": %s, \"x_mm\": %.6f, \"y_mm\": %.6f }%s\n",
+             jsonString( aItem.GetTextA() ).c_str(),
+             aItem.GetPointA().x / IU_PER_MM, aItem.GetPointA().y / IU_PER_MM,
+             aItem.HasSecondItem() ? "," : "" );
+
+    if( aItem.HasSecondItem() )
+    {
+        fprintf( aFile, "        { \"text\": %s, \"x_mm\": %.6f, \"y_mm\": %.6f }\n",
+                 jsonString( aItem.GetTextB() ).c_str(),
+                 aItem.GetPointB().x / IU_PER_MM, aItem.GetPointB().y / IU_PER_MM );
+    }
+
+    fprintf( aFile, "    ] }%s\n", aLast ? "" : "," );
+}
+
+
+static void writeJsonReport( FILE* aFile, BOARD* aBoard, const DRC& aDrc,
+                             const std::vector<DRC_PHASE_TIME>& aPhases )
+{
+    int count = aBoard->GetMARKERCount();
+
+    fprintf( aFile, "{\n" );
+    fprintf( aFile, "  \"board\": %s,\n", jsonString( aBoard->GetFileName() ).c_str() );
+
+    fprintf( aFile, "  \"markers\": [\n" );
+
+    for( int ii = 0; ii < count; ++ii )
+        writeJsonItem( aFile, aBoard->GetMARKER( ii )->GetReporter(), ii == count - 1 );
+
+    fprintf( aFile, "  ],\n" );
+
+    const DRC_LIST& unconnected = aDrc.GetUnconnectedItems();
+
+    fprintf( aFile, "  \"unconnected\": [\n" );
+
+    for( unsigned ii = 0; ii < unconnected.size(); ++ii )
+        writeJsonItem( aFile, *unconnected[ii], ii == unconnected.size() - 1 );
+
+    fprintf( aFile, "  ],\n" );
+
+    uint64_t total = 0;
+
+    fprintf( aFile, "  \"phases\": [\n" );
+
+    for( unsigned ii = 0; ii < aPhases.size(); ++ii )
+    {
+        fprintf( aFile, "    { \"name\": %s, \"ms\": %.3f }%s\n",
+                 jsonString( aPhases[ii].m_Name ).c_str(), aPhases[ii].m_Usecs / 1000.0,
+                 ii == aPhases.size() - 1 ? "" : "," );
+        total += aPhases[ii].m_Usecs;
+    }
+
+    fprintf( aFile, "  ],\n" );
+    fprintf( aFile, "  \"total_ms\": %.3f\n", total / 1000.0 );
+    fprintf( aFile, "}\n" );
+}
+
+
+static void writeTextReport( FILE* aFile, BOARD* aBoard, const DRC& aDrc,
+                             const std::vector<DRC_PHASE_TIME>& aPhases )
+{
+    // Same layout as the report of the DRC dialog, followed by the phase times
+    fprintf( aFile, "** Drc report for %s **\n", TO_UTF8( aBoard->GetFileName() ) );
+
+    wxDateTime now = wxDateTime::Now();
+
+    fprintf( aFile, "** Created on %s **\n", TO_UTF8( now.Format( wxT( "%F %T" ) ) ) );
+
+    int count = aBoard->GetMARKERCount();
+
+    fprintf( aFile, "\n** Found %d DRC errors **\n", count );
+
+    for( int ii = 0; ii < count; ++ii )
+        fprintf( aFile, "%s", TO_UTF8( aBoard->GetMARKER( ii )->GetReporter().ShowReport() ) );
+
+    const DRC_LIST& unconnected = aDrc.GetUnconnectedItems();
+
+    fprintf( aFile, "\n** Found %d unconnected pads **\n", (int) unconnected.size() );
+
+    for( unsigned ii = 0; ii < unconnected.size(); ++ii )
+        fprintf( aFile, "%s", TO_UTF8( unconnected[ii]->ShowReport() ) );
+
+    uint64_t total = 0;
+
+    fprintf( aFile, "\n** Phase times **\n" );
+
+    for( unsigned ii = 0; ii < aPhases.size(); ++ii )
+    {
+        fprintf( aFile, "    %-20s %10.3f ms\n",
+                 TO_UTF8( aPhases[ii].m_Name ), aPhases[ii].m_Usecs / 1000.0 );
+        total += aPhases[ii].m_Usecs;
+    }
+
+    fprintf( aFile, "    %-20s %10.3f ms\n", "total", total / 1000.0 );
+
+    fprintf( aFile, "\n** End of Report **\n" );
+}
+
+
+int main( int argc, char** argv )
+{
+    if( !InitPcbnewTool( argc, argv, "pcbnew_drc" ) )
+        return DRC_EXIT_FAILED;
+
+    wxCmdLineParser parser( g_cmdLineDesc, argc, argv );
+
+    if( parser.Parse() != 0 )
+        return DRC_EXIT_FAILED;
+
+    wxString format = wxT( "text" );
+    wxString reportName;
+
+    parser.Found( wxT( "format" ), &format );
+    parser.Found( wxT( "output" ), &reportName );
+
+    if( format != wxT( "text" ) && format != wxT( "json" ) )
+    {
+        fprintf( stderr, "pcbnew_drc: unknown report format '%s'\n", TO_UTF8( format ) );
+        return DRC_EXIT_FAILED;
+    }
+
+    wxString                    boardName = parser.GetParam( 0 );
+    std::vector<DRC_PHASE_TIME> phases;
+    DRC_PHASE_TIME              loadTime;
+    prof_counter                counter;
+    BOARD*                      board = NULL;
+
+    prof_start( &counter );
+
+    try
+    {
+        IO_MGR::PCB_FILE_T pluginType = IO_MGR::KICAD;
+
+        if( boardName.EndsWith( wxT( ".brd" ) ) )
+            pluginType = IO_MGR::LEGACY;
+
+        board = IO_MGR::Load( pluginType, boardName );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "pcbnew_drc: error loading board '%s':\n%s\n",
+                 TO_UTF8( boardName ), TO_UTF8( ioe.errorText ) );
+        return DRC_EXIT_FAILED;
+    }
+
+    // we should not ask PLUGINs to do these items (see PCB_EDIT_FRAME::OpenProjectFiles()):
+    board->BuildListOfNets();
+    board->SynchronizeNetsAndNetClasses();
+    board->GetDesignSettings().SetCurrentNetClass( NETCLASS::Default );
+
+    prof_end( &counter );
+
+    loadTime.m_Name  = wxT( "load" );
+    loadTime.m_Usecs = counter.usecs();
+    phases.push_back( loadTime );
+
+    DRC drc( board );
+
+    drc.SetSettings( true, !parser.Found( wxT( "no-unconnected" ) ), true, true,
+                     wxEmptyString, false );
+    drc.RunTests();
+
+    phases.insert( phases.end(), drc.GetPhaseTimes().begin(), drc.GetPhaseTimes().end() );
+
+    FILE* file = stdout;
+
+    if( !reportName.IsEmpty() )
+    {
+        file = wxFopen( reportName, wxT( "w" ) );
+
+        if( !file )
+        {
+            fprintf( stderr, "pcbnew_drc: cannot create report file '%s'\n",
+                     TO_UTF8( reportName ) );
+            delete board;
+            return DRC_EXIT_FAILED;
+        }
+    }
+
+    if( format == wxT( "json" ) )
+        writeJsonReport( file, board, drc, phases );
+    else
+        writeTextReport( file, board, drc, phases );
+
+    if( file != stdout )
+        fclose( file );
+
+    bool clean = board->GetMARKERCount() == 0 && drc.GetUnconnectedItems().empty();
+
+    delete board;
+
+    return clean ? DRC_EXIT_OK : DRC_EXIT_ERRORS;
+}
@@ -0,0 +1,78 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file pcbnew_tool.cpp
+ * @brief Start up of the pcbnew command line tools.
+ */
+
+#include <cstdlib>
+
+#include <fctsys.h>
+#include <wx/init.h>
+
+#include <pgm_base.h>
+#include <kiway.h>
+#include <common.h>
+
+#include <pcbnew_tool.h>
+
+
+/**
+ * Struct PGM_PCBNEW_TOOL
+ * is the PGM_BASE of the command line tools.  The pcbnew code reaches the program
+ * through Pgm(), which is given to the KIFACE by KIFACE_GETTER().
+ */
+static struct PGM_PCBNEW_TOOL : public PGM_BASE
+{
+    bool OnPgmInit( wxApp* aWxApp ) { return true; }    // overload PGM_BASE virtual
+    void OnPgmExit() {}                                 // overload PGM_BASE virtual
+    void MacOpenFile( const wxString& aFileName ) {}    // overload PGM_BASE virtual
+} program;
+
+
+// Registered after the construction of program, so it runs before its destruction
+static void exitPcbnewTool()
+{
+    wxUninitialize();
+}
+
+
+bool InitPcbnewTool( int& argc, char** argv, const char* aToolName )
+{
+    if( !wxInitialize( argc, argv ) )
+    {
+        fprintf( stderr, "%s: cannot initialize wxWidgets\n", aToolName );
+        return false;
+    }
+
+    atexit( exitPcbnewTool );
+
+    // The pcbnew code needs a program, even without any frame
+    int kifaceVersion;
+    KIFACE_GETTER( &kifaceVersion, KIFACE_VERSION, &program );
+
+    g_UserUnit = MILLIMETRES;
+
+    return true;
+}
@@ -0,0 +1,45 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file pcbnew_tool.h
+ * @brief Start up of the pcbnew command line tools (pcbnew_drc, drc_bench, pns_replay).
+ */
+
+#ifndef PCBNEW_TOOL_H
+#define PCBNEW_TOOL_H
+
+
+/**
+ * Function InitPcbnewTool
+ * initializes wxWidgets and the pcbnew KIFACE for a command line tool, which
+ * uses the pcbnew code without any frame.  wxWidgets is cleaned up at exit.
+ * The user units are set to millimeters.
+ * @param argc and argv are the arguments of main().
+ * @param aToolName is the tool name, used in the error message.
+ * @return bool - false, after writing an error message to stderr, if wxWidgets
+ *  cannot be initialized.
+ */
+bool InitPcbnewTool( int& argc, char** argv, const char* aToolName );
+
+#endif  // PCBNEW_TOOL_H
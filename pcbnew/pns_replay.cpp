@@ -0,0 +1,420 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file pns_replay.cpp
+ * @brief Replays a recorded interactive routing session, to profile the router.
+ *
+ * Usage: pns_replay [--repeat N] [--steps] recording_file
+ *
+ * Recordings are made by the router tools (see PNS_TOOL_BASE::startRecording()): run
+ * pcbnew with KICAD_PNS_RECORD=recording_file to record the routing sessions in
+ * recording_file.InteractiveRouter (and recording_file.LengthTuner for the length
+ * tuner).  A recording holds the name of the board file saved when the board was
+ * loaded, and the calls of the router functions (StartRouting(), Move(), FixRoute()...)
+ * with their parameters and the sizes and settings used.  Each time the tool is
+ * invoked, a new router syncs its world with the board: this is recorded too.
+ * Board changes made by other tools are not recorded.
+ *
+ * The calls are executed again on the board, by a router without any view, and each
+ * one is timed along with the collision queries and node branches it caused.  The
+ * results are written to the standard output, as CSV lines, one per type of call:
+ *
+ *      event,count,p50_ms,p90_ms,p99_ms,max_ms,total_ms,queries_per_step,branches_per_step
+ *
+ * With --repeat, the whole session is replayed N times (on a fresh copy of the board)
+ * and all the runs are used for the statistics.
+ * With --steps, one line per call is written instead:
+ *
+ *      run,step,event,ms,queries,branches
+ */
+
+#include <cmath>
+#include <map>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+
+#include <boost/foreach.hpp>
+
+#include <fctsys.h>
+#include <wx/cmdline.h>
+#include <wx/filename.h>
+
+#include <common.h>
+#include <macros.h>
+#include <io_mgr.h>
+#include <class_board.h>
+#include <ratsnest_data.h>
+#include <profile.h>
+#include <pcbnew_tool.h>
+
+#include <router/pns_router.h>
+#include <router/pns_node.h>
+#include <router/pns_item.h>
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    { wxCMD_LINE_OPTION, NULL, "repeat", "number of replays of the session (default 1)",
+      wxCMD_LINE_VAL_NUMBER, 0 },
+    { wxCMD_LINE_SWITCH, NULL, "steps", "write the time of each call instead of the statistics",
+      wxCMD_LINE_VAL_NONE, 0 },
+    { wxCMD_LINE_PARAM, NULL, NULL, "recording file",
+      wxCMD_LINE_VAL_STRING, 0 },
+    { wxCMD_LINE_NONE }
+};
+
+
+/**
+ * Struct EVENT_STATS
+ * holds the measures of all the calls of a router function.
+ */
+struct EVENT_STATS
+{
+    std::vector<double> m_Ms;       ///< wall time of each call
+    int64_t m_Queries;              ///< collision queries of all the calls
+    int64_t m_Branches;             ///< node branches of all the calls
+
+    EVENT_STATS() : m_Queries( 0 ), m_Branches( 0 ) {}
+};
+
+typedef std::map<std::string, EVENT_STATS> STATS_MAP;
+
+
+/**
+ * Function findItem
+ * finds the item recorded in aLine (see PNS_LOGGER::LogEvent()), as the tool would
+ * pick it: by a hit test of the router world at the item anchor.
+ * @param aLine is the rest of the event line, after the coordinates and the argument.
+ * @return the item, or NULL if there is no item in the line or it was not found.
+ */
+static PNS_ITEM* findItem( PNS_ROUTER& aRouter, std::istringstream& aLine )
+{
+    std::string kindStr;
+
+    aLine >> kindStr;
+
+    if( kindStr.empty() || kindStr == "-" )
+        return NULL;
+
+    int kind = atoi( kindStr.c_str() );
+    int net, layerStart, layerEnd;
+    VECTOR2I anchor;
+
+    aLine >> net >> layerStart >> layerEnd >> anchor.x >> anchor.y;
+
+    PNS_ITEMSET candidates = aRouter.QueryHoverItems( anchor );
+
+    BOOST_FOREACH( PNS_ITEM* item, candidates.Items() )
+    {
+        if( item->Kind() == kind && item->Net() == net
+            && item->Layers().Start() == layerStart && item->Layers().End() == layerEnd
+            && item->Anchor( 0 ) == anchor )
+        {
+            return item;
+        }
+    }
+
+    fprintf( stderr, "pns_replay: item of kind %d (net %d) not found at %d, %d\n",
+             kind, net, anchor.x, anchor.y );
+    return NULL;
+}
+
+
+/**
+ * Function replay
+ * loads aBoardName and executes the router calls of aLines on it.
+ * @return false if the board cannot be loaded.
+ */
+static bool replay( int aRun, const wxString& aBoardName, const std::vector<std::string>& aLines,
+                    bool aWriteSteps, STATS_MAP& aStats )
+{
+    BOARD* board;
+
+    try
+    {
+        board = IO_MGR::Load( IO_MGR::KICAD, aBoardName );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "pns_replay: error loading board '%s':\n%s\n",
+                 TO_UTF8( aBoardName ), TO_UTF8( ioe.errorText ) );
+        return false;
+    }
+
+    // as done after loading a board in pcbnew (see PCB_EDIT_FRAME::OpenProjectFiles())
+    board->BuildListOfNets();
+    board->SynchronizeNetsAndNetClasses();
+    board->GetDesignSettings().SetCurrentNetClass( NETCLASS::Default );
+    board->GetRatsnest()->ProcessBoard();
+
+    // the router is deleted before the board, which owns the parents of its items
+    PNS_ROUTER* router = new PNS_ROUTER;
+
+    router->SetBoard( board );
+    router->SyncWorld();
+
+    PNS_SIZES_SETTINGS      sizes;
+    PNS_ROUTING_SETTINGS    settings;
+    PNS_ROUTER_MODE         mode = PNS_MODE_ROUTE_SINGLE;
+    prof_counter            counter;
+    int                     step = 0;
+
+    for( unsigned ii = 0; ii < aLines.size(); ++ii )
+    {
+        std::istringstream  line( aLines[ii] );
+        std::string         keyword;
+
+        line >> keyword;
+
+        if( keyword == "sizes" )
+        {
+            int width, viaDiameter, viaDrill, viaType, dpWidth, dpGap, dpViaGap, top, bottom;
+
+            line >> width >> viaDiameter >> viaDrill >> viaType >> dpWidth >> dpGap >>
+                    dpViaGap >> top >> bottom;
+
+            sizes.SetTrackWidth( width );
+            sizes.SetViaDiameter( viaDiameter );
+            sizes.SetViaDrill( viaDrill );
+            sizes.SetViaType( (VIATYPE_T) viaType );
+            sizes.SetDiffPairWidth( dpWidth );
+            sizes.SetDiffPairGap( dpGap );
+            sizes.SetDiffPairViaGap( dpViaGap );
+            sizes.SetDiffPairViaGapSameAsTraceGap( dpViaGap == dpGap );
+            sizes.ClearLayerPairs();
+            sizes.AddLayerPair( top, bottom );
+            continue;
+        }
+        else if( keyword == "settings" )
+        {
+            int routerMode, routingMode, effort, shoveVias, removeLoops, smartPads,
+                jumpOver, smoothDragged, violateDrc;
+
+            line >> routerMode >> routingMode >> effort >> shoveVias >> removeLoops >>
+                    smartPads >> jumpOver >> smoothDragged >> violateDrc;
+
+            mode = (PNS_ROUTER_MODE) routerMode;
+            settings.SetMode( (PNS_MODE) routingMode );
+            settings.SetOptimizerEffort( (PNS_OPTIMIZATION_EFFORT) effort );
+            settings.SetShoveVias( shoveVias );
+            settings.SetRemoveLoops( removeLoops );
+            settings.SetSmartPads( smartPads );
+            settings.SetJumpOverObstacles( jumpOver );
+            settings.SetSmoothDraggedSegments( smoothDragged );
+            settings.SetCanViolateDRC( violateDrc );
+            continue;
+        }
+        else if( keyword == "router" )
+        {
+            // The tool was invoked again, with a new router
+            if( router->RoutingInProgress() )
+                router->StopRouting();
+
+            delete router;
+
+            router = new PNS_ROUTER;
+            router->SetBoard( board );
+            router->SyncWorld();
+            continue;
+        }
+        else if( keyword != "event" )
+        {
+            continue;
+        }
+
+        std::string name;
+        VECTOR2I    p;
+        int         arg;
+
+        line >> name >> p.x >> p.y >> arg;
+
+        // FixRoute() stops the routing itself when it succeeds
+        if( name == "stop" && !router->RoutingInProgress() )
+            continue;
+
+        // items are picked before the call, as the tool does
+        PNS_ITEM* item = findItem( *router, line );
+
+        if( name == "start" || name == "drag" )
+        {
+            router->SetMode( mode );
+            router->LoadSettings( settings );
+            router->UpdateSizes( sizes );
+        }
+
+        PNS_NODE::Stats() = PNS_NODE_STATS();
+        prof_start( &counter );
+
+        if( name == "start" )
+            router->StartRouting( p, item, arg );
+        else if( name == "drag" )
+            router->StartDragging( p, item );
+        else if( name == "move" )
+            router->Move( p, item );
+        else if( name == "fix" )
+            router->FixRoute( p, item );
+        else if( name == "stop" )
+            router->StopRouting();
+        else if( name == "posture" )
+            router->FlipPosture();
+        else if( name == "layer" )
+            router->SwitchLayer( arg );
+        else if( name == "via" )
+            router->ToggleViaPlacement();
+        else if( name == "ortho" )
+            router->SetOrthoMode( arg );
+        else if( name == "sizes" )
+            router->UpdateSizes( sizes );
+
+        prof_end( &counter );
+
+        const PNS_NODE_STATS& nodeStats = PNS_NODE::Stats();
+        EVENT_STATS& stats = aStats[name];
+        double ms = counter.usecs() / 1000.0;
+
+        stats.m_Ms.push_back( ms );
+        stats.m_Queries  += nodeStats.m_collisionQueries;
+        stats.m_Branches += nodeStats.m_branches;
+
+        if( aWriteSteps )
+        {
+            printf( "%d,%d,%s,%.3f,%d,%d\n", aRun, step, name.c_str(), ms,
+                    nodeStats.m_collisionQueries, nodeStats.m_branches );
+        }
+
+        step++;
+    }
+
+    if( router->RoutingInProgress() )
+        router->StopRouting();
+
+    delete router;
+    delete board;
+
+    return true;
+}
+
+
+/**
+ * Function percentile
+ * @return the aPercent percentile of the sorted values aValues (nearest rank).
+ */
+static double percentile( const std::vector<double>& aValues, double aPercent )
+{
+    if( aValues.empty() )
+        return 0.0;
+
+    int rank = (int) ceil( aPercent / 100.0 * aValues.size() ) - 1;
+
+    return aValues[ std::max( 0, std::min( rank, (int) aValues.size() - 1 ) ) ];
+}
+
+
+int main( int argc, char** argv )
+{
+    if( !InitPcbnewTool( argc, argv, "pns_replay" ) )
+        return 1;
+
+    wxCmdLineParser parser( g_cmdLineDesc, argc, argv );
+
+    if( parser.Parse() != 0 )
+        return 1;
+
+    long repeat = 1;
+
+    parser.Found( wxT( "repeat" ), &repeat );
+
+    wxString recordName = parser.GetParam( 0 );
+    std::ifstream recordFile( TO_UTF8( recordName ) );
+
+    if( !recordFile )
+    {
+        fprintf( stderr, "pns_replay: cannot read recording '%s'\n", TO_UTF8( recordName ) );
+        return 1;
+    }
+
+    std::vector<std::string> lines;
+    std::string line;
+    wxString boardName;
+
+    while( std::getline( recordFile, line ) )
+    {
+        // the board file is given relative to the recording
+        if( line.compare( 0, 6, "board " ) == 0 )
+        {
+            wxFileName fn( FROM_UTF8( line.substr( 6 ).c_str() ) );
+            fn.MakeAbsolute( wxFileName( recordName ).GetPath() );
+            boardName = fn.GetFullPath();
+        }
+        else
+        {
+            lines.push_back( line );
+        }
+    }
+
+    if( boardName.IsEmpty() )
+    {
+        fprintf( stderr, "pns_replay: no board in recording '%s'\n", TO_UTF8( recordName ) );
+        return 1;
+    }
+
+    bool        writeSteps = parser.Found( wxT( "steps" ) );
+    STATS_MAP   stats;
+
+    if( writeSteps )
+        printf( "run,step,event,ms,queries,branches\n" );
+
+    for( int run = 0; run < repeat; ++run )
+    {
+        if( !replay( run, boardName, lines, writeSteps, stats ) )
+            return 1;
+    }
+
+    if( writeSteps )
+        return 0;
+
+    printf( "event,count,p50_ms,p90_ms,p99_ms,max_ms,total_ms,"
+            "queries_per_step,branches_per_step\n" );
+
+    for( STATS_MAP::iterator it = stats.begin(); it != stats.end(); ++it )
+    {
+        std::vector<double>& ms = it->second.m_Ms;
+        double total = 0.0;
+
+        std::sort( ms.begin(), ms.end() );
+
+        for( unsigned ii = 0; ii < ms.size(); ++ii )
+            total += ms[ii];
+
+        printf( "%s,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f,%.1f\n", it->first.c_str(),
+                (int) ms.size(), percentile( ms, 50 ), percentile( ms, 90 ),
+                percentile( ms, 99 ), ms.back(), total,
+                (double) it->second.m_Queries / ms.size(),
+                (double) it->second.m_Branches / ms.size() );
+    }
+
+    return 0;
+}
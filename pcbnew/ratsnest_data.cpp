@@ -52,28 +52,32 @@
 #include <profile.h>
 #endif
 
-static uint64_t getDistance( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2 )
+static uint64_t getDistance( const RN_NODE& aNode1, const RN_NODE& aNode2 )
 {
     // Drop the least significant bits to avoid overflow
-    int64_t x = ( aNode1->GetX() - aNode2->GetX() ) >> 16;
-    int64_t y = ( aNode1->GetY() - aNode2->GetY() ) >> 16;
+    int64_t x = ( aNode1.GetX() - aNode2.GetX() ) >> 16;
+    int64_t y = ( aNode1.GetY() - aNode2.GetY() ) >> 16;
 
     // We do not need sqrt() here, as the distance is computed only for comparison
     return ( x * x + y * y );
 }
 
 
-static bool sortDistance( const RN_NODE_PTR& aOrigin, const RN_NODE_PTR& aNode1,
-                   const RN_NODE_PTR& aNode2 )
+///> Functor comparing the distance of two nodes from an origin node.
+struct RN_DISTANCE_COMPARE
 {
-    return getDistance( aOrigin, aNode1 ) < getDistance( aOrigin, aNode2 );
-}
+    RN_DISTANCE_COMPARE( const std::vector<RN_NODE>& aNodes, const RN_NODE& aOrigin ) :
+        m_nodes( aNodes ), m_origin( aOrigin )
+    {}
 
+    bool operator()( RN_NODE_ID aNode1, RN_NODE_ID aNode2 ) const
+    {
+        return getDistance( m_origin, m_nodes[aNode1] ) < getDistance( m_origin, m_nodes[aNode2] );
+    }
 
-static bool sortWeight( const RN_EDGE_PTR& aEdge1, const RN_EDGE_PTR& aEdge2 )
-{
-    return aEdge1->GetWeight() < aEdge2->GetWeight();
-}
+    const std::vector<RN_NODE>& m_nodes;
+    const RN_NODE& m_origin;
+};
 
 
 bool sortArea( const RN_POLY& aP1, const RN_POLY& aP2 )
@@ -82,16 +86,43 @@ bool sortArea( const RN_POLY& aP1, const RN_POLY& aP2 )
 }
 
 
-bool operator==( const RN_NODE_PTR& aFirst, const RN_NODE_PTR& aSecond )
+///> Functor sorting nodes by their X coordinate (then by their Y coordinate).
+struct RN_SORT_NODE_X
 {
-    return aFirst->GetX() == aSecond->GetX() && aFirst->GetY() == aSecond->GetY();
-}
+    RN_SORT_NODE_X( const std::vector<RN_NODE>& aNodes ) :
+        m_nodes( aNodes )
+    {}
+
+    bool operator()( RN_NODE_ID aNode1, RN_NODE_ID aNode2 ) const
+    {
+        const RN_NODE& node1 = m_nodes[aNode1];
+        const RN_NODE& node2 = m_nodes[aNode2];
 
+        if( node1.GetX() == node2.GetX() )
+            return node1.GetY() < node2.GetY();
 
-bool operator!=( const RN_NODE_PTR& aFirst, const RN_NODE_PTR& aSecond )
+        return node1.GetX() < node2.GetX();
+    }
+
+    const std::vector<RN_NODE>& m_nodes;
+};
+
+
+///> Functor comparing the X coordinate of a node with a value, for searches in the nodes sorted
+///> with RN_SORT_NODE_X.
+struct RN_COMPARE_NODE_X
 {
-    return aFirst->GetX() != aSecond->GetX() || aFirst->GetY() != aSecond->GetY();
-}
+    RN_COMPARE_NODE_X( const std::vector<RN_NODE>& aNodes ) :
+        m_nodes( aNodes )
+    {}
+
+    bool operator()( RN_NODE_ID aNode, int aX ) const
+    {
+        return m_nodes[aNode].GetX() < aX;
+    }
+
+    const std::vector<RN_NODE>& m_nodes;
+};
 
 
 RN_NODE_AND_FILTER operator&&( const RN_NODE_FILTER& aFilter1, const RN_NODE_FILTER& aFilter2 )
@@ -106,121 +137,292 @@ RN_NODE_OR_FILTER operator||( const RN_NODE_FILTER& aFilter1, const RN_NODE_FILT
 }
 
 
-static bool isEdgeConnectingNode( const RN_EDGE_PTR& aEdge, const RN_NODE_PTR& aNode )
+static bool isEdgeConnectingNode( const RN_EDGE& aEdge, RN_NODE_ID aNode )
 {
-    return aEdge->GetSourceNode() == aNode || aEdge->GetTargetNode() == aNode;
+    return aEdge.GetSourceNode() == aNode || aEdge.GetTargetNode() == aNode;
 }
 
 
-static std::vector<RN_EDGE_MST_PTR>* kruskalMST( RN_LINKS::RN_EDGE_LIST& aEdges,
-                                                 std::vector<RN_NODE_PTR>& aNodes )
+void RN_NODE::AddParent( const BOARD_CONNECTED_ITEM* aParent )
 {
-    unsigned int nodeNumber = aNodes.size();
-    unsigned int mstExpectedSize = nodeNumber - 1;
-    unsigned int mstSize = 0;
-    bool ratsnestLines = false;
+    m_parents.push_back( aParent );
+    m_layers.reset();   // mark as needs updating
+}
+
+
+void RN_NODE::RemoveParent( const BOARD_CONNECTED_ITEM* aParent )
+{
+    m_parents.erase( std::remove( m_parents.begin(), m_parents.end(), aParent ),
+                     m_parents.end() );
+    m_layers.reset();   // mark as needs updating
+}
+
+
+void RN_NODE::updateLayers()
+{
+    assert( m_layers.none() );
+
+    BOOST_FOREACH( const BOARD_CONNECTED_ITEM* item, m_parents )
+        m_layers |= item->GetLayerSet();
+}
+
+
+static bool sortMstWeight( const RN_EDGE& aEdge1, const RN_EDGE& aEdge2 )
+{
+    return aEdge1.GetWeight() < aEdge2.GetWeight();
+}
 
-    // The output
-    std::vector<RN_EDGE_MST_PTR>* mst = new std::vector<RN_EDGE_MST_PTR>;
-    mst->reserve( mstExpectedSize );
 
-    // Set tags for marking cycles
-    boost::unordered_map<RN_NODE_PTR, int> tags;
-    unsigned int tag = 0;
-    BOOST_FOREACH( RN_NODE_PTR& node, aNodes )
+///> Returns the root of the subtree containing a node (union-find with path halving).
+static unsigned int findSubtree( std::vector<unsigned int>& aParents, unsigned int aNode )
+{
+    while( aParents[aNode] != aNode )
     {
-        node->SetTag( tag );
-        tags[node] = tag++;
+        aParents[aNode] = aParents[aParents[aNode]];
+        aNode = aParents[aNode];
     }
 
-    // Lists of nodes connected together (subtrees) to detect cycles in the graph
-    std::vector<std::list<int> > cycles( nodeNumber );
-    for( unsigned int i = 0; i < nodeNumber; ++i )
-        cycles[i].push_back( i );
+    return aNode;
+}
+
+
+/**
+ * Function kruskalMST()
+ * Computes the minimal spanning tree of the nodes of a net. Nodes are tagged with their subtree
+ * of connected items (edges of weight 0) and the missing connections are stored in aMst.
+ * @param aEdges are the edges to choose from, they are sorted by their weight.
+ * @param aLinks stores the nodes (slots of removed nodes are single node subtrees).
+ * @param aMst is the output: the ratsnest edges.
+ */
+static void kruskalMST( std::vector<RN_EDGE>& aEdges, RN_LINKS& aLinks,
+                        std::vector<RN_EDGE>& aMst )
+{
+    unsigned int nodeNumber = aLinks.GetNodes().size();
+    unsigned int mstExpectedSize = aLinks.GetNodeCount() - 1;
+    unsigned int mstSize = 0;
+    bool ratsnestLines = false;
+
+    aMst.clear();
+    aMst.reserve( mstExpectedSize );
 
     // Kruskal algorithm requires edges to be sorted by their weight
-    aEdges.sort( sortWeight );
+    // (a stable sort keeps the order of equal weight edges, hence the ratsnest)
+    std::stable_sort( aEdges.begin(), aEdges.end(), sortMstWeight );
+
+    // Subtrees of nodes connected together, to detect cycles in the graph
+    std::vector<unsigned int> parents( nodeNumber );
+
+    for( unsigned int i = 0; i < nodeNumber; ++i )
+        parents[i] = i;
 
-    while( mstSize < mstExpectedSize && !aEdges.empty() )
+    for( unsigned int i = 0; i < aEdges.size() && mstSize < mstExpectedSize; ++i )
     {
-        RN_EDGE_PTR& dt = aEdges.front();
+        const RN_EDGE& dt = aEdges[i];
 
-        int srcTag = tags[dt->GetSourceNode()];
-        int trgTag = tags[dt->GetTargetNode()];
+        unsigned int srcTree = findSubtree( parents, dt.GetSourceNode() );
+        unsigned int trgTree = findSubtree( parents, dt.GetTargetNode() );
 
         // Check if by adding this edge we are going to join two different forests
-        if( srcTag != trgTag )
+        if( srcTree == trgTree )
+            continue;
+
+        // Because edges are sorted by their weight, first we always process connected
+        // items (weight == 0). Once we stumble upon an edge with non-zero weight,
+        // it means that the rest of the lines are ratsnest.
+        if( !ratsnestLines && dt.GetWeight() != 0 )
         {
-            // Because edges are sorted by their weight, first we always process connected
-            // items (weight == 0). Once we stumble upon an edge with non-zero weight,
-            // it means that the rest of the lines are ratsnest.
-            if( !ratsnestLines && dt->GetWeight() != 0 )
-                ratsnestLines = true;
+            ratsnestLines = true;
 
-            // Update tags
-            std::list<int>::iterator it, itEnd;
+            // Connected items are known now: tag nodes with their subtree
+            for( unsigned int j = 0; j < nodeNumber; ++j )
+                aLinks.GetNode( j ).SetTag( findSubtree( parents, j ) );
+        }
 
-            if( ratsnestLines )
-            {
-                for( it = cycles[trgTag].begin(), itEnd = cycles[trgTag].end(); it != itEnd; ++it )
-                    tags[aNodes[*it]] = srcTag;
-            }
-            else
-            {
-                for( it = cycles[trgTag].begin(), itEnd = cycles[trgTag].end(); it != itEnd; ++it ) {
-                    tags[aNodes[*it]] = srcTag;
-                    aNodes[*it]->SetTag( srcTag );
-                }
-            }
+        parents[trgTree] = srcTree;
+
+        if( ratsnestLines )
+        {
+            aMst.push_back( dt );
+            ++mstSize;
+        }
+        else
+        {
+            // Processing a connection, decrease the expected size of the ratsnest MST
+            --mstExpectedSize;
+        }
+    }
+
+    // Everything is connected, there were no ratsnest lines to tag nodes
+    if( !ratsnestLines )
+    {
+        for( unsigned int j = 0; j < nodeNumber; ++j )
+            aLinks.GetNode( j ).SetTag( findSubtree( parents, j ) );
+    }
+}
 
-            // Move nodes that were marked with old tag to the list marked with the new tag
-            cycles[srcTag].splice( cycles[srcTag].end(), cycles[trgTag] );
 
-            if( ratsnestLines )
+#ifdef USE_OPENMP
+///> Compares edges by their weight, then by their index (i.e. the order given by the stable sort
+///> of kruskalMST()).
+static inline bool isLighter( const std::vector<RN_EDGE>& aEdges, int aEdge1, int aEdge2 )
+{
+    return aEdges[aEdge1].GetWeight() < aEdges[aEdge2].GetWeight()
+        || ( aEdges[aEdge1].GetWeight() == aEdges[aEdge2].GetWeight() && aEdge1 < aEdge2 );
+}
+
+
+/**
+ * Function boruvkaMST()
+ * Computes the same minimal spanning tree as kruskalMST(), using the Boruvka algorithm for
+ * large nets: the lightest edge leaving every subtree is searched by all threads, and as edges
+ * are totally ordered (by weight, then by index), the tree is the one found by kruskalMST().
+ * The ratsnest edges are returned in the same order and nodes are tagged the same way too.
+ */
+static void boruvkaMST( const std::vector<RN_EDGE>& aEdges, RN_LINKS& aLinks,
+                        std::vector<RN_EDGE>& aMst )
+{
+    const int nodeNumber = aLinks.GetNodes().size();
+    const int edgeNumber = aEdges.size();
+    int i;
+
+    // Edges adjacent to every node (adjacent[first[n]] to adjacent[first[n + 1] - 1])
+    std::vector<int> first( nodeNumber + 1, 0 );
+    std::vector<int> adjacent( 2 * edgeNumber );
+
+    for( i = 0; i < edgeNumber; ++i )
+    {
+        ++first[aEdges[i].GetSourceNode() + 1];
+        ++first[aEdges[i].GetTargetNode() + 1];
+    }
+
+    for( i = 0; i < nodeNumber; ++i )
+        first[i + 1] += first[i];
+
+    std::vector<int> next( first.begin(), first.end() - 1 );
+
+    for( i = 0; i < edgeNumber; ++i )
+    {
+        adjacent[next[aEdges[i].GetSourceNode()]++] = i;
+        adjacent[next[aEdges[i].GetTargetNode()]++] = i;
+    }
+
+    // Subtrees of nodes joined together and the subtree of every node
+    std::vector<unsigned int> parents( nodeNumber );
+    std::vector<int> subtree( nodeNumber );
+
+    for( i = 0; i < nodeNumber; ++i )
+        parents[i] = subtree[i] = i;
+
+    std::vector<int> nodeLightest( nodeNumber );
+    std::vector<int> subtreeLightest( nodeNumber );
+    std::vector<char> inMst( edgeNumber, 0 );
+    bool joined = true;
+
+    while( joined )
+    {
+        joined = false;
+
+        // The lightest edge leaving the subtree, for every node
+        #pragma omp parallel for
+        for( i = 0; i < nodeNumber; ++i )
+        {
+            int lightest = -1;
+
+            for( int j = first[i]; j < first[i + 1]; ++j )
             {
-                // Do a copy of edge, but make it RN_EDGE_MST. In contrary to RN_EDGE,
-                // RN_EDGE_MST saves both source and target node and does not require any other
-                // edges to exist for getting source/target nodes
-                RN_EDGE_MST_PTR newEdge = boost::make_shared<RN_EDGE_MST>( dt->GetSourceNode(),
-                                                                           dt->GetTargetNode(),
-                                                                           dt->GetWeight() );
-                mst->push_back( newEdge );
-                ++mstSize;
+                int edge = adjacent[j];
+
+                if( subtree[aEdges[edge].GetSourceNode()] != subtree[aEdges[edge].GetTargetNode()]
+                        && ( lightest < 0 || isLighter( aEdges, edge, lightest ) ) )
+                    lightest = edge;
             }
-            else
+
+            nodeLightest[i] = lightest;
+        }
+
+        // The lightest edge leaving every subtree
+        std::fill( subtreeLightest.begin(), subtreeLightest.end(), -1 );
+
+        for( i = 0; i < nodeNumber; ++i )
+        {
+            int edge = nodeLightest[i];
+            int& lightest = subtreeLightest[subtree[i]];
+
+            if( edge >= 0 && ( lightest < 0 || isLighter( aEdges, edge, lightest ) ) )
+                lightest = edge;
+        }
+
+        // Join subtrees (the same edge may be the lightest one for both subtrees it joins)
+        for( i = 0; i < nodeNumber; ++i )
+        {
+            int edge = subtreeLightest[i];
+
+            if( edge < 0 )
+                continue;
+
+            unsigned int srcTree = findSubtree( parents, aEdges[edge].GetSourceNode() );
+            unsigned int trgTree = findSubtree( parents, aEdges[edge].GetTargetNode() );
+
+            if( srcTree != trgTree )
             {
-                // Processing a connection, decrease the expected size of the ratsnest MST
-                --mstExpectedSize;
+                parents[trgTree] = srcTree;
+                inMst[edge] = 1;
+                joined = true;
             }
         }
 
-        // Remove the edge that was just processed
-        aEdges.erase( aEdges.begin() );
+        for( i = 0; i < nodeNumber; ++i )
+            subtree[i] = findSubtree( parents, i );
+    }
+
+    // Tag nodes with subtrees of connected items (edges of weight 0)
+    // and collect ratsnest lines, in the order given by kruskalMST()
+    aMst.clear();
+
+    for( i = 0; i < nodeNumber; ++i )
+        parents[i] = i;
+
+    for( i = 0; i < edgeNumber; ++i )
+    {
+        if( !inMst[i] )
+            continue;
+
+        if( aEdges[i].GetWeight() == 0 )
+        {
+            unsigned int srcTree = findSubtree( parents, aEdges[i].GetSourceNode() );
+            unsigned int trgTree = findSubtree( parents, aEdges[i].GetTargetNode() );
+            parents[trgTree] = srcTree;
+        }
+        else
+        {
+            aMst.push_back( aEdges[i] );
+        }
     }
 
-    // Probably we have discarded some of edges, so reduce the size
-    mst->resize( mstSize );
+    for( i = 0; i < nodeNumber; ++i )
+        aLinks.GetNode( i ).SetTag( findSubtree( parents, i ) );
 
-    return mst;
+    std::stable_sort( aMst.begin(), aMst.end(), sortMstWeight );
 }
+#endif /* USE_OPENMP */
 
 
-void RN_NET::validateEdge( RN_EDGE_MST_PTR& aEdge )
+void RN_NET::validateEdge( RN_EDGE& aEdge )
 {
-    RN_NODE_PTR source = aEdge->GetSourceNode();
-    RN_NODE_PTR target = aEdge->GetTargetNode();
+    RN_NODE_ID source = aEdge.GetSourceNode();
+    RN_NODE_ID target = aEdge.GetTargetNode();
     bool valid = true;
 
     // If any of nodes belonging to the edge has the flag set,
     // change it to the closest node that has flag cleared
-    if( source->GetFlag() )
+    if( m_links.GetNode( source ).GetFlag() )
     {
         valid = false;
 
-        std::list<RN_NODE_PTR> closest = GetClosestNodes( source, WITHOUT_FLAG() );
-        BOOST_FOREACH( RN_NODE_PTR& node, closest )
+        std::list<RN_NODE_ID> closest = GetClosestNodes( source, WITHOUT_FLAG() );
+        BOOST_FOREACH( RN_NODE_ID node, closest )
         {
-            if( node && node != target )
+            if( node != target )
             {
                 source = node;
                 break;
@@ -228,14 +430,14 @@ void RN_NET::validateEdge( RN_EDGE_MST_PTR& aEdge )
         }
     }
 
-    if( target->GetFlag() )
+    if( m_links.GetNode( target ).GetFlag() )
     {
         valid = false;
 
-        std::list<RN_NODE_PTR> closest = GetClosestNodes( target, WITHOUT_FLAG() );
-        BOOST_FOREACH( RN_NODE_PTR& node, closest )
+        std::list<RN_NODE_ID> closest = GetClosestNodes( target, WITHOUT_FLAG() );
+        BOOST_FOREACH( RN_NODE_ID node, closest )
         {
-            if( node && node != source )
+            if( node != source )
             {
                 target = node;
                 break;
@@ -245,26 +447,59 @@ void RN_NET::validateEdge( RN_EDGE_MST_PTR& aEdge )
 
     // Replace an invalid edge with new, valid one
     if( !valid )
-        aEdge.reset( new RN_EDGE_MST( source, target ) );
+        aEdge = RN_EDGE( source, target );
 }
 
 
-const RN_NODE_PTR& RN_LINKS::AddNode( int aX, int aY )
+RN_NODE_ID RN_LINKS::AddNode( int aX, int aY )
 {
-    RN_NODE_SET::iterator node;
-    bool wasNewElement;
+    // Look for an existing node first
+    std::pair<RN_NODE_MAP::iterator, bool> id =
+        m_nodeIds.insert( std::make_pair( VECTOR2I( aX, aY ), RN_NO_NODE ) );
+
+    if( !id.second )
+        return id.first->second;
+
+    // A new node takes the slot of a removed one, if there is any
+    RN_NODE_ID node;
+
+    if( m_freeNodes.empty() )
+    {
+        node = m_nodes.size();
+        m_nodes.push_back( RN_NODE( aX, aY ) );
+    }
+    else
+    {
+        node = m_freeNodes.back();
+        m_freeNodes.pop_back();
+        m_nodes[node] = RN_NODE( aX, aY );
+    }
+
+    m_nodes[node].m_used = true;
+    ++m_nodeCount;
 
-    boost::tie( node, wasNewElement ) = m_nodes.emplace( boost::make_shared<RN_NODE>( aX, aY ) );
+    id.first->second = node;
+    m_addedNodes.insert( node );
 
-    return *node;
+    return node;
 }
 
 
-bool RN_LINKS::RemoveNode( const RN_NODE_PTR& aNode )
+bool RN_LINKS::RemoveNode( RN_NODE_ID aNode )
 {
-    if( aNode->GetRefCount() == 0 )
+    RN_NODE& node = m_nodes[aNode];
+    assert( node.IsUsed() );
+
+    if( node.GetRefCount() == 0 )
     {
-        m_nodes.erase( aNode );
+        // A node that was not seen by the ratsnest computation yet is simply forgotten
+        if( m_addedNodes.erase( aNode ) == 0 )
+            m_removedNodes.insert( aNode );
+
+        m_nodeIds.erase( VECTOR2I( node.GetX(), node.GetY() ) );
+        node = RN_NODE();
+        m_freeNodes.push_back( aNode );
+        --m_nodeCount;
 
         return true;
     }
@@ -273,152 +508,311 @@ bool RN_LINKS::RemoveNode( const RN_NODE_PTR& aNode )
 }
 
 
-RN_EDGE_MST_PTR RN_LINKS::AddConnection( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2,
-                                          unsigned int aDistance )
+RN_EDGE_ID RN_LINKS::AddConnection( RN_NODE_ID aNode1, RN_NODE_ID aNode2,
+                                    unsigned int aDistance )
 {
     assert( aNode1 != aNode2 );
-    RN_EDGE_MST_PTR edge = boost::make_shared<RN_EDGE_MST>( aNode1, aNode2, aDistance );
-    m_edges.push_back( edge );
+    RN_EDGE_ID edge;
+
+    if( m_freeEdges.empty() )
+    {
+        edge = m_edges.size();
+        m_edges.push_back( RN_EDGE( aNode1, aNode2, aDistance ) );
+    }
+    else
+    {
+        edge = m_freeEdges.back();
+        m_freeEdges.pop_back();
+        m_edges[edge] = RN_EDGE( aNode1, aNode2, aDistance );
+    }
+
+    ++m_edgeCount;
 
     return edge;
 }
 
 
-void RN_NET::compute()
+void RN_LINKS::RemoveConnection( RN_EDGE_ID aEdge )
 {
-    const RN_LINKS::RN_NODE_SET& boardNodes = m_links.GetNodes();
-    const RN_LINKS::RN_EDGE_LIST& boardEdges = m_links.GetConnections();
+    assert( m_edges[aEdge].IsUsed() );
+
+    m_edges[aEdge] = RN_EDGE();
+    m_freeEdges.push_back( aEdge );
+    --m_edgeCount;
+}
+
+
+void RN_NET::compute( const std::vector<RN_NODE_ID>& aNodes )
+{
+    const std::vector<RN_EDGE>& boardEdges = m_links.GetConnections();
 
     // Special cases do not need complicated algorithms
-    if( boardNodes.size() <= 2 )
+    if( aNodes.size() <= 2 )
     {
-        m_rnEdges.reset( new std::vector<RN_EDGE_MST_PTR>( 0 ) );
+        m_rnEdges.clear();
 
         // Check if the only possible connection exists
-        if( boardEdges.size() == 0 && boardNodes.size() == 2 )
+        if( m_links.GetConnectionCount() == 0 && aNodes.size() == 2 )
         {
-            RN_LINKS::RN_NODE_SET::iterator last = ++boardNodes.begin();
-
             // There can be only one possible connection, but it is missing
-            m_rnEdges->push_back( boost::make_shared<RN_EDGE_MST>( *boardNodes.begin(), *last ) );
+            m_rnEdges.push_back( RN_EDGE( aNodes[0], aNodes[1] ) );
         }
 
+        m_triangulation.reset();
+        m_triangNodes.clear();
+        m_links.ClearChanges();
+
         return;
     }
 
-    // Move and sort (sorting speeds up) all nodes to a vector for the Delaunay triangulation
-    std::vector<RN_NODE_PTR> nodes( boardNodes.size() );
-    std::partial_sort_copy( boardNodes.begin(), boardNodes.end(), nodes.begin(), nodes.end() );
+    // Modifying the stored triangulation is much faster than creating it from scratch,
+    // as long as only a few nodes have changed
+    if( !updateTriangulation() )
+        createTriangulation( aNodes );
 
-    TRIANGULATOR triangulator;
-    triangulator.CreateDelaunay( nodes.begin(), nodes.end() );
-    boost::scoped_ptr<RN_LINKS::RN_EDGE_LIST> triangEdges( triangulator.GetEdges() );
+    m_links.ClearChanges();
 
-    // Compute weight/distance for edges resulting from triangulation
-    RN_LINKS::RN_EDGE_LIST::iterator eit, eitEnd;
+    boost::scoped_ptr< std::list<hed::EDGE_PTR> > triangEdges( m_triangulation->GetEdges() );
+
+    // The currently existing connections come first, followed by the results of triangulation
+    std::vector<RN_EDGE> edges;
+    edges.reserve( m_links.GetConnectionCount() + triangEdges->size() );
+
+    for( std::vector<RN_EDGE>::const_reverse_iterator it = boardEdges.rbegin();
+            it != boardEdges.rend(); ++it )
+    {
+        if( it->IsUsed() )
+            edges.push_back( *it );
+    }
+
+    const int connections = edges.size();
+
+    std::list<hed::EDGE_PTR>::iterator eit, eitEnd;
     for( eit = (*triangEdges).begin(), eitEnd = (*triangEdges).end(); eit != eitEnd; ++eit )
-        (*eit)->SetWeight( getDistance( (*eit)->GetSourceNode(), (*eit)->GetTargetNode() ) );
+    {
+        const hed::NODE_PTR& source = (*eit)->GetSourceNode();
+        const hed::NODE_PTR& target = (*eit)->GetTargetNode();
+
+        // Skip edges going to the corners of the area of a stored triangulation
+        if( m_triangulation->IsBoundingNode( source ) || m_triangulation->IsBoundingNode( target ) )
+            continue;
+
+        // Triangulation nodes are tagged with the index of their ratsnest node
+        edges.push_back( RN_EDGE( source->GetTag(), target->GetTag() ) );
+    }
 
-    // Add the currently existing connections list to the results of triangulation
-    std::copy( boardEdges.begin(), boardEdges.end(), std::front_inserter( *triangEdges ) );
+    // Compute weight/distance for edges resulting from triangulation
+#ifdef USE_OPENMP
+    const bool parallel = aNodes.size() >= PARALLEL_MIN_NODES;
+
+    #pragma omp parallel for if( parallel )
+#endif /* USE_OPENMP */
+    for( int i = connections; i < (int) edges.size(); ++i )
+    {
+        edges[i].SetWeight( getDistance( m_links.GetNode( edges[i].GetSourceNode() ),
+                                         m_links.GetNode( edges[i].GetTargetNode() ) ) );
+    }
 
     // Get the minimal spanning tree
-    m_rnEdges.reset( kruskalMST( *triangEdges, nodes ) );
+#ifdef USE_OPENMP
+    if( parallel )
+        boruvkaMST( edges, m_links, m_rnEdges );
+    else
+#endif /* USE_OPENMP */
+        kruskalMST( edges, m_links, m_rnEdges );
+
+    // Small nets do not need to keep their triangulation
+    if( aNodes.size() < INCREMENTAL_MIN_NODES )
+    {
+        m_triangulation.reset();
+        m_triangNodes.clear();
+    }
 }
 
 
-void RN_NET::clearNode( const RN_NODE_PTR& aNode )
+bool RN_NET::updateTriangulation()
 {
-    if( !m_rnEdges )
-        return;
+    if( !m_triangulation )
+        return false;
 
-    std::vector<RN_EDGE_MST_PTR>::iterator newEnd;
+    const boost::unordered_set<RN_NODE_ID>& added = m_links.GetAddedNodes();
+    const boost::unordered_set<RN_NODE_ID>& removed = m_links.GetRemovedNodes();
 
-    // Remove all ratsnest edges for associated with the node
-    newEnd = std::remove_if( m_rnEdges->begin(), m_rnEdges->end(),
-                             boost::bind( isEdgeConnectingNode, _1, boost::cref( aNode ) ) );
+    // Many changes (e.g. a board being loaded) are processed faster from scratch
+    if( ( added.size() + removed.size() ) * 4 > m_links.GetNodeCount() )
+        return false;
 
-    m_rnEdges->resize( std::distance( m_rnEdges->begin(), newEnd ) );
-}
+    // New nodes must lie in the area covered by the triangulation
+    BOOST_FOREACH( RN_NODE_ID node, added )
+    {
+        if( !m_triangArea.Contains( m_links.GetNode( node ).GetX(),
+                                    m_links.GetNode( node ).GetY() ) )
+            return false;
+    }
+
+    // Removed nodes are found by their triangulation node, as their slot may be used already
+    BOOST_FOREACH( RN_NODE_ID node, removed )
+    {
+        if( node >= m_triangNodes.size() || !m_triangNodes[node] ||
+                !m_triangulation->RemoveNode( m_triangNodes[node] ) )
+            return false;
 
+        m_triangNodes[node].reset();
+    }
 
-RN_POLY::RN_POLY( const CPolyPt* aBegin, const CPolyPt* aEnd,
-                  RN_LINKS& aConnections, const BOX2I& aBBox ) :
-    m_begin( aBegin ), m_end( aEnd ), m_bbox( aBBox )
-{
-    m_node = aConnections.AddNode( m_begin->x, m_begin->y );
+    BOOST_FOREACH( RN_NODE_ID node, added )
+    {
+        hed::NODE_PTR triangNode = boost::make_shared<hed::NODE>( m_links.GetNode( node ).GetX(),
+                                                                  m_links.GetNode( node ).GetY() );
+        triangNode->SetTag( node );
 
-    // Mark it as not appropriate as a destination of ratsnest edges
-    // (edges coming out from a polygon vertex look weird)
-    m_node->SetFlag( true );
+        if( !m_triangulation->InsertNode( triangNode ) )
+            return false;
+
+        if( node >= m_triangNodes.size() )
+            m_triangNodes.resize( m_links.GetNodes().size() );
+
+        m_triangNodes[node] = triangNode;
+    }
+
+    return true;
 }
 
 
-bool RN_POLY::HitTest( const RN_NODE_PTR& aNode ) const
+void RN_NET::createTriangulation( const std::vector<RN_NODE_ID>& aNodes )
 {
-    long xt = aNode->GetX();
-    long yt = aNode->GetY();
+    m_triangulation.reset( new TRIANGULATOR );
+    m_triangNodes.clear();
 
-    // If the point lies outside the bounding box, there is no point to check it further
-    if( !m_bbox.Contains( xt, yt ) )
-        return false;
+    // TTL works with shared nodes: they are allocated in a single block, each one is tagged with
+    // the index of the ratsnest node it stands for
+    boost::shared_ptr< std::vector<hed::NODE> > block =
+        boost::make_shared< std::vector<hed::NODE> >();
+    block->reserve( aNodes.size() );
 
-    long xNew, yNew, xOld, yOld, x1, y1, x2, y2;
-    bool inside = false;
+    for( unsigned int i = 0; i < aNodes.size(); ++i )
+    {
+        const RN_NODE& node = m_links.GetNode( aNodes[i] );
+        block->push_back( hed::NODE( node.GetX(), node.GetY() ) );
+        block->back().SetTag( aNodes[i] );
+    }
 
-    // For the first loop we have to use the last point as the previous point
-    xOld = m_end->x;
-    yOld = m_end->y;
+    hed::NODES_CONTAINER nodes( aNodes.size() );
 
-    for( const CPolyPt* point = m_begin; point <= m_end; ++point )
-    {
-        xNew = point->x;
-        yNew = point->y;
+    for( unsigned int i = 0; i < aNodes.size(); ++i )
+        nodes[i] = hed::NODE_PTR( block, &(*block)[i] );
 
-        // Swap points if needed, so always x2 >= x1
-        if( xNew > xOld )
-        {
-            x1 = xOld; y1 = yOld;
-            x2 = xNew; y2 = yNew;
-        }
-        else
+    if( aNodes.size() >= INCREMENTAL_MIN_NODES )
+    {
+        BOX2I bbox;
+        bbox.SetOrigin( nodes[0]->GetX(), nodes[0]->GetY() );
+
+        for( unsigned int i = 1; i < nodes.size(); ++i )
+            bbox.Merge( VECTOR2I( nodes[i]->GetX(), nodes[i]->GetY() ) );
+
+        // Leave some room for nodes to be moved or added around the existing ones
+        int size = std::max( bbox.GetWidth(), bbox.GetHeight() );
+        BOX2I area = bbox;
+        area.Inflate( size / 4 + 1 );
+
+        // The corners of the triangulation have to be far enough from the nodes, so they do not
+        // change the edges of the minimal spanning tree (no corner may lie in a circle having a
+        // pair of nodes as diameter)
+        int64_t margin = 2 * (int64_t) std::max( area.GetWidth(), area.GetHeight() );
+        int64_t xmin = (int64_t) area.GetLeft() - margin;
+        int64_t ymin = (int64_t) area.GetTop() - margin;
+        int64_t xmax = (int64_t) area.GetRight() + margin;
+        int64_t ymax = (int64_t) area.GetBottom() + margin;
+
+        if( xmin > std::numeric_limits<int>::min() && ymin > std::numeric_limits<int>::min() &&
+            xmax < std::numeric_limits<int>::max() && ymax < std::numeric_limits<int>::max() )
         {
-            x1 = xNew; y1 = yNew;
-            x2 = xOld; y2 = yOld;
-        }
+            m_triangArea = area;
+            m_triangulation->CreateDelaunay( nodes.begin(), nodes.end(),
+                                             xmin, ymin, xmax, ymax );
 
-        if( ( xNew < xt ) == ( xt <= xOld ) && /* edge "open" at left end */
-          (double)( yt - y1 ) * (double)( x2 - x1 ) < (double)( y2 - y1 ) * (double)( xt - x1 ) )
-        {
-            inside = !inside;
-        }
+            // Keep the nodes, so they can be removed from the triangulation later
+            m_triangNodes.resize( m_links.GetNodes().size() );
+
+            for( unsigned int i = 0; i < aNodes.size(); ++i )
+                m_triangNodes[aNodes[i]] = nodes[i];
 
-        xOld = xNew;
-        yOld = yNew;
+            return;
+        }
     }
 
-    return inside;
+    // The usual triangulation, it cannot be updated
+    m_triangulation->CreateDelaunay( nodes.begin(), nodes.end() );
+    m_triangArea = BOX2I();
+}
+
+
+void RN_NET::clearNode( RN_NODE_ID aNode )
+{
+    // The slot of the node may be used by another node later
+    m_blockedNodes.erase( aNode );
+    m_simpleNodes.erase( aNode );
+
+    // Remove all ratsnest edges for associated with the node
+    m_rnEdges.erase( std::remove_if( m_rnEdges.begin(), m_rnEdges.end(),
+                                     boost::bind( isEdgeConnectingNode, _1, aNode ) ),
+                     m_rnEdges.end() );
+    ++m_revision;
+}
+
+
+RN_POLY::RN_POLY( const CPolyPt* aBegin, const CPolyPt* aEnd,
+                  RN_LINKS& aConnections, const BOX2I& aBBox ) :
+    m_edges( boost::make_shared<POLY_EDGE_GRID>() ), m_bbox( aBBox )
+{
+    m_edges->Build( aBegin, aEnd );
+    m_node = aConnections.AddNode( aBegin->x, aBegin->y );
+
+    // Mark it as not appropriate as a destination of ratsnest edges
+    // (edges coming out from a polygon vertex look weird)
+    aConnections.GetNode( m_node ).SetFlag( true );
+}
+
+
+bool RN_POLY::HitTest( const RN_NODE& aNode ) const
+{
+    return m_edges->Contains( aNode.GetX(), aNode.GetY() );
 }
 
 
 void RN_NET::Update()
 {
+    // Contiguous array of the nodes, sorted by their X coordinate: it is used to look for
+    // the nodes inside zones and, as sorting speeds up, for the Delaunay triangulation
+    const std::vector<RN_NODE>& arena = m_links.GetNodes();
+    std::vector<RN_NODE_ID> nodes;
+    nodes.reserve( m_links.GetNodeCount() );
+
+    for( unsigned int i = 0; i < arena.size(); ++i )
+    {
+        if( arena[i].IsUsed() )
+            nodes.push_back( i );
+    }
+
+    std::sort( nodes.begin(), nodes.end(), RN_SORT_NODE_X( arena ) );
+
     // Add edges resulting from nodes being connected by zones
-    processZones();
+    processZones( nodes );
 
-    compute();
+    compute( nodes );
 
-    BOOST_FOREACH( RN_EDGE_MST_PTR& edge, *m_rnEdges )
+    BOOST_FOREACH( RN_EDGE& edge, m_rnEdges )
         validateEdge( edge );
 
+    ++m_revision;
     m_dirty = false;
 }
 
 
 void RN_NET::AddItem( const D_PAD* aPad )
 {
-    RN_NODE_PTR node = m_links.AddNode( aPad->GetPosition().x, aPad->GetPosition().y );
-    node->AddParent( aPad );
+    RN_NODE_ID node = m_links.AddNode( aPad->GetPosition().x, aPad->GetPosition().y );
+    m_links.GetNode( node ).AddParent( aPad );
     m_pads[aPad] = node;
 
     m_dirty = true;
@@ -427,8 +821,8 @@ void RN_NET::AddItem( const D_PAD* aPad )
 
 void RN_NET::AddItem( const VIA* aVia )
 {
-    RN_NODE_PTR node = m_links.AddNode( aVia->GetPosition().x, aVia->GetPosition().y );
-    node->AddParent( aVia );
+    RN_NODE_ID node = m_links.AddNode( aVia->GetPosition().x, aVia->GetPosition().y );
+    m_links.GetNode( node ).AddParent( aVia );
     m_vias[aVia] = node;
 
     m_dirty = true;
@@ -440,11 +834,11 @@ void RN_NET::AddItem( const TRACK* aTrack )
     if( aTrack->GetStart() == aTrack->GetEnd() )
         return;
 
-    RN_NODE_PTR start = m_links.AddNode( aTrack->GetStart().x, aTrack->GetStart().y );
-    RN_NODE_PTR end = m_links.AddNode( aTrack->GetEnd().x, aTrack->GetEnd().y );
+    RN_NODE_ID start = m_links.AddNode( aTrack->GetStart().x, aTrack->GetStart().y );
+    RN_NODE_ID end = m_links.AddNode( aTrack->GetEnd().x, aTrack->GetEnd().y );
 
-    start->AddParent( aTrack );
-    end->AddParent( aTrack );
+    m_links.GetNode( start ).AddParent( aTrack );
+    m_links.GetNode( end ).AddParent( aTrack );
     m_tracks[aTrack] = m_links.AddConnection( start, end );
 
     m_dirty = true;
@@ -473,7 +867,7 @@ void RN_NET::AddItem( const ZONE_CONTAINER* aZone )
         {
             RN_POLY poly = RN_POLY( &polyPoints[idxStart], &point,
                                     m_links, BOX2I( origin, end - origin ) );
-            poly.GetNode()->AddParent( aZone );
+            m_links.GetNode( poly.GetNode() ).AddParent( aZone );
             m_zones[aZone].m_Polygons.push_back( poly );
 
             idxStart = i + 1;
@@ -509,8 +903,8 @@ void RN_NET::RemoveItem( const D_PAD* aPad )
 {
     try
     {
-        RN_NODE_PTR node = m_pads.at( aPad );
-        node->RemoveParent( aPad );
+        RN_NODE_ID node = m_pads.at( aPad );
+        m_links.GetNode( node ).RemoveParent( aPad );
 
         if( m_links.RemoveNode( node ) )
             clearNode( node );
@@ -529,8 +923,8 @@ void RN_NET::RemoveItem( const VIA* aVia )
 {
     try
     {
-        RN_NODE_PTR node = m_vias.at( aVia );
-        node->RemoveParent( aVia );
+        RN_NODE_ID node = m_vias.at( aVia );
+        m_links.GetNode( node ).RemoveParent( aVia );
 
         if( m_links.RemoveNode( node ) )
             clearNode( node );
@@ -549,13 +943,13 @@ void RN_NET::RemoveItem( const TRACK* aTrack )
 {
     try
     {
-        RN_EDGE_MST_PTR& edge = m_tracks.at( aTrack );
+        RN_EDGE_ID edge = m_tracks.at( aTrack );
 
         // Save nodes, so they can be cleared later
-        RN_NODE_PTR start = edge->GetSourceNode();
-        start->RemoveParent( aTrack );
-        RN_NODE_PTR end = edge->GetTargetNode();
-        end->RemoveParent( aTrack );
+        RN_NODE_ID start = m_links.GetConnection( edge ).GetSourceNode();
+        m_links.GetNode( start ).RemoveParent( aTrack );
+        RN_NODE_ID end = m_links.GetConnection( edge ).GetTargetNode();
+        m_links.GetNode( end ).RemoveParent( aTrack );
 
         m_links.RemoveConnection( edge );
 
@@ -585,8 +979,8 @@ void RN_NET::RemoveItem( const ZONE_CONTAINER* aZone )
         std::deque<RN_POLY>& polygons = m_zones.at( aZone ).m_Polygons;
         BOOST_FOREACH( RN_POLY& polygon, polygons )
         {
-            RN_NODE_PTR node = polygon.GetNode();
-            node->RemoveParent( aZone );
+            RN_NODE_ID node = polygon.GetNode();
+            m_links.GetNode( node ).RemoveParent( aZone );
 
             if( m_links.RemoveNode( node ) )
                 clearNode( node );
@@ -594,8 +988,8 @@ void RN_NET::RemoveItem( const ZONE_CONTAINER* aZone )
         polygons.clear();
 
         // Remove all connections added by the zone
-        std::deque<RN_EDGE_MST_PTR>& edges = m_zones.at( aZone ).m_Edges;
-        BOOST_FOREACH( RN_EDGE_PTR edge, edges )
+        std::deque<RN_EDGE_ID>& edges = m_zones.at( aZone ).m_Edges;
+        BOOST_FOREACH( RN_EDGE_ID edge, edges )
             m_links.RemoveConnection( edge );
         edges.clear();
 
@@ -607,58 +1001,34 @@ void RN_NET::RemoveItem( const ZONE_CONTAINER* aZone )
 }
 
 
-const RN_NODE_PTR RN_NET::GetClosestNode( const RN_NODE_PTR& aNode ) const
+RN_NODE_ID RN_NET::GetClosestNode( RN_NODE_ID aNode ) const
 {
-    const RN_LINKS::RN_NODE_SET& nodes = m_links.GetNodes();
-    RN_LINKS::RN_NODE_SET::const_iterator it, itEnd;
-
-    unsigned int minDistance = std::numeric_limits<unsigned int>::max();
-    RN_NODE_PTR closest;
-
-    for( it = nodes.begin(), itEnd = nodes.end(); it != itEnd; ++it )
-    {
-        RN_NODE_PTR node = *it;
-
-        // Obviously the distance between node and itself is the shortest,
-        // that's why we have to skip it
-        if( node != aNode )
-        {
-            unsigned int distance = getDistance( node, aNode );
-            if( distance < minDistance )
-            {
-                minDistance = distance;
-                closest = node;
-            }
-        }
-    }
-
-    return closest;
+    return GetClosestNode( aNode, RN_NODE_FILTER() );
 }
 
 
-const RN_NODE_PTR RN_NET::GetClosestNode( const RN_NODE_PTR& aNode,
-                                          const RN_NODE_FILTER& aFilter ) const
+RN_NODE_ID RN_NET::GetClosestNode( RN_NODE_ID aNode, const RN_NODE_FILTER& aFilter ) const
 {
-    const RN_LINKS::RN_NODE_SET& nodes = m_links.GetNodes();
-    RN_LINKS::RN_NODE_SET::const_iterator it, itEnd;
+    const std::vector<RN_NODE>& nodes = m_links.GetNodes();
+    const RN_NODE& origin = nodes[aNode];
 
     unsigned int minDistance = std::numeric_limits<unsigned int>::max();
-    RN_NODE_PTR closest;
+    RN_NODE_ID closest = RN_NO_NODE;
 
-    for( it = nodes.begin(), itEnd = nodes.end(); it != itEnd; ++it )
+    for( unsigned int i = 0; i < nodes.size(); ++i )
     {
-        RN_NODE_PTR node = *it;
+        const RN_NODE& node = nodes[i];
 
         // Obviously the distance between node and itself is the shortest,
         // that's why we have to skip it
-        if( node != aNode && aFilter( node ) )
+        if( i != aNode && node.IsUsed() && aFilter( node ) )
         {
-            unsigned int distance = getDistance( node, aNode );
+            unsigned int distance = getDistance( node, origin );
 
             if( distance < minDistance )
             {
                 minDistance = distance;
-                closest = node;
+                closest = i;
             }
         }
     }
@@ -667,53 +1037,32 @@ const RN_NODE_PTR RN_NET::GetClosestNode( const RN_NODE_PTR& aNode,
 }
 
 
-std::list<RN_NODE_PTR> RN_NET::GetClosestNodes( const RN_NODE_PTR& aNode, int aNumber ) const
+std::list<RN_NODE_ID> RN_NET::GetClosestNodes( RN_NODE_ID aNode, int aNumber ) const
 {
-    std::list<RN_NODE_PTR> closest;
-    const RN_LINKS::RN_NODE_SET& nodes = m_links.GetNodes();
-
-    // Copy nodes
-    BOOST_FOREACH( const RN_NODE_PTR& node, nodes )
-        closest.push_back( node );
-
-    // Sort by the distance from aNode
-    closest.sort( boost::bind( sortDistance, boost::cref( aNode ), _1, _2 ) );
-
-    // Remove the first node (==aNode), as it is surely located within the smallest distance
-    assert( closest.front() == aNode );
-    closest.pop_front();
-
-    // Trim the result to the asked size
-    if( aNumber > 0 )
-        closest.resize( std::min( (size_t)aNumber, nodes.size() ) );
-
-    return closest;
+    return GetClosestNodes( aNode, RN_NODE_FILTER(), aNumber );
 }
 
 
-std::list<RN_NODE_PTR> RN_NET::GetClosestNodes( const RN_NODE_PTR& aNode,
-                                                const RN_NODE_FILTER& aFilter, int aNumber ) const
+std::list<RN_NODE_ID> RN_NET::GetClosestNodes( RN_NODE_ID aNode, const RN_NODE_FILTER& aFilter,
+                                               int aNumber ) const
 {
-    std::list<RN_NODE_PTR> closest;
-    const RN_LINKS::RN_NODE_SET& nodes = m_links.GetNodes();
+    std::list<RN_NODE_ID> closest;
+    const std::vector<RN_NODE>& nodes = m_links.GetNodes();
 
-    // Copy nodes
-    BOOST_FOREACH( const RN_NODE_PTR& node, nodes )
-        closest.push_back( node );
+    // Copy nodes (but aNode, as it is surely located within the smallest distance),
+    // filtering them out by condition
+    for( unsigned int i = 0; i < nodes.size(); ++i )
+    {
+        if( i != aNode && nodes[i].IsUsed() && aFilter( nodes[i] ) )
+            closest.push_back( i );
+    }
 
     // Sort by the distance from aNode
-    closest.sort( boost::bind( sortDistance, boost::cref( aNode ), _1, _2 ) );
-
-    // Remove the first node (==aNode), as it is surely located within the smallest distance
-    assert( closest.front() == aNode );
-    closest.pop_front();
-
-    // Filter out by condition
-    std::remove_if( closest.begin(), closest.end(), aFilter );
+    closest.sort( RN_DISTANCE_COMPARE( nodes, nodes[aNode] ) );
 
     // Trim the result to the asked size
-    if( aNumber > 0 )
-        closest.resize( std::min( static_cast<size_t>( aNumber ), nodes.size() ) );
+    if( aNumber > 0 && (size_t) aNumber < closest.size() )
+        closest.resize( aNumber );
 
     return closest;
 }
@@ -721,21 +1070,21 @@ std::list<RN_NODE_PTR> RN_NET::GetClosestNodes( const RN_NODE_PTR& aNode,
 
 void RN_NET::AddSimple( const BOARD_CONNECTED_ITEM* aItem )
 {
-    BOOST_FOREACH( RN_NODE_PTR node, GetNodes( aItem ) )
+    BOOST_FOREACH( RN_NODE_ID node, GetNodes( aItem ) )
     {
         // Block all nodes, so they do not become targets for dynamic ratsnest lines
         AddBlockedNode( node );
 
         // Filter out junctions
-        if( node->GetRefCount() == 1 )
+        if( m_links.GetNode( node ).GetRefCount() == 1 )
             m_simpleNodes.insert( node );
     }
 }
 
 
-std::list<RN_NODE_PTR> RN_NET::GetNodes( const BOARD_CONNECTED_ITEM* aItem ) const
+std::list<RN_NODE_ID> RN_NET::GetNodes( const BOARD_CONNECTED_ITEM* aItem ) const
 {
-    std::list<RN_NODE_PTR> nodes;
+    std::list<RN_NODE_ID> nodes;
 
     try
     {
@@ -758,10 +1107,10 @@ std::list<RN_NODE_PTR> RN_NET::GetNodes( const BOARD_CONNECTED_ITEM* aItem ) con
         case PCB_TRACE_T:
         {
             const TRACK* track = static_cast<const TRACK*>( aItem );
-            const RN_EDGE_MST_PTR& edge = m_tracks.at( track );
+            const RN_EDGE& edge = m_links.GetConnection( m_tracks.at( track ) );
 
-            nodes.push_back( edge->GetSourceNode() );
-            nodes.push_back( edge->GetTargetNode() );
+            nodes.push_back( edge.GetSourceNode() );
+            nodes.push_back( edge.GetTargetNode() );
         }
         break;
 
@@ -818,8 +1167,8 @@ void RN_NET::GetAllItems( std::list<BOARD_CONNECTED_ITEM*>& aOutput, RN_ITEM_TYP
 
 void RN_NET::ClearSimple()
 {
-    BOOST_FOREACH( const RN_NODE_PTR& node, m_blockedNodes )
-        node->SetFlag( false );
+    BOOST_FOREACH( RN_NODE_ID node, m_blockedNodes )
+        m_links.GetNode( node ).SetFlag( false );
 
     m_blockedNodes.clear();
     m_simpleNodes.clear();
@@ -830,17 +1179,17 @@ void RN_NET::GetConnectedItems( const BOARD_CONNECTED_ITEM* aItem,
                                 std::list<BOARD_CONNECTED_ITEM*>& aOutput,
                                 RN_ITEM_TYPE aTypes ) const
 {
-    std::list<RN_NODE_PTR> nodes = GetNodes( aItem );
+    std::list<RN_NODE_ID> nodes = GetNodes( aItem );
     assert( !nodes.empty() );
 
-    int tag = nodes.front()->GetTag();
+    int tag = m_links.GetNode( nodes.front() ).GetTag();
     assert( tag >= 0 );
 
     if( aTypes & RN_PADS )
     {
         for( PAD_NODE_MAP::const_iterator it = m_pads.begin(); it != m_pads.end(); ++it )
         {
-            if( it->second->GetTag() == tag )
+            if( m_links.GetNode( it->second ).GetTag() == tag )
                 aOutput.push_back( const_cast<D_PAD*>( it->first ) );
         }
     }
@@ -849,7 +1198,7 @@ void RN_NET::GetConnectedItems( const BOARD_CONNECTED_ITEM* aItem,
     {
         for( VIA_NODE_MAP::const_iterator it = m_vias.begin(); it != m_vias.end(); ++it )
         {
-            if( it->second->GetTag() == tag )
+            if( m_links.GetNode( it->second ).GetTag() == tag )
                 aOutput.push_back( const_cast<VIA*>( it->first ) );
         }
     }
@@ -858,7 +1207,7 @@ void RN_NET::GetConnectedItems( const BOARD_CONNECTED_ITEM* aItem,
     {
         for( TRACK_EDGE_MAP::const_iterator it = m_tracks.begin(); it != m_tracks.end(); ++it )
         {
-            if( it->second->GetTag() == tag )
+            if( m_links.GetTag( m_links.GetConnection( it->second ) ) == tag )
                 aOutput.push_back( const_cast<TRACK*>( it->first ) );
         }
     }
@@ -867,9 +1216,9 @@ void RN_NET::GetConnectedItems( const BOARD_CONNECTED_ITEM* aItem,
     {
         for( ZONE_DATA_MAP::const_iterator it = m_zones.begin(); it != m_zones.end(); ++it )
         {
-            BOOST_FOREACH( const RN_EDGE_MST_PTR& edge, it->second.m_Edges )
+            BOOST_FOREACH( RN_EDGE_ID edge, it->second.m_Edges )
             {
-                if( edge->GetTag() == tag )
+                if( m_links.GetTag( m_links.GetConnection( edge ) ) == tag )
                 {
                     aOutput.push_back( const_cast<ZONE_CONTAINER*>( it->first ) );
                     break;
@@ -921,7 +1270,7 @@ void RN_DATA::AddBlocked( const BOARD_ITEM* aItem )
             return;
 
         // Block all nodes belonging to the item
-        BOOST_FOREACH( RN_NODE_PTR node, m_nets[net].GetNodes( item ) )
+        BOOST_FOREACH( RN_NODE_ID node, m_nets[net].GetNodes( item ) )
             m_nets[net].AddBlockedNode( node );
     }
     else if( aItem->Type() == PCB_MODULE_T )
@@ -976,32 +1325,39 @@ bool RN_DATA::AreConnected( const BOARD_CONNECTED_ITEM* aItem, const BOARD_CONNE
     assert( net1 < (int) m_nets.size() && net2 < (int) m_nets.size() );
 
     // net1 == net2
-    std::list<RN_NODE_PTR> items1 = m_nets[net1].GetNodes( aItem );
-    std::list<RN_NODE_PTR> items2 = m_nets[net1].GetNodes( aOther );
+    const RN_NET& net = m_nets[net1];
+    std::list<RN_NODE_ID> items1 = net.GetNodes( aItem );
+    std::list<RN_NODE_ID> items2 = net.GetNodes( aOther );
 
     assert( !items1.empty() && !items2.empty() );
 
-    return ( items1.front()->GetTag() == items2.front()->GetTag() );
+    return ( net.GetNode( items1.front() ).GetTag() == net.GetNode( items2.front() ).GetTag() );
 }
 
 
-void RN_NET::processZones()
+void RN_NET::processZones( const std::vector<RN_NODE_ID>& aNodes )
 {
+    // Nodes are sorted by their X coordinate, so the nodes lying in the bounding box of a polygon
+    // are found with a binary search instead of testing every node of the net
+    const std::vector<RN_NODE>& arena = m_links.GetNodes();
+
+    // Nodes already connected to a polygon of the processed zone
+    std::vector<bool> connected;
+
     for( ZONE_DATA_MAP::iterator it = m_zones.begin(); it != m_zones.end(); ++it )
     {
         const ZONE_CONTAINER* zone = it->first;
         RN_ZONE_DATA& zoneData = it->second;
 
         // Reset existing connections
-        BOOST_FOREACH( RN_EDGE_MST_PTR edge, zoneData.m_Edges )
+        BOOST_FOREACH( RN_EDGE_ID edge, zoneData.m_Edges )
             m_links.RemoveConnection( edge );
 
         zoneData.m_Edges.clear();
         LSET layers = zone->GetLayerSet();
 
         // Compute new connections
-        RN_LINKS::RN_NODE_SET candidates = m_links.GetNodes();
-        RN_LINKS::RN_NODE_SET::iterator point, pointEnd;
+        connected.assign( aNodes.size(), false );
 
         // Sorting by area should speed up the processing, as smaller polygons are computed
         // faster and may reduce the number of points for further checks
@@ -1010,26 +1366,34 @@ void RN_NET::processZones()
         for( std::deque<RN_POLY>::iterator poly = zoneData.m_Polygons.begin(),
                 polyEnd = zoneData.m_Polygons.end(); poly != polyEnd; ++poly )
         {
-            const RN_NODE_PTR& node = poly->GetNode();
+            RN_NODE_ID node = poly->GetNode();
+            const BOX2I& bbox = poly->GetBBox();
 
-            point = candidates.begin();
-            pointEnd = candidates.end();
+            std::vector<RN_NODE_ID>::const_iterator first =
+                std::lower_bound( aNodes.begin(), aNodes.end(), bbox.GetLeft(),
+                                  RN_COMPARE_NODE_X( arena ) );
 
-            while( point != pointEnd )
+            for( std::vector<RN_NODE_ID>::const_iterator point = first;
+                    point != aNodes.end() && arena[*point].GetX() <= bbox.GetRight(); ++point )
             {
-                if( *point != node && ( (*point)->GetLayers() & layers ).any()
-                        && poly->HitTest( *point ) )
+                int idx = point - aNodes.begin();
+
+                if( connected[idx] )
+                    continue;
+
+                int y = arena[*point].GetY();
+
+                if( y < bbox.GetTop() || y > bbox.GetBottom() )
+                    continue;
+
+                if( *point != node && ( m_links.GetNode( *point ).GetLayers() & layers ).any()
+                        && poly->HitTest( arena[*point] ) )
                 {
-                    RN_EDGE_MST_PTR connection = m_links.AddConnection( node, *point );
+                    RN_EDGE_ID connection = m_links.AddConnection( node, *point );
                     zoneData.m_Edges.push_back( connection );
 
                     // This point already belongs to a polygon, we do not need to check it anymore
-                    point = candidates.erase( point );
-                    pointEnd = candidates.end();
-                }
-                else
-                {
-                    ++point;
+                    connected[idx] = true;
                 }
             }
         }
@@ -1180,6 +1544,7 @@ void RN_DATA::ProcessBoard()
     int netCount = m_board->GetNetCount();
     m_nets.clear();
     m_nets.resize( netCount );
+    ++m_revision;
     int netCode;
 
     // Iterate over all items that may need to be connected
@@ -1253,10 +1618,17 @@ void RN_DATA::Recalculate( int aNet )
             // Start with net number 1, as 0 stands for not connected
             for( i = 1; i < netCount; ++i )
             {
-                if( m_nets[i].IsDirty() )
+                // Large nets are computed afterwards, each one by all the threads
+                if( m_nets[i].IsDirty() && !m_nets[i].IsLarge() )
                     updateNet( i );
             }
         }  /* end of parallel section */
+
+        for( i = 1; i < netCount; ++i )
+        {
+            if( m_nets[i].IsDirty() )
+                updateNet( i );
+        }
 #ifdef PROFILE
     prof_end( &totalRealTime );
 
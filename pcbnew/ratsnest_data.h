@@ -32,8 +32,10 @@
 
 #include <ttl/halfedge/hetriang.h>
 #include <ttl/halfedge/hetraits.h>
+#include <layers_id_colors_and_visibility.h>
 
 #include <math/box2.h>
+#include <poly_edge_grid.h>
 
 #include <boost/unordered_set.hpp>
 #include <boost/unordered_map.hpp>
@@ -60,26 +62,176 @@ enum RN_ITEM_TYPE
 };
 
 // Preserve KiCad coding style policy
-typedef hed::NODE           RN_NODE;
-typedef hed::NODE_PTR       RN_NODE_PTR;
-typedef hed::EDGE           RN_EDGE;
-typedef hed::EDGE_PTR       RN_EDGE_PTR;
-typedef hed::EDGE_MST       RN_EDGE_MST;
 typedef hed::TRIANGULATION  TRIANGULATOR;
-typedef boost::shared_ptr<hed::EDGE_MST> RN_EDGE_MST_PTR;
 
-bool operator==( const RN_NODE_PTR& aFirst, const RN_NODE_PTR& aSecond );
-bool operator!=( const RN_NODE_PTR& aFirst, const RN_NODE_PTR& aSecond );
+///> Index of a node in the node arena of its net (see RN_LINKS).
+typedef unsigned int RN_NODE_ID;
+
+///> Index of an edge in the edge arena of its net (see RN_LINKS).
+typedef unsigned int RN_EDGE_ID;
+
+///> Value of RN_NODE_ID that does not refer to any node.
+const RN_NODE_ID RN_NO_NODE = 0xFFFFFFFF;
+
+
+/**
+ * Class RN_NODE
+ * Describes a point where items of a net are expected to be connected. Nodes are stored by value
+ * in the node arena of their net and are referred to by their index (RN_NODE_ID).
+ */
+class RN_NODE
+{
+public:
+    RN_NODE( int aX = 0, int aY = 0 ) :
+        m_x( aX ), m_y( aY ), m_tag( TAG_UNCONNECTED ), m_flag( false ), m_used( false )
+    {
+        m_layers.reset();
+    }
+
+    /// Returns the x-coordinate
+    inline int GetX() const
+    {
+        return m_x;
+    }
+
+    /// Returns the y-coordinate
+    inline int GetY() const
+    {
+        return m_y;
+    }
+
+    /// Returns tag, common identifier for connected nodes
+    inline int GetTag() const
+    {
+        return m_tag;
+    }
+
+    /// Sets tag, common identifier for connected nodes
+    inline void SetTag( int aTag )
+    {
+        m_tag = aTag;
+    }
+
+    /// Sets the flag
+    inline void SetFlag( bool aFlag )
+    {
+        m_flag = aFlag;
+    }
+
+    /// Returns the flag
+    inline bool GetFlag() const
+    {
+        return m_flag;
+    }
+
+    /// Returns true if the node is in use, false for a slot of a removed node
+    inline bool IsUsed() const
+    {
+        return m_used;
+    }
+
+    inline unsigned int GetRefCount() const
+    {
+        return m_parents.size();
+    }
+
+    void AddParent( const BOARD_CONNECTED_ITEM* aParent );
+
+    void RemoveParent( const BOARD_CONNECTED_ITEM* aParent );
+
+    const LSET& GetLayers()
+    {
+        if( m_layers.none() )
+            updateLayers();
+
+        return m_layers;
+    }
+
+    // Tag used for unconnected items.
+    static const int TAG_UNCONNECTED = -1;
+
+private:
+    /// Recomputes the layers used by this node
+    void updateLayers();
+
+    /// Node coordinates
+    int m_x, m_y;
+
+    /// Tag for quick connection resolution
+    int m_tag;
+
+    /// Flag (see WITHOUT_FLAG)
+    bool m_flag;
+
+    /// Set by RN_LINKS for the nodes in use
+    bool m_used;
+
+    /// List of board items that share this node
+    std::vector<const BOARD_CONNECTED_ITEM*> m_parents;
+
+    /// Layers that are occupied by this node
+    LSET m_layers;
+
+    friend class RN_LINKS;
+};
+
+
+/**
+ * Class RN_EDGE
+ * Describes a connection (existing or missing) between two nodes of the same net, given by their
+ * index in the node arena of the net.
+ */
+class RN_EDGE
+{
+public:
+    RN_EDGE( RN_NODE_ID aSource = 0, RN_NODE_ID aTarget = 0, unsigned int aWeight = 0 ) :
+        m_source( aSource ), m_target( aTarget ), m_weight( aWeight )
+    {}
+
+    /// Returns the source node
+    inline RN_NODE_ID GetSourceNode() const
+    {
+        return m_source;
+    }
+
+    /// Returns the target node
+    inline RN_NODE_ID GetTargetNode() const
+    {
+        return m_target;
+    }
+
+    inline void SetWeight( unsigned int aWeight )
+    {
+        m_weight = aWeight;
+    }
+
+    inline unsigned int GetWeight() const
+    {
+        return m_weight;
+    }
+
+    /// Returns true if the edge is in use, false for a slot of a removed edge
+    inline bool IsUsed() const
+    {
+        return m_source != m_target;
+    }
+
+private:
+    RN_NODE_ID      m_source;
+    RN_NODE_ID      m_target;
+    unsigned int    m_weight;
+};
+
 
 struct RN_NODE_OR_FILTER;
 struct RN_NODE_AND_FILTER;
 
 ///> General interface for filtering out nodes in search functions.
-struct RN_NODE_FILTER : public std::unary_function<const RN_NODE_PTR&, bool>
+struct RN_NODE_FILTER : public std::unary_function<const RN_NODE&, bool>
 {
     virtual ~RN_NODE_FILTER() {}
 
-    virtual bool operator()( const RN_NODE_PTR& aNode ) const
+    virtual bool operator()( const RN_NODE& aNode ) const
     {
         return true;        // By default everything passes
     }
@@ -94,9 +246,9 @@ RN_NODE_OR_FILTER operator||( const RN_NODE_FILTER& aFilter1, const RN_NODE_FILT
 ///> Filters out nodes that have the flag set.
 struct WITHOUT_FLAG : public RN_NODE_FILTER
 {
-    bool operator()( const RN_NODE_PTR& aNode ) const
+    bool operator()( const RN_NODE& aNode ) const
     {
-        return !aNode->GetFlag();
+        return !aNode.GetFlag();
     }
 };
 
@@ -107,9 +259,9 @@ struct DIFFERENT_TAG : public RN_NODE_FILTER
         m_tag( aTag )
     {}
 
-    bool operator()( const RN_NODE_PTR& aNode ) const
+    bool operator()( const RN_NODE& aNode ) const
     {
-        return aNode->GetTag() != m_tag;
+        return aNode.GetTag() != m_tag;
     }
 
     private:
@@ -122,7 +274,7 @@ struct RN_NODE_AND_FILTER : public RN_NODE_FILTER
         m_filter1( aFilter1 ), m_filter2( aFilter2 )
     {}
 
-    bool operator()( const RN_NODE_PTR& aNode ) const
+    bool operator()( const RN_NODE& aNode ) const
     {
         return m_filter1( aNode ) && m_filter2( aNode );
     }
@@ -138,7 +290,7 @@ struct RN_NODE_OR_FILTER : public RN_NODE_FILTER
         m_filter1( aFilter1 ), m_filter2( aFilter2 )
     {}
 
-    bool operator()( const RN_NODE_PTR& aNode ) const
+    bool operator()( const RN_NODE& aNode ) const
     {
         return m_filter1( aNode ) || m_filter2( aNode );
     }
@@ -149,27 +301,16 @@ struct RN_NODE_OR_FILTER : public RN_NODE_FILTER
 };
 
 
-///> Functor comparing if two nodes are equal by their coordinates. It is required to make set of
-///> shared pointers work properly.
-struct RN_NODE_COMPARE : std::binary_function<RN_NODE_PTR, RN_NODE_PTR, bool>
-{
-    bool operator()( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2 ) const
-    {
-        return aNode1 == aNode2;
-    }
-};
-
-///> Functor calculating hash for a given node. It is required to make set of shared pointers
-///> work properly.
-struct RN_NODE_HASH : std::unary_function<RN_NODE_PTR, std::size_t>
+///> Functor calculating hash for node coordinates, used to look for a node by its coordinates.
+struct RN_POINT_HASH : std::unary_function<VECTOR2I, std::size_t>
 {
-    std::size_t operator()( const RN_NODE_PTR& aNode ) const
+    std::size_t operator()( const VECTOR2I& aPoint ) const
     {
         std::size_t hash = 2166136261u;
 
-        hash ^= aNode->GetX();
+        hash ^= aPoint.x;
         hash *= 16777619;
-        hash ^= aNode->GetY();
+        hash ^= aPoint.y;
 
         return hash;
     }
@@ -178,43 +319,103 @@ struct RN_NODE_HASH : std::unary_function<RN_NODE_PTR, std::size_t>
 
 /**
  * Class RN_LINKS
- * Manages data describing nodes and connections for a given net.
+ * Manages data describing nodes and connections for a given net. Nodes and edges are stored
+ * in arenas (one per net) and referred to by their index, slots of removed nodes and edges are
+ * reused by the next added ones.
  */
 class RN_LINKS
 {
 public:
     // Helper typedefs
-    typedef boost::unordered_set<RN_NODE_PTR, RN_NODE_HASH, RN_NODE_COMPARE> RN_NODE_SET;
-    typedef std::list<RN_EDGE_PTR> RN_EDGE_LIST;
+    typedef boost::unordered_map<VECTOR2I, RN_NODE_ID, RN_POINT_HASH> RN_NODE_MAP;
+
+    RN_LINKS() : m_nodeCount( 0 ), m_edgeCount( 0 )
+    {}
 
     /**
      * Function AddNode()
-     * Adds a node with given coordinates and returns pointer to the newly added node. If the node
-     * existed before, only appropriate pointer is returned.
+     * Adds a node with given coordinates and returns its index. If the node existed before,
+     * only its index is returned.
      * @param aX is the x coordinate of a node.
      * @param aY is the y coordinate of a node.
-     * @return Pointer to the node with given coordinates.
+     * @return Index of the node with given coordinates.
      */
-    const RN_NODE_PTR& AddNode( int aX, int aY );
+    RN_NODE_ID AddNode( int aX, int aY );
 
     /**
      * Function RemoveNode()
-     * Removes a node described by a given node pointer.
-     * @param aNode is a pointer to node to be removed.
+     * Removes a node, if it is not used by any item anymore.
+     * @param aNode is the index of the node to be removed.
      * @return True if node was removed, false if there were other references, so it was kept.
      */
-    bool RemoveNode( const RN_NODE_PTR& aNode );
+    bool RemoveNode( RN_NODE_ID aNode );
+
+    /**
+     * Function GetNode()
+     * Returns the node stored at a given index.
+     */
+    RN_NODE& GetNode( RN_NODE_ID aNode )
+    {
+        return m_nodes[aNode];
+    }
+
+    const RN_NODE& GetNode( RN_NODE_ID aNode ) const
+    {
+        return m_nodes[aNode];
+    }
 
     /**
      * Function GetNodes()
-     * Returns the set of currently used nodes.
-     * @return The set of currently used nodes.
+     * Returns the node arena. It contains also the slots of removed nodes, which are not
+     * used (see RN_NODE::IsUsed()).
+     * @return The node arena.
      */
-    const RN_NODE_SET& GetNodes() const
+    const std::vector<RN_NODE>& GetNodes() const
     {
         return m_nodes;
     }
 
+    /**
+     * Function GetNodeCount()
+     * Returns the number of currently used nodes.
+     */
+    unsigned int GetNodeCount() const
+    {
+        return m_nodeCount;
+    }
+
+    /**
+     * Function GetAddedNodes()
+     * Returns the set of nodes added since the last call to ClearChanges().
+     * @return The set of added nodes.
+     */
+    const boost::unordered_set<RN_NODE_ID>& GetAddedNodes() const
+    {
+        return m_addedNodes;
+    }
+
+    /**
+     * Function GetRemovedNodes()
+     * Returns the set of nodes removed since the last call to ClearChanges() (nodes that were
+     * added and removed in the meantime are not listed). The slot of a removed node may be
+     * used by an added node already.
+     * @return The set of removed nodes.
+     */
+    const boost::unordered_set<RN_NODE_ID>& GetRemovedNodes() const
+    {
+        return m_removedNodes;
+    }
+
+    /**
+     * Function ClearChanges()
+     * Clears the sets of added and removed nodes.
+     */
+    void ClearChanges()
+    {
+        m_addedNodes.clear();
+        m_removedNodes.clear();
+    }
+
     /**
      * Function AddConnection()
      * Adds a connection between two nodes and of given distance. Edges with distance equal 0 are
@@ -224,36 +425,88 @@ public:
      * @param aNode2 is the end node of a new connection.
      * @param aDistance is the distance of the connection (0 means that nodes are actually
      * connected, >0 means a missing connection).
+     * @return Index of the new connection.
      */
-    RN_EDGE_MST_PTR AddConnection( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2,
-                                    unsigned int aDistance = 0 );
+    RN_EDGE_ID AddConnection( RN_NODE_ID aNode1, RN_NODE_ID aNode2, unsigned int aDistance = 0 );
 
     /**
      * Function RemoveConnection()
-     * Removes a connection described by a given edge pointer.
-     * @param aEdge is a pointer to edge to be removed.
+     * Removes a connection.
+     * @param aEdge is the index of the edge to be removed.
      */
-    void RemoveConnection( const RN_EDGE_PTR& aEdge )
+    void RemoveConnection( RN_EDGE_ID aEdge );
+
+    /**
+     * Function GetConnection()
+     * Returns the connection stored at a given index.
+     */
+    const RN_EDGE& GetConnection( RN_EDGE_ID aEdge ) const
     {
-        m_edges.remove( aEdge );
+        return m_edges[aEdge];
     }
 
     /**
      * Function GetConnections()
-     * Returns the list of edges that currently connect nodes.
-     * @return the list of edges that currently connect nodes.
+     * Returns the edge arena, i.e. the edges that currently connect nodes. It contains also the
+     * slots of removed edges, which are not used (see RN_EDGE::IsUsed()).
+     * @return The edge arena.
      */
-    const RN_EDGE_LIST& GetConnections() const
+    const std::vector<RN_EDGE>& GetConnections() const
     {
         return m_edges;
     }
 
+    /**
+     * Function GetConnectionCount()
+     * Returns the number of edges that currently connect nodes.
+     */
+    unsigned int GetConnectionCount() const
+    {
+        return m_edgeCount;
+    }
+
+    /**
+     * Function GetTag()
+     * Returns the tag of an edge, i.e. the tag of its source node, or of its target node if the
+     * source node is not tagged.
+     */
+    int GetTag( const RN_EDGE& aEdge ) const
+    {
+        int tag = m_nodes[aEdge.GetSourceNode()].GetTag();
+
+        if( tag >= 0 )
+            return tag;
+
+        return m_nodes[aEdge.GetTargetNode()].GetTag();
+    }
+
 protected:
-    ///> Set of nodes that are expected to be connected together (vias, tracks, pads).
-    RN_NODE_SET m_nodes;
+    ///> Nodes that are expected to be connected together (vias, tracks, pads).
+    std::vector<RN_NODE> m_nodes;
+
+    ///> Slots of removed nodes, to be reused.
+    std::vector<RN_NODE_ID> m_freeNodes;
 
-    ///> List of edges that currently connect nodes.
-    RN_EDGE_LIST m_edges;
+    ///> Number of used nodes.
+    unsigned int m_nodeCount;
+
+    ///> Indices of the nodes by their coordinates.
+    RN_NODE_MAP m_nodeIds;
+
+    ///> Edges that currently connect nodes.
+    std::vector<RN_EDGE> m_edges;
+
+    ///> Slots of removed edges, to be reused.
+    std::vector<RN_EDGE_ID> m_freeEdges;
+
+    ///> Number of used edges.
+    unsigned int m_edgeCount;
+
+    ///> Nodes added since the last call to ClearChanges().
+    boost::unordered_set<RN_NODE_ID> m_addedNodes;
+
+    ///> Nodes removed since the last call to ClearChanges().
+    boost::unordered_set<RN_NODE_ID> m_removedNodes;
 };
 
 
@@ -273,32 +526,39 @@ public:
      * Returns node representing a polygon (it has the same coordinates as the first point of its
      * bounding polyline.
      */
-    inline const RN_NODE_PTR& GetNode() const
+    inline RN_NODE_ID GetNode() const
     {
         return m_node;
     }
 
+    /**
+     * Function GetBBox()
+     * Returns the bounding box of the polygon.
+     */
+    inline const BOX2I& GetBBox() const
+    {
+        return m_bbox;
+    }
+
     /**
      * Function HitTest()
      * Tests if selected node is located within polygon boundaries.
      * @param aNode is a node to be checked.
      * @return True is the node is located within polygon boundaries.
      */
-    bool HitTest( const RN_NODE_PTR& aNode ) const;
+    bool HitTest( const RN_NODE& aNode ) const;
 
 private:
-    ///> Pointer to the first point of polyline bounding the polygon.
-    const CPolyPt* m_begin;
-
-    ///> Pointer to the last point of polyline bounding the polygon.
-    const CPolyPt* m_end;
+    ///> Edges of the polygon, for the point-inside-polygon test. It is shared by the copies
+    ///> of a polygon, so sorting polygons does not copy it.
+    boost::shared_ptr<POLY_EDGE_GRID> m_edges;
 
     ///> Bounding box of the polygon.
     BOX2I m_bbox;
 
     ///> Node representing a polygon (it has the same coordinates as the first point of its
     ///> bounding polyline.
-    RN_NODE_PTR m_node;
+    RN_NODE_ID m_node;
 
     friend bool sortArea( const RN_POLY& aP1, const RN_POLY& aP2 );
 };
@@ -312,7 +572,7 @@ class RN_NET
 {
 public:
     ///> Default constructor.
-    RN_NET() : m_dirty( true ), m_visible( true )
+    RN_NET() : m_dirty( true ), m_revision( 0 ), m_visible( true )
     {}
 
     /**
@@ -356,14 +616,48 @@ public:
         return m_dirty;
     }
 
+    /**
+     * Function IsLarge()
+     * Returns true if the net is large enough to have its ratsnest computed by several threads.
+     * @return True if the net has at least PARALLEL_MIN_NODES nodes.
+     */
+    bool IsLarge() const
+    {
+        return m_links.GetNodeCount() >= PARALLEL_MIN_NODES;
+    }
+
+    ///> Minimal number of nodes for the ratsnest of a net to be computed by several threads.
+    static const unsigned int PARALLEL_MIN_NODES = 2048;
+
     /**
      * Function GetUnconnected()
-     * Returns pointer to a vector of edges that makes ratsnest for a given net.
-     * @return Pointer to a vector of edges that makes ratsnest for a given net.
+     * Returns the vector of edges that makes ratsnest for a given net.
+     * @return Vector of edges that makes ratsnest for a given net.
+     */
+    const std::vector<RN_EDGE>& GetUnconnected() const
+    {
+        return m_rnEdges;
+    }
+
+    /**
+     * Function GetNode()
+     * Returns a node of the net, e.g. the source or the target node of a ratsnest edge.
+     * @param aNode is the index of the node.
      */
-    const std::vector<RN_EDGE_MST_PTR>* GetUnconnected() const
+    const RN_NODE& GetNode( RN_NODE_ID aNode ) const
     {
-        return m_rnEdges.get();
+        return m_links.GetNode( aNode );
+    }
+
+    /**
+     * Function GetRevision()
+     * Returns a number that changes each time the list of unconnected edges is modified, so
+     * data computed from the list (e.g. the lines to draw) can be reused until it changes.
+     * @return Revision number of the list returned by GetUnconnected().
+     */
+    unsigned int GetRevision() const
+    {
+        return m_revision;
     }
 
     /**
@@ -442,7 +736,7 @@ public:
      * @param aItem is an item for which the list is generated.
      * @return List of associated nodes.
      */
-    std::list<RN_NODE_PTR> GetNodes( const BOARD_CONNECTED_ITEM* aItem ) const;
+    std::list<RN_NODE_ID> GetNodes( const BOARD_CONNECTED_ITEM* aItem ) const;
 
     /**
      * Function GetAllNodes()
@@ -456,8 +750,9 @@ public:
      * Function GetClosestNode()
      * Returns a single node that lies in the shortest distance from a specific node.
      * @param aNode is the node for which the closest node is searched.
+     * @return The closest node or RN_NO_NODE if there is none.
      */
-    const RN_NODE_PTR GetClosestNode( const RN_NODE_PTR& aNode ) const;
+    RN_NODE_ID GetClosestNode( RN_NODE_ID aNode ) const;
 
     /**
      * Function GetClosestNode()
@@ -465,9 +760,9 @@ public:
      * selected filter criterion..
      * @param aNode is the node for which the closest node is searched.
      * @param aFilter is a functor that filters nodes.
+     * @return The closest node or RN_NO_NODE if there is none.
      */
-    const RN_NODE_PTR GetClosestNode( const RN_NODE_PTR& aNode,
-                                      const RN_NODE_FILTER& aFilter ) const;
+    RN_NODE_ID GetClosestNode( RN_NODE_ID aNode, const RN_NODE_FILTER& aFilter ) const;
 
     /**
      * Function GetClosestNodes()
@@ -477,7 +772,7 @@ public:
      * belong to the same net are returned. If asked number is greater than number of possible
      * nodes then the size of list is limited to number of possible nodes.
      */
-    std::list<RN_NODE_PTR> GetClosestNodes( const RN_NODE_PTR& aNode, int aNumber = -1 ) const;
+    std::list<RN_NODE_ID> GetClosestNodes( RN_NODE_ID aNode, int aNumber = -1 ) const;
 
     /**
      * Function GetClosestNodes()
@@ -488,8 +783,8 @@ public:
      * belong to the same net are returned. If asked number is greater than number of possible
      * nodes then the size of list is limited to number of possible nodes.
      */
-    std::list<RN_NODE_PTR> GetClosestNodes( const RN_NODE_PTR& aNode,
-                                            const RN_NODE_FILTER& aFilter, int aNumber = -1 ) const;
+    std::list<RN_NODE_ID> GetClosestNodes( RN_NODE_ID aNode, const RN_NODE_FILTER& aFilter,
+                                           int aNumber = -1 ) const;
 
     /**
      * Function AddSimple()
@@ -504,10 +799,10 @@ public:
      * target the node). The status is cleared after calling ClearSimple().
      * @param aNode is the node that is not going to be used as a ratsnest line target.
      */
-    inline void AddBlockedNode( RN_NODE_PTR& aNode )
+    inline void AddBlockedNode( RN_NODE_ID aNode )
     {
         m_blockedNodes.insert( aNode );
-        aNode->SetFlag( true );
+        m_links.GetNode( aNode ).SetFlag( true );
     }
 
     /**
@@ -516,7 +811,7 @@ public:
      * ratsnest line per node).
      * @return list of nodes for which ratsnest is drawn in simple mode.
      */
-    inline const boost::unordered_set<RN_NODE_PTR>& GetSimpleNodes() const
+    inline const boost::unordered_set<RN_NODE_ID>& GetSimpleNodes() const
     {
         return m_simpleNodes;
     }
@@ -541,45 +836,71 @@ public:
 protected:
     ///> Validates edge, i.e. modifies source and target nodes for an edge
     ///> to make sure that they are not ones with the flag set.
-    void validateEdge( RN_EDGE_MST_PTR& aEdge );
+    void validateEdge( RN_EDGE& aEdge );
 
-    ///> Removes all ratsnest edges for a given node.
-    void clearNode( const RN_NODE_PTR& aNode );
+    ///> Removes all ratsnest edges for a given node, which has been removed.
+    void clearNode( RN_NODE_ID aNode );
 
     ///> Adds appropriate edges for nodes that are connected by zones.
-    void processZones();
+    ///> aNodes are the used nodes, sorted by their X coordinate.
+    void processZones( const std::vector<RN_NODE_ID>& aNodes );
 
     ///> Recomputes ratsnset from scratch.
-    void compute();
+    ///> aNodes are the used nodes, sorted by their X coordinate.
+    void compute( const std::vector<RN_NODE_ID>& aNodes );
+
+    ///> Updates the stored triangulation with the nodes added and removed since the last update.
+    ///> Returns false if the triangulation has to be created from scratch instead.
+    bool updateTriangulation();
+
+    ///> Creates the triangulation of nodes. For large nets, the triangulation is stored, so it
+    ///> can be updated instead of created again during the next updates.
+    void createTriangulation( const std::vector<RN_NODE_ID>& aNodes );
+
+    ///> Minimal number of nodes for a net to keep its triangulation between updates.
+    static const unsigned int INCREMENTAL_MIN_NODES = 128;
 
     ////> Stores information about connections for a given net.
     RN_LINKS m_links;
 
     ///> Vector of edges that makes ratsnest for a given net.
-    boost::shared_ptr< std::vector<RN_EDGE_MST_PTR> > m_rnEdges;
+    std::vector<RN_EDGE> m_rnEdges;
+
+    ///> Delaunay triangulation of nodes, stored for large nets to be updated incrementally.
+    boost::shared_ptr<TRIANGULATOR> m_triangulation;
+
+    ///> Nodes of the stored triangulation, by the index of the ratsnest node they stand for
+    ///> (TTL works with its own shared nodes, tagged with that index).
+    std::vector<hed::NODE_PTR> m_triangNodes;
+
+    ///> Area where nodes may be inserted in the stored triangulation.
+    BOX2I m_triangArea;
 
     ///> List of nodes which will not be used as ratsnest target nodes.
-    boost::unordered_set<RN_NODE_PTR> m_blockedNodes;
+    boost::unordered_set<RN_NODE_ID> m_blockedNodes;
 
     ///> Nodes to be displayed using the simplified ratsnest algorithm.
-    boost::unordered_set<RN_NODE_PTR> m_simpleNodes;
+    boost::unordered_set<RN_NODE_ID> m_simpleNodes;
 
     ///> Flag indicating necessity of recalculation of ratsnest for a net.
     bool m_dirty;
 
+    ///> Revision of the ratsnest edges, see GetRevision().
+    unsigned int m_revision;
+
     typedef struct
     {
         ///> Subpolygons belonging to a zone
         std::deque<RN_POLY> m_Polygons;
 
         ///> Connections to other nodes
-        std::deque<RN_EDGE_MST_PTR> m_Edges;
+        std::deque<RN_EDGE_ID> m_Edges;
     } RN_ZONE_DATA;
 
     ///> Helper typedefs
-    typedef boost::unordered_map<const D_PAD*, RN_NODE_PTR> PAD_NODE_MAP;
-    typedef boost::unordered_map<const VIA*, RN_NODE_PTR> VIA_NODE_MAP;
-    typedef boost::unordered_map<const TRACK*, RN_EDGE_MST_PTR> TRACK_EDGE_MAP;
+    typedef boost::unordered_map<const D_PAD*, RN_NODE_ID> PAD_NODE_MAP;
+    typedef boost::unordered_map<const VIA*, RN_NODE_ID> VIA_NODE_MAP;
+    typedef boost::unordered_map<const TRACK*, RN_EDGE_ID> TRACK_EDGE_MAP;
     typedef boost::unordered_map<const ZONE_CONTAINER*, RN_ZONE_DATA> ZONE_DATA_MAP;
 
     ///> Map that associates nodes in the ratsnest model to respective nodes.
@@ -611,7 +932,7 @@ public:
      * Default constructor
      * @param aBoard is the board to be processed in order to look for unconnected items.
      */
-    RN_DATA( const BOARD* aBoard ) : m_board( aBoard ) {}
+    RN_DATA( const BOARD* aBoard ) : m_board( aBoard ), m_revision( 0 ) {}
 
     /**
      * Function Add()
@@ -697,6 +1018,17 @@ public:
         return m_nets[aNetCode];
     }
 
+    /**
+     * Function GetRevision()
+     * Returns a number that changes each time all the nets are created again (so revisions
+     * of nets obtained before are not meaningful anymore).
+     * @return Revision number of the nets list.
+     */
+    unsigned int GetRevision() const
+    {
+        return m_revision;
+    }
+
     /**
      * Function GetConnectedItems()
      * Adds items that are connected together to a list.
@@ -740,6 +1072,9 @@ protected:
 
     ///> Stores information about ratsnest grouped by net numbers.
     std::vector<RN_NET> m_nets;
+
+    ///> Revision of the nets list, see GetRevision().
+    unsigned int m_revision;
 };
 
 #endif /* RATSNEST_DATA_H */
@@ -38,7 +38,7 @@
 using namespace KIGFX;
 
 RATSNEST_VIEWITEM::RATSNEST_VIEWITEM( RN_DATA* aData ) :
-        EDA_ITEM( NOT_USED ), m_data( aData )
+        EDA_ITEM( NOT_USED ), m_data( aData ), m_linesRevision( 0 )
 {
 }
 
@@ -62,6 +62,19 @@ void RATSNEST_VIEWITEM::ViewDraw( int aLayer, GAL* aGal ) const
     COLOR4D color = rs->GetColor( NULL, ITEM_GAL_LAYER( RATSNEST_VISIBLE ) );
     int highlightedNet = rs->GetHighlightNetCode();
 
+    // Nets have been created again, cached lines are not valid anymore
+    if( m_linesRevision != m_data->GetRevision() )
+    {
+        m_lines.clear();
+        m_linesRevision = m_data->GetRevision();
+    }
+
+    if( (int) m_lines.size() < m_data->GetNetCount() )
+        m_lines.resize( m_data->GetNetCount() );
+
+    BOX2D viewport = m_view->GetViewport();
+    viewport.Normalize();
+
     // Dynamic ratsnest (for e.g. dragged items)
     for( int i = 1; i < m_data->GetNetCount(); ++i )
     {
@@ -74,18 +87,21 @@ void RATSNEST_VIEWITEM::ViewDraw( int aLayer, GAL* aGal ) const
         aGal->SetStrokeColor( color.Brightened( 0.8 ) );
 
         // Draw the "dynamic" ratsnest (i.e. for objects that may be currently being moved)
-        BOOST_FOREACH( const RN_NODE_PTR& node, net.GetSimpleNodes() )
+        BOOST_FOREACH( RN_NODE_ID nodeId, net.GetSimpleNodes() )
         {
+            const RN_NODE& node = net.GetNode( nodeId );
+
             // Skipping nodes with higher reference count avoids displaying redundant lines
-            if( node->GetRefCount() > 1 )
+            if( node.GetRefCount() > 1 )
                 continue;
 
-            RN_NODE_PTR dest = net.GetClosestNode( node, WITHOUT_FLAG() );
+            RN_NODE_ID destId = net.GetClosestNode( nodeId, WITHOUT_FLAG() );
 
-            if( dest )
+            if( destId != RN_NO_NODE )
             {
-                VECTOR2D origin( node->GetX(), node->GetY() );
-                VECTOR2D end( dest->GetX(), dest->GetY() );
+                const RN_NODE& dest = net.GetNode( destId );
+                VECTOR2D origin( node.GetX(), node.GetY() );
+                VECTOR2D end( dest.GetX(), dest.GetY() );
 
                 aGal->DrawLine( origin, end );
             }
@@ -95,20 +111,46 @@ void RATSNEST_VIEWITEM::ViewDraw( int aLayer, GAL* aGal ) const
         if( i != highlightedNet )
             aGal->SetStrokeColor( color );  // using the default ratsnest color for not highlighted
 
-        const std::vector<RN_EDGE_MST_PTR>* edges = net.GetUnconnected();
+        NET_LINES& lines = m_lines[i];
+        updateLines( net, lines );
 
-        if( edges == NULL )
+        if( lines.m_points.empty() || !lines.m_bbox.Intersects( viewport ) )
             continue;
 
-        BOOST_FOREACH( const RN_EDGE_MST_PTR& edge, *edges )
-        {
-            const RN_NODE_PTR& sourceNode = edge->GetSourceNode();
-            const RN_NODE_PTR& targetNode = edge->GetTargetNode();
-            VECTOR2D source( sourceNode->GetX(), sourceNode->GetY() );
-            VECTOR2D target( targetNode->GetX(), targetNode->GetY() );
+        for( unsigned int j = 0; j + 1 < lines.m_points.size(); j += 2 )
+            aGal->DrawLine( lines.m_points[j], lines.m_points[j + 1] );
+    }
+}
 
-            aGal->DrawLine( source, target );
-        }
+
+void RATSNEST_VIEWITEM::updateLines( const RN_NET& aNet, NET_LINES& aLines )
+{
+    if( aLines.m_valid && aLines.m_revision == aNet.GetRevision() )
+        return;
+
+    aLines.m_valid = true;
+    aLines.m_revision = aNet.GetRevision();
+    aLines.m_points.clear();
+
+    const std::vector<RN_EDGE>& edges = aNet.GetUnconnected();
+
+    aLines.m_points.reserve( 2 * edges.size() );
+
+    BOOST_FOREACH( const RN_EDGE& edge, edges )
+    {
+        const RN_NODE& sourceNode = aNet.GetNode( edge.GetSourceNode() );
+        const RN_NODE& targetNode = aNet.GetNode( edge.GetTargetNode() );
+        VECTOR2D source( sourceNode.GetX(), sourceNode.GetY() );
+        VECTOR2D target( targetNode.GetX(), targetNode.GetY() );
+
+        if( aLines.m_points.empty() )
+            aLines.m_bbox = BOX2D( source, VECTOR2D( 0, 0 ) );
+
+        aLines.m_bbox.Merge( source );
+        aLines.m_bbox.Merge( target );
+
+        aLines.m_points.push_back( source );
+        aLines.m_points.push_back( target );
     }
 }
 
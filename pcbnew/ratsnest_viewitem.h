@@ -32,9 +32,13 @@
 
 #include <base_struct.h>
 #include <math/vector2d.h>
+#include <math/box2.h>
+
+#include <vector>
 
 class GAL;
 class RN_DATA;
+class RN_NET;
 
 namespace KIGFX
 {
@@ -68,8 +72,40 @@ public:
     }
 
 protected:
+    ///> Lines drawn for the unconnected edges of a net.
+    struct NET_LINES
+    {
+        NET_LINES() : m_valid( false ), m_revision( 0 ) {}
+
+        ///> True if the lines were computed for the m_revision of the net.
+        bool m_valid;
+
+        ///> Revision of the net ratsnest (see RN_NET::GetRevision()) used to compute lines.
+        unsigned int m_revision;
+
+        ///> Start and end points of the lines.
+        std::vector<VECTOR2D> m_points;
+
+        ///> Bounding box of the lines, to skip nets that are not in the viewport.
+        BOX2D m_bbox;
+    };
+
+    /**
+     * Function updateLines()
+     * Computes again the lines of a net, if its ratsnest has changed.
+     * @param aNet is the net which lines are updated.
+     * @param aLines is the lines cached for aNet.
+     */
+    static void updateLines( const RN_NET& aNet, NET_LINES& aLines );
+
     ///> Object containing ratsnest data.
     RN_DATA* m_data;
+
+    ///> Lines of the "static" ratsnest, indexed by net codes.
+    mutable std::vector<NET_LINES> m_lines;
+
+    ///> Revision of the nets list (see RN_DATA::GetRevision()) used for m_lines.
+    mutable unsigned int m_linesRevision;
 };
 
 }   // namespace KIGFX
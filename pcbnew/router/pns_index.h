@@ -109,6 +109,14 @@ public:
      */
     void Clear();
 
+    /**
+     * Function Optimize()
+     *
+     * Packs the sub-indices holding many items added or removed since the last call
+     * (e.g. after the board was loaded), so they are searched faster.
+     */
+    void Optimize();
+
     /**
      * Function GetItemsForNet()
      *
@@ -299,6 +307,15 @@ void PNS_INDEX::Clear()
     }
 }
 
+void PNS_INDEX::Optimize()
+{
+    for( int i = 0; i < MaxSubIndices; ++i )
+    {
+        if( m_subIndices[i] )
+            m_subIndices[i]->Optimize();
+    }
+}
+
 PNS_INDEX::~PNS_INDEX()
 {
     Clear();
@@ -18,8 +18,11 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <new>
+
 #include <boost/foreach.hpp>
 #include <boost/optional.hpp>
+#include <boost/pool/singleton_pool.hpp>
 
 #include <math/vector2d.h>
 
@@ -151,6 +154,39 @@ PNS_SEGMENT* PNS_SEGMENT::Clone( ) const
 }
 
 
+// tag of the pool of PNS_SEGMENT objects
+struct PNS_SEGMENT_POOL_TAG {};
+
+typedef boost::singleton_pool<PNS_SEGMENT_POOL_TAG, sizeof( PNS_SEGMENT )> SEGMENT_POOL;
+
+
+void* PNS_SEGMENT::operator new( size_t aSize )
+{
+    // classes derived from PNS_SEGMENT do not fit in the pool
+    if( aSize != sizeof( PNS_SEGMENT ) )
+        return ::operator new( aSize );
+
+    void* p = SEGMENT_POOL::malloc();
+
+    if( !p )
+        throw std::bad_alloc();
+
+    return p;
+}
+
+
+void PNS_SEGMENT::operator delete( void* aPtr, size_t aSize )
+{
+    if( !aPtr )
+        return;
+
+    if( aSize != sizeof( PNS_SEGMENT ) )
+        ::operator delete( aPtr );
+    else
+        SEGMENT_POOL::free( aPtr );
+}
+
+
 int PNS_LINE::CountCorners( int aAngles )
 {
     int count = 0;
@@ -135,6 +135,34 @@ void PNS_LOGGER::Log( const VECTOR2I& aStart, const VECTOR2I& aEnd,
 }
 
 
+void PNS_LOGGER::LogEvent( const std::string& aName, const VECTOR2I& aP, int aArg,
+                           const PNS_ITEM* aItem )
+{
+    m_theLog << "event " << aName << " " << aP.x << " " << aP.y << " " << aArg << " ";
+
+    if( aItem )
+    {
+        // items are found again with their anchor when the event is replayed
+        VECTOR2I anchor = aItem->Anchor( 0 );
+
+        m_theLog << aItem->Kind() << " " << aItem->Net() << " " << aItem->Layers().Start() <<
+                    " " << aItem->Layers().End() << " " << anchor.x << " " << anchor.y;
+    }
+    else
+    {
+        m_theLog << "-";
+    }
+
+    m_theLog << std::endl;
+}
+
+
+void PNS_LOGGER::LogLine( const std::string& aLine )
+{
+    m_theLog << aLine << std::endl;
+}
+
+
 void PNS_LOGGER::dumpShape( const SHAPE* aSh )
 {
     switch( aSh->Type() )
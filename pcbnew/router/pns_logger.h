@@ -49,6 +49,19 @@ public:
     void Log( const VECTOR2I& aStart, const VECTOR2I& aEnd, int aKind = 0,
               const std::string aName = std::string() );
 
+    /**
+     * Function LogEvent()
+     *
+     * Logs a call of the router API, to replay it later (see PNS_ROUTER::SetRecorder()).
+     * The line is: "event <name> <x> <y> <arg> <item>", with <item> being "-" or
+     * "<kind> <net> <layer start> <layer end> <anchor x> <anchor y>".
+     */
+    void LogEvent( const std::string& aName, const VECTOR2I& aP, int aArg = 0,
+                   const PNS_ITEM* aItem = NULL );
+
+    ///> Logs a line of text as is
+    void LogLine( const std::string& aLine );
+
 private:
     void dumpShape( const SHAPE* aSh );
 
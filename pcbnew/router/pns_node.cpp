@@ -19,6 +19,7 @@
  */
 
 #include <vector>
+#include <algorithm>
 #include <cassert>
 
 #include <math/vector2d.h>
@@ -45,6 +46,8 @@ using boost::unordered_map;
 static boost::unordered_set<PNS_NODE*> allocNodes;
 #endif
 
+static PNS_NODE_STATS nodeStats;
+
 PNS_NODE::PNS_NODE()
 {
     TRACE( 0, "PNS_NODE::create %p", this );
@@ -99,6 +102,18 @@ int PNS_NODE::GetClearance( const PNS_ITEM* aA, const PNS_ITEM* aB ) const
 }
 
 
+void PNS_NODE::OptimizeIndex()
+{
+    m_index->Optimize();
+}
+
+
+PNS_NODE_STATS& PNS_NODE::Stats()
+{
+    return nodeStats;
+}
+
+
 PNS_NODE* PNS_NODE::Branch()
 {
     PNS_NODE* child = new PNS_NODE;
@@ -106,6 +121,10 @@ PNS_NODE* PNS_NODE::Branch()
     TRACE( 0, "PNS_NODE::branch %p (parent %p)", child % this );
 
     m_children.push_back( child );
+    nodeStats.m_branches++;
+
+    // the parent is not modified any more while it has branches: pack its index now.
+    m_index->Optimize();
 
     child->m_depth = m_depth + 1;
     child->m_parent = this;
@@ -113,22 +132,11 @@ PNS_NODE* PNS_NODE::Branch()
     child->m_root = isRoot() ? this : m_root;
     child->m_collisionFilter = m_collisionFilter;
 
-    // immmediate offspring of the root branch needs not copy anything.
-    // For the rest, deep-copy joints, overridden item map and pointers
-    // to stored items.
-    if( !isRoot() )
-    {
-        JOINT_MAP::iterator j;
-
-        for( PNS_INDEX::ITEM_SET::iterator i = m_index->begin(); i != m_index->end(); ++i )
-            child->m_index->Add( *i );
+    // The items and joints of the parent nodes are not copied, they are looked
+    // up in the parents. Only the (small) list of overridden items is copied.
+    child->m_override = m_override;
 
-        child->m_joints = m_joints;
-        child->m_override = m_override;
-    }
-
-    TRACE( 2, "%d items, %d joints, %d overrides",
-            child->m_index->Size() % child->m_joints.size() % child->m_override.size() );
+    TRACE( 2, "%d overrides", child->m_override.size() );
 
     return child;
 }
@@ -158,7 +166,7 @@ struct PNS_NODE::OBSTACLE_VISITOR
     ///> node we are searching in (either root or a branch)
     PNS_NODE* m_node;
 
-    ///> node that overrides root entries
+    ///> node that overrides the entries of m_node
     PNS_NODE* m_override;
 
     ///> list of encountered obstacles
@@ -211,7 +219,7 @@ struct PNS_NODE::OBSTACLE_VISITOR
 
         // check if there is a more recent branch with a newer
         // (possibily modified) version of this item.
-        if( m_override && m_override->overrides( aItem ) )
+        if( m_override && m_override->overrides( aItem, m_node->m_depth ) )
             return true;
 
         int clearance = m_extraClearance + m_node->GetClearance( aItem, m_item );
@@ -250,17 +258,26 @@ int PNS_NODE::QueryColliding( const PNS_ITEM* aItem,
     assert( allocNodes.find( this ) != allocNodes.end() );
 #endif
 
+    // collision queries can be made by several threads (see PNS_WALKAROUND::Route())
+#ifdef USE_OPENMP
+    #pragma omp atomic
+#endif /* USE_OPENMP */
+    nodeStats.m_collisionQueries++;
+
     visitor.SetCountLimit( aLimitCount );
     visitor.SetWorld( this, NULL );
 
     // first, look for colliding items in the local index
     m_index->Query( aItem, m_maxClearance, visitor );
 
-    // if we haven't found enough items, look in the root branch as well.
-    if( !isRoot() && ( visitor.m_matchCount < aLimitCount || aLimitCount < 0 ) )
+    // if we haven't found enough items, look in the parent branches and the root as well.
+    for( PNS_NODE* node = m_parent; node; node = node->m_parent )
     {
-        visitor.SetWorld( m_root, this );
-        m_root->m_index->Query( aItem, m_maxClearance, visitor );
+        if( visitor.m_matchCount >= aLimitCount && aLimitCount >= 0 )
+            break;
+
+        visitor.SetWorld( node, this );
+        node->m_index->Query( aItem, m_maxClearance, visitor );
     }
 
     return aObstacles.size();
@@ -476,15 +493,15 @@ const PNS_ITEMSET PNS_NODE::HitTest( const VECTOR2I& aPoint ) const
 
     m_index->Query( &s, m_maxClearance, visitor );
 
-    if( !isRoot() )    // fixme: could be made cleaner
+    for( const PNS_NODE* node = m_parent; node; node = node->m_parent )
     {
-        PNS_ITEMSET items_root;
-        HIT_VISITOR  visitor_root( items_root, aPoint, m_root );
-        m_root->m_index->Query( &s, m_maxClearance, visitor_root );
+        PNS_ITEMSET items_parent;
+        HIT_VISITOR  visitor_parent( items_parent, aPoint, node );
+        node->m_index->Query( &s, m_maxClearance, visitor_parent );
 
-        BOOST_FOREACH( PNS_ITEM* item, items_root.Items() )
+        BOOST_FOREACH( PNS_ITEM* item, items_parent.Items() )
         {
-            if( !overrides( item ) )
+            if( !overrides( item, node->m_depth ) )
                 items.Add( item );
         }
     }
@@ -597,14 +614,13 @@ void PNS_NODE::doRemove( PNS_ITEM* aItem )
 {
  //   assert(m_root->m_index->Contains(aItem) || m_index->Contains(aItem));
 
-    // case 1: removing an item that is stored in the root node from any branch:
+    // case 1: removing an item that is stored in the root node or in a parent branch:
     // mark it as overridden, but do not remove
-    if( aItem->BelongsTo( m_root ) && !isRoot() )
-        m_override.insert( aItem );
+    if( !isRoot() && !m_index->Contains( aItem ) )
+        addOverride( aItem );
 
-    // case 2: the item belongs to this branch or a parent, non-root branch,
-    // or the root itself and we are the root: remove from the index
-    else if( !aItem->BelongsTo( m_root ) || isRoot() )
+    // case 2: the item is stored in this branch: remove from the index
+    else
         m_index->Remove( aItem );
 
     // the item belongs to this particular branch: un-reference it
@@ -664,6 +680,9 @@ void PNS_NODE::removeVia( PNS_VIA* aVia )
     tag.net = net;
     tag.pos = p;
 
+    // the joints may be stored in a parent node
+    copyJoints( tag );
+
     bool split;
     do
     {
@@ -913,29 +932,52 @@ PNS_JOINT* PNS_NODE::FindJoint( const VECTOR2I& aPos, int aLayer, int aNet )
     tag.net = aNet;
     tag.pos = aPos;
 
-    JOINT_MAP::iterator f = m_joints.find( tag ), end = m_joints.end();
+    PNS_NODE* node = findJointNode( tag );
 
-    if( f == end && !isRoot() )
-    {
-        end = m_root->m_joints.end();
-        f = m_root->m_joints.find( tag );    // m_root->FindJoint(aPos, aLayer, aNet);
-    }
-
-    if( f == end )
+    if( !node )
         return NULL;
 
-    while( f != end )
+    std::pair<JOINT_MAP::iterator, JOINT_MAP::iterator> range = node->m_joints.equal_range( tag );
+
+    for( JOINT_MAP::iterator f = range.first; f != range.second; ++f )
     {
         if( f->second.Layers().Overlaps( aLayer ) )
             return &f->second;
+    }
+
+    return NULL;
+}
+
 
-        ++f;
+PNS_NODE* PNS_NODE::findJointNode( const PNS_JOINT::HASH_TAG& aTag )
+{
+    for( PNS_NODE* node = this; node; node = node->m_parent )
+    {
+        if( node->m_joints.find( aTag ) != node->m_joints.end() )
+            return node;
     }
 
     return NULL;
 }
 
 
+void PNS_NODE::copyJoints( const PNS_JOINT::HASH_TAG& aTag )
+{
+    if( isRoot() || m_joints.find( aTag ) != m_joints.end() )
+        return;
+
+    PNS_NODE* node = m_parent->findJointNode( aTag );
+
+    if( !node )
+        return;
+
+    std::pair<JOINT_MAP::iterator, JOINT_MAP::iterator> range = node->m_joints.equal_range( aTag );
+
+    for( JOINT_MAP::iterator f = range.first; f != range.second; ++f )
+        m_joints.insert( *f );
+}
+
+
 PNS_JOINT& PNS_NODE::touchJoint( const VECTOR2I& aPos, const PNS_LAYERSET& aLayers, int aNet )
 {
     PNS_JOINT::HASH_TAG tag;
@@ -943,20 +985,12 @@ PNS_JOINT& PNS_NODE::touchJoint( const VECTOR2I& aPos, const PNS_LAYERSET& aLaye
     tag.pos = aPos;
     tag.net = aNet;
 
-    // try to find the joint in this node.
-    JOINT_MAP::iterator f = m_joints.find( tag );
+    // not found in this node and we are not root? find in the parents and copy results here.
+    copyJoints( tag );
 
+    JOINT_MAP::iterator f;
     std::pair<JOINT_MAP::iterator, JOINT_MAP::iterator> range;
 
-    // not found and we are not root? find in the root and copy results here.
-    if( f == m_joints.end() && !isRoot() )
-    {
-        range = m_root->m_joints.equal_range( tag );
-
-        for( f = range.first; f != range.second; ++f )
-            m_joints.insert( *f );
-    }
-
     // now insert and combine overlapping joints
     PNS_JOINT jt( aPos, aLayers, aNet );
 
@@ -1102,11 +1136,56 @@ void PNS_NODE::GetUpdatedItems( ITEM_VECTOR& aRemoved, ITEM_VECTOR& aAdded )
     if( isRoot() )
         return;
 
-    BOOST_FOREACH( PNS_ITEM* item, m_override )
-    aRemoved.push_back( item );
+    // items removed from the parent branches only are not in the root
+    BOOST_FOREACH( const OVERRIDE& ovr, m_override )
+    {
+        if( m_root->m_index->Contains( ovr.first ) )
+            aRemoved.push_back( ovr.first );
+    }
 
-    for( PNS_INDEX::ITEM_SET::iterator i = m_index->begin(); i != m_index->end(); ++i )
-        aAdded.push_back( *i );
+    branchItems( aAdded );
+}
+
+
+bool PNS_NODE::overrides( PNS_ITEM* aItem, int aDepth ) const
+{
+    std::vector<OVERRIDE>::const_iterator i = std::lower_bound( m_override.begin(),
+            m_override.end(), OVERRIDE( aItem, INT_MIN ) );
+
+    // an item removed in a node, then added again to a deeper node is visible
+    // in the deeper node.
+    return i != m_override.end() && i->first == aItem && i->second > aDepth;
+}
+
+
+void PNS_NODE::addOverride( PNS_ITEM* aItem )
+{
+    std::vector<OVERRIDE>::iterator i = std::lower_bound( m_override.begin(),
+            m_override.end(), OVERRIDE( aItem, INT_MIN ) );
+
+    if( i != m_override.end() && i->first == aItem )
+        i->second = m_depth;
+    else
+        m_override.insert( i, OVERRIDE( aItem, m_depth ) );
+}
+
+
+void PNS_NODE::branchItems( ITEM_VECTOR& aItems ) const
+{
+    const PNS_NODE* node = this;
+
+    do
+    {
+        for( PNS_INDEX::ITEM_SET::iterator i = node->m_index->begin();
+             i != node->m_index->end(); ++i )
+        {
+            if( !overrides( *i, node->m_depth ) )
+                aItems.push_back( *i );
+        }
+
+        node = node->m_parent;
+    }
+    while( node && !node->isRoot() );
 }
 
 
@@ -1128,15 +1207,18 @@ void PNS_NODE::Commit( PNS_NODE* aNode )
     if( aNode->isRoot() )
         return;
 
-    BOOST_FOREACH( PNS_ITEM * item, aNode->m_override )
-    Remove( item );
+    ITEM_VECTOR removed, added;
+
+    aNode->GetUpdatedItems( removed, added );
 
-    for( PNS_INDEX::ITEM_SET::iterator i = aNode->m_index->begin();
-         i != aNode->m_index->end(); ++i )
+    BOOST_FOREACH( PNS_ITEM* item, removed )
+        Remove( item );
+
+    BOOST_FOREACH( PNS_ITEM* item, added )
     {
-        (*i)->SetRank( -1 );
-        (*i)->Unmark();
-        Add( *i );
+        item->SetRank( -1 );
+        item->Unmark();
+        Add( item );
     }
 
     releaseChildren();
@@ -1160,13 +1242,13 @@ void PNS_NODE::AllItemsInNet( int aNet, std::set<PNS_ITEM*>& aItems )
             aItems.insert( item );
     }
 
-    if( !isRoot() )
+    for( PNS_NODE* node = m_parent; node; node = node->m_parent )
     {
-        PNS_INDEX::NET_ITEMS_LIST* l_root = m_root->m_index->GetItemsForNet( aNet );
+        PNS_INDEX::NET_ITEMS_LIST* l_parent = node->m_index->GetItemsForNet( aNet );
 
-        if( l_root )
-            for( PNS_INDEX::NET_ITEMS_LIST::iterator i = l_root->begin(); i!= l_root->end(); ++i )
-                if( !overrides( *i ) )
+        if( l_parent )
+            for( PNS_INDEX::NET_ITEMS_LIST::iterator i = l_parent->begin(); i!= l_parent->end(); ++i )
+                if( !overrides( *i, node->m_depth ) )
                     aItems.insert( *i );
     }
 }
@@ -1174,20 +1256,28 @@ void PNS_NODE::AllItemsInNet( int aNet, std::set<PNS_ITEM*>& aItems )
 
 void PNS_NODE::ClearRanks( int aMarkerMask )
 {
-    for( PNS_INDEX::ITEM_SET::iterator i = m_index->begin(); i != m_index->end(); ++i )
+    ITEM_VECTOR items;
+
+    branchItems( items );
+
+    BOOST_FOREACH( PNS_ITEM* item, items )
     {
-        (*i)->SetRank( -1 );
-        (*i)->Mark( (*i)->Marker() & (~aMarkerMask) );
+        item->SetRank( -1 );
+        item->Mark( item->Marker() & (~aMarkerMask) );
     }
 }
 
 
 int PNS_NODE::FindByMarker( int aMarker, PNS_ITEMSET& aItems )
 {
-    for( PNS_INDEX::ITEM_SET::iterator i = m_index->begin(); i != m_index->end(); ++i )
+    ITEM_VECTOR items;
+
+    branchItems( items );
+
+    BOOST_FOREACH( PNS_ITEM* item, items )
     {
-        if( (*i)->Marker() & aMarker )
-            aItems.Add( *i );
+        if( item->Marker() & aMarker )
+            aItems.Add( item );
     }
 
     return 0;
@@ -1197,12 +1287,15 @@ int PNS_NODE::FindByMarker( int aMarker, PNS_ITEMSET& aItems )
 int PNS_NODE::RemoveByMarker( int aMarker )
 {
     std::list<PNS_ITEM*> garbage;
+    ITEM_VECTOR items;
 
-    for( PNS_INDEX::ITEM_SET::iterator i = m_index->begin(); i != m_index->end(); ++i )
+    branchItems( items );
+
+    BOOST_FOREACH( PNS_ITEM* item, items )
     {
-        if ( (*i)->Marker() & aMarker )
+        if ( item->Marker() & aMarker )
         {
-            garbage.push_back( *i );
+            garbage.push_back( item );
         }
     }
 
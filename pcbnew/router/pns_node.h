@@ -23,6 +23,7 @@
 
 #include <vector>
 #include <list>
+#include <utility>
 
 #include <boost/unordered_set.hpp>
 #include <boost/unordered_map.hpp>
@@ -116,6 +117,26 @@ struct PNS_COLLISION_FILTER {
     virtual bool operator()( const PNS_ITEM *aItemA, const PNS_ITEM *aItemB ) const = 0;
 };
 
+/**
+ * Struct PNS_NODE_STATS
+ *
+ * Counts the operations done by all the nodes, to profile the router
+ * (see the pns_replay tool).
+ **/
+struct PNS_NODE_STATS
+{
+    ///> Number of QueryColliding() calls
+    int m_collisionQueries;
+
+    ///> Number of nodes created by Branch()
+    int m_branches;
+
+    PNS_NODE_STATS() :
+        m_collisionQueries( 0 ),
+        m_branches( 0 )
+    {}
+};
+
 /**
  * Class PNS_NODE
  *
@@ -159,12 +180,18 @@ public:
         m_clearanceFunctor = aFunc;
     }
 
-    ///> Returns the number of joints
+    ///> Returns the number of joints stored in this node (not in its parents)
     int JointCount() const
     {
         return m_joints.size();
     }
 
+    ///> Packs the spatial index after many items were added (e.g. when loading the board)
+    void OptimizeIndex();
+
+    ///> Returns the operation counters of all the nodes. Assign PNS_NODE_STATS() to reset them.
+    static PNS_NODE_STATS& Stats();
+
     ///> Returns the number of nodes in the inheritance chain (wrs to the root node)
     int Depth() const
     {
@@ -288,8 +315,9 @@ public:
      * Function Branch()
      *
      * Creates a lightweight copy (called branch) of self that tracks
-     * the changes (added/removed items) wrs to the root. Note that if there are
-     * any branches in use, their parents must NOT be deleted.
+     * the changes (added/removed items) wrs to the root. The branch shares
+     * the items and joints of its parents, so if there are any branches in use,
+     * their parents must NOT be deleted nor modified.
      * @return the new branch
      */
     PNS_NODE* Branch();
@@ -378,6 +406,9 @@ private:
     typedef boost::unordered_multimap<PNS_JOINT::HASH_TAG, PNS_JOINT> JOINT_MAP;
     typedef JOINT_MAP::value_type TagJointPair;
 
+    ///> an item removed from the parent nodes, with the depth of the node it was removed in
+    typedef std::pair<PNS_ITEM*, int> OVERRIDE;
+
     /// nodes are not copyable
     PNS_NODE( const PNS_NODE& aB );
     PNS_NODE& operator=( const PNS_NODE& aB );
@@ -387,6 +418,12 @@ private:
                            const PNS_LAYERSET&  aLayers,
                            int                  aNet );
 
+    ///> finds the node storing the joints at aTag: this node or the nearest parent
+    PNS_NODE* findJointNode( const PNS_JOINT::HASH_TAG& aTag );
+
+    ///> copies the joints at aTag from the nearest parent, if this node has none
+    void copyJoints( const PNS_JOINT::HASH_TAG& aTag );
+
     ///> touches a joint and links it to an m_item
     void linkJoint( const VECTOR2I& aPos, const PNS_LAYERSET& aLayers,
                     int aNet, PNS_ITEM* aWhere );
@@ -415,11 +452,15 @@ private:
     }
 
     ///> checks if this branch contains an updated version of the m_item
-    ///> from the root branch.
-    bool overrides( PNS_ITEM* aItem ) const
-    {
-        return m_override.find( aItem ) != m_override.end();
-    }
+    ///> stored in the parent node at depth aDepth.
+    bool overrides( PNS_ITEM* aItem, int aDepth ) const;
+
+    ///> marks aItem (stored in a parent node) as removed in this branch
+    void addOverride( PNS_ITEM* aItem );
+
+    ///> collects the items added in this branch and in its non-root parents,
+    ///> which are still present in this branch
+    void branchItems( ITEM_VECTOR& aItems ) const;
 
     PNS_SEGMENT *findRedundantSegment ( PNS_SEGMENT* aSeg );
 
@@ -433,7 +474,8 @@ private:
                      bool&           aGuardHit );
 
     ///> hash table with the joints, linking the items. Joints are hashed by
-    ///> their position, layer set and net.
+    ///> their position, layer set and net. A branch only stores the joints it
+    ///> has modified, the other ones are looked up in the parent nodes.
     JOINT_MAP m_joints;
 
     ///> node this node was branched from
@@ -445,8 +487,9 @@ private:
     ///> list of nodes branched from this one
     std::vector<PNS_NODE*> m_children;
 
-    ///> hash of root's items that have been changed in this node
-    boost::unordered_set<PNS_ITEM*> m_override;
+    ///> items of the parent nodes that have been changed in this node or its parents,
+    ///> sorted by address
+    std::vector<OVERRIDE> m_override;
 
     ///> worst case item-item clearance
     int m_maxClearance;
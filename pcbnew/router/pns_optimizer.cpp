@@ -24,6 +24,7 @@
 #include <geometry/shape_rect.h>
 
 #include "pns_line.h"
+#include "pns_segment.h"
 #include "pns_diff_pair.h"
 #include "pns_node.h"
 #include "pns_optimizer.h"
@@ -133,36 +134,6 @@ PNS_OPTIMIZER::~PNS_OPTIMIZER()
 }
 
 
-struct PNS_OPTIMIZER::CACHE_VISITOR
-{
-    CACHE_VISITOR( const PNS_ITEM* aOurItem, PNS_NODE* aNode, int aMask ) :
-        m_ourItem( aOurItem ),
-        m_collidingItem( NULL ),
-        m_node( aNode ),
-        m_mask( aMask )
-    {}
-
-    bool operator()( PNS_ITEM* aOtherItem )
-    {
-        if( !m_mask & aOtherItem->Kind() )
-            return true;
-
-        int clearance = m_node->GetClearance( aOtherItem, m_ourItem );
-
-        if( !aOtherItem->Collide( m_ourItem, clearance ) )
-            return true;
-
-        m_collidingItem = aOtherItem;
-        return false;
-    }
-
-    const PNS_ITEM* m_ourItem;
-    PNS_ITEM* m_collidingItem;
-    PNS_NODE* m_node;
-    int m_mask;
-};
-
-
 void PNS_OPTIMIZER::cacheAdd( PNS_ITEM* aItem, bool aIsStatic = false )
 {
     if( m_cacheTags.find( aItem ) != m_cacheTags.end() )
@@ -212,6 +183,7 @@ void PNS_OPTIMIZER::ClearCache( bool aStaticOnly  )
     {
         m_cacheTags.clear();
         m_cache.Clear();
+        m_segmentCache.clear();
         return;
     }
 
@@ -378,33 +350,92 @@ bool LINE_RESTRICTIONS::Check( int aVertex1, int aVertex2, const SHAPE_LINE_CHAI
 }
 
 
-bool PNS_OPTIMIZER::checkColliding( PNS_ITEM* aItem, bool aUpdateCache )
+PNS_OPTIMIZER::SEGMENT_KEY::SEGMENT_KEY( const PNS_LINE& aLine, const SEG& aSeg ) :
+    m_width( aLine.Width() ),
+    m_layerStart( aLine.Layers().Start() ),
+    m_layerEnd( aLine.Layers().End() ),
+    m_net( aLine.Net() )
 {
-    CACHE_VISITOR v( aItem, m_world, m_collisionKindMask );
+    // the collisions do not depend on the segment direction
+    if( aSeg.B.x < aSeg.A.x || ( aSeg.B.x == aSeg.A.x && aSeg.B.y < aSeg.A.y ) )
+    {
+        m_a = aSeg.B;
+        m_b = aSeg.A;
+    }
+    else
+    {
+        m_a = aSeg.A;
+        m_b = aSeg.B;
+    }
+}
 
-    return m_world->CheckColliding( aItem );
 
-    // something is wrong with the cache, need to investigate.
-    m_cache.Query( aItem->Shape(), m_world->GetMaxClearance(), v, false );
+bool PNS_OPTIMIZER::SEGMENT_KEY::operator<( const SEGMENT_KEY& aOther ) const
+{
+    if( m_a.x != aOther.m_a.x )
+        return m_a.x < aOther.m_a.x;
 
-    if( !v.m_collidingItem )
-    {
-        PNS_NODE::OPT_OBSTACLE obs = m_world->CheckColliding( aItem );
+    if( m_a.y != aOther.m_a.y )
+        return m_a.y < aOther.m_a.y;
 
-        if( obs )
-        {
-            if( aUpdateCache )
-                cacheAdd( obs->m_item );
+    if( m_b.x != aOther.m_b.x )
+        return m_b.x < aOther.m_b.x;
 
-            return true;
-        }
-    }
-    else
+    if( m_b.y != aOther.m_b.y )
+        return m_b.y < aOther.m_b.y;
+
+    if( m_width != aOther.m_width )
+        return m_width < aOther.m_width;
+
+    if( m_layerStart != aOther.m_layerStart )
+        return m_layerStart < aOther.m_layerStart;
+
+    if( m_layerEnd != aOther.m_layerEnd )
+        return m_layerEnd < aOther.m_layerEnd;
+
+    return m_net < aOther.m_net;
+}
+
+
+bool PNS_OPTIMIZER::segmentColliding( const PNS_LINE& aLine, const SEG& aSeg )
+{
+    SEGMENT_KEY key( aLine, aSeg );
+    SEGMENT_CACHE::const_iterator it = m_segmentCache.find( key );
+
+    if( it != m_segmentCache.end() )
+        return it->second;
+
+    const PNS_SEGMENT s( aLine, aSeg );
+    bool colliding = false;
+
+    if( m_world->CheckColliding( &s ) )
+        colliding = true;
+
+    m_segmentCache[key] = colliding;
+
+    return colliding;
+}
+
+
+bool PNS_OPTIMIZER::checkColliding( PNS_ITEM* aItem )
+{
+    if( aItem->Kind() != PNS_ITEM::LINE )
+        return m_world->CheckColliding( aItem );
+
+    // Same as PNS_NODE::CheckColliding(), but the candidate paths of an optimization
+    // share most of their segments, so the result of each segment is kept.
+    const PNS_LINE* line = static_cast<const PNS_LINE*>( aItem );
+    const SHAPE_LINE_CHAIN& l = line->CLine();
+
+    for( int i = 0; i < l.SegmentCount(); i++ )
     {
-        m_cacheTags[v.m_collidingItem].m_hits++;
-        return true;
+        if( segmentColliding( *line, l.CSegment( i ) ) )
+            return true;
     }
 
+    if( line->EndsWithVia() )
+        return m_world->CheckColliding( &line->Via() );
+
     return false;
 }
 
@@ -521,6 +552,7 @@ bool PNS_OPTIMIZER::mergeFull( PNS_LINE* aLine )
         return false;
 
     SHAPE_LINE_CHAIN current_path( line );
+    int current_cost = PNS_COST_ESTIMATOR::CornerCost( current_path );
 
     while( 1 )
     {
@@ -533,7 +565,7 @@ bool PNS_OPTIMIZER::mergeFull( PNS_LINE* aLine )
         if( step < 1 )
             break;
 
-        bool found_anything = mergeStep( aLine, current_path, step );
+        bool found_anything = mergeStep( aLine, current_path, step, current_cost );
 
         if( !found_anything )
             step--;
@@ -554,6 +586,9 @@ bool PNS_OPTIMIZER::Optimize( PNS_LINE* aLine, PNS_LINE* aResult )
 
     m_keepPostures = false;
 
+    // the world may have changed since the previous optimization
+    m_segmentCache.clear();
+
     bool rv = false;
 
     if( m_effortLevel & MERGE_SEGMENTS )
@@ -572,12 +607,13 @@ bool PNS_OPTIMIZER::Optimize( PNS_LINE* aLine, PNS_LINE* aResult )
 }
 
 
-bool PNS_OPTIMIZER::mergeStep( PNS_LINE* aLine, SHAPE_LINE_CHAIN& aCurrentPath, int step )
+bool PNS_OPTIMIZER::mergeStep( PNS_LINE* aLine, SHAPE_LINE_CHAIN& aCurrentPath, int step,
+                               int& aCurrentCost )
 {
     int n = 0;
     int n_segs = aCurrentPath.SegmentCount();
 
-    int cost_orig = PNS_COST_ESTIMATOR::CornerCost( aCurrentPath );
+    int cost_orig = aCurrentCost;
 
     LINE_RESTRICTIONS restr;
 
@@ -629,6 +665,7 @@ bool PNS_OPTIMIZER::mergeStep( PNS_LINE* aLine, SHAPE_LINE_CHAIN& aCurrentPath,
         {
             n_segs = aCurrentPath.SegmentCount();
             aCurrentPath = *picked;
+            aCurrentCost = cost[picked - path];
             return true;
         }
 
@@ -848,9 +885,10 @@ int PNS_OPTIMIZER::smartPadsSingle( PNS_LINE* aLine, PNS_ITEM* aPad, bool aEnd,
         int cost = PNS_COST_ESTIMATOR::CornerCost( vp.second );
         int len = vp.second.Length();
 
-        if( !checkColliding( &tmp ) )
+        // check the collisions only for the variants which would be picked
+        if( cost < min_cost || ( cost == min_cost && len < min_len ) )
         {
-            if( cost < min_cost || ( cost == min_cost && len < min_len ) )
+            if( !checkColliding( &tmp ) )
             {
                 l_best = vp.second;
                 p_best = vp.first;
@@ -946,7 +984,7 @@ bool PNS_OPTIMIZER::fanoutCleanup( PNS_LINE* aLine )
             PNS_LINE repl;
             repl = PNS_LINE( *aLine, l2 );
 
-            if( !m_world->CheckColliding( &repl ) )
+            if( !checkColliding( &repl ) )
             {
                 aLine->SetShape( repl.CLine() );
                 return true;
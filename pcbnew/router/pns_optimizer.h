@@ -21,6 +21,8 @@
 #ifndef __PNS_OPTIMIZER_H
 #define __PNS_OPTIMIZER_H
 
+#include <map>
+
 #include <boost/unordered_map.hpp>
 #include <boost/shared_ptr.hpp>
 
@@ -105,7 +107,12 @@ public:
     bool Optimize( PNS_DIFF_PAIR* aPair );
 
 
-    void SetWorld( PNS_NODE* aNode ) { m_world = aNode; }
+    void SetWorld( PNS_NODE* aNode )
+    {
+        m_world = aNode;
+        m_segmentCache.clear();
+    }
+
     void CacheStaticItem( PNS_ITEM* aItem );
     void CacheRemove( PNS_ITEM* aItem );
     void ClearCache( bool aStaticOnly = false );
@@ -132,8 +139,6 @@ private:
 
     typedef std::vector<SHAPE_LINE_CHAIN> BREAKOUT_LIST;
 
-    struct CACHE_VISITOR;
-
     struct CACHED_ITEM
     {
         int m_hits;
@@ -144,13 +149,15 @@ private:
     bool mergeFull( PNS_LINE* aLine );
     bool removeUglyCorners( PNS_LINE* aLine );
     bool runSmartPads( PNS_LINE* aLine );
-    bool mergeStep( PNS_LINE* aLine, SHAPE_LINE_CHAIN& aCurrentLine, int step );
+    bool mergeStep( PNS_LINE* aLine, SHAPE_LINE_CHAIN& aCurrentLine, int step,
+                    int& aCurrentCost );
     bool fanoutCleanup( PNS_LINE * aLine );
     bool mergeDpSegments( PNS_DIFF_PAIR *aPair );
     bool mergeDpStep( PNS_DIFF_PAIR *aPair, bool aTryP, int step );
 
-    bool checkColliding( PNS_ITEM* aItem, bool aUpdateCache = true );
+    bool checkColliding( PNS_ITEM* aItem );
     bool checkColliding( PNS_LINE* aLine, const SHAPE_LINE_CHAIN& aOptPath );
+    bool segmentColliding( const PNS_LINE& aLine, const SEG& aSeg );
 
     void cacheAdd( PNS_ITEM* aItem, bool aIsStatic );
     void removeCachedSegments( PNS_LINE* aLine, int aStartVertex = 0, int aEndVertex = -1 );
@@ -164,8 +171,27 @@ private:
 
     PNS_ITEM* findPadOrVia( int aLayer, int aNet, const VECTOR2I& aP ) const;
 
+    ///> A segment of a line collides with the same items whatever the line it belongs to:
+    ///> it only depends on the segment geometry, width, layers and net.
+    struct SEGMENT_KEY
+    {
+        VECTOR2I m_a, m_b;
+        int m_width;
+        int m_layerStart, m_layerEnd;
+        int m_net;
+
+        SEGMENT_KEY( const PNS_LINE& aLine, const SEG& aSeg );
+
+        bool operator<( const SEGMENT_KEY& aOther ) const;
+    };
+
+    typedef std::map<SEGMENT_KEY, bool> SEGMENT_CACHE;
+
     SHAPE_INDEX_LIST<PNS_ITEM*> m_cache;
 
+    ///> collision results of the segments checked by the current optimization
+    SEGMENT_CACHE m_segmentCache;
+
     typedef boost::unordered_map<PNS_ITEM*, CACHED_ITEM> CachedItemTags;
     CachedItemTags m_cacheTags;
     PNS_NODE* m_world;
@@ -20,6 +20,7 @@
 
 #include <cstdio>
 #include <vector>
+#include <sstream>
 
 #include <boost/foreach.hpp>
 
@@ -49,6 +50,7 @@
 #include "pns_meander_placer.h"
 #include "pns_meander_skew_placer.h"
 #include "pns_dp_meander_placer.h"
+#include "pns_logger.h"
 
 #include <router/router_preview_item.h>
 
@@ -332,6 +334,9 @@ void PNS_ROUTER::SyncWorld()
             m_world->Add( item );
     }
 
+    // items are only appended to the index above, build its search tree at once
+    m_world->OptimizeIndex();
+
     int worstClearance = m_board->GetDesignSettings().GetBiggestClearanceValue();
     m_clearanceFunc = new PNS_PCBNEW_CLEARANCE_FUNC( this );
     m_world->SetClearanceFunctor( m_clearanceFunc );
@@ -363,7 +368,7 @@ PNS_ROUTER::PNS_ROUTER()
     m_currentEndItem = NULL;
     m_snappingEnabled  = false;
     m_violation = false;
-
+    m_recorder = NULL;
 }
 
 
@@ -495,6 +500,9 @@ const VECTOR2I PNS_ROUTER::SnapToItem( PNS_ITEM* aItem, VECTOR2I aP, bool& aSpli
 
 bool PNS_ROUTER::StartDragging( const VECTOR2I& aP, PNS_ITEM* aStartItem )
 {
+    recordSettings();
+    recordEvent( "drag", aP, 0, aStartItem );
+
     if( !aStartItem || aStartItem->OfKind( PNS_ITEM::SOLID ) )
         return false;
 
@@ -515,6 +523,9 @@ bool PNS_ROUTER::StartDragging( const VECTOR2I& aP, PNS_ITEM* aStartItem )
 
 bool PNS_ROUTER::StartRouting( const VECTOR2I& aP, PNS_ITEM* aStartItem, int aLayer )
 {
+    recordSettings();
+    recordEvent( "start", aP, aLayer, aStartItem );
+
     switch( m_mode )
     {
         case PNS_MODE_ROUTE_SINGLE:
@@ -577,6 +588,10 @@ void PNS_ROUTER::eraseView()
 
 void PNS_ROUTER::DisplayItem( const PNS_ITEM* aItem, int aColor, int aClearance )
 {
+    // no view (e.g. when replaying a recording)
+    if( !m_previewItems )
+        return;
+
     ROUTER_PREVIEW_ITEM* pitem = new ROUTER_PREVIEW_ITEM( aItem, m_previewItems );
 
     if( aColor >= 0 )
@@ -601,6 +616,9 @@ void PNS_ROUTER::DisplayItems( const PNS_ITEMSET& aItems )
 
 void PNS_ROUTER::DisplayDebugLine( const SHAPE_LINE_CHAIN& aLine, int aType, int aWidth )
 {
+    if( !m_previewItems )
+        return;
+
     ROUTER_PREVIEW_ITEM* pitem = new ROUTER_PREVIEW_ITEM( NULL, m_previewItems );
 
     pitem->Line( aLine, aWidth, aType );
@@ -612,6 +630,9 @@ void PNS_ROUTER::DisplayDebugLine( const SHAPE_LINE_CHAIN& aLine, int aType, int
 
 void PNS_ROUTER::DisplayDebugPoint( const VECTOR2I aPos, int aType )
 {
+    if( !m_previewItems )
+        return;
+
     ROUTER_PREVIEW_ITEM* pitem = new ROUTER_PREVIEW_ITEM( NULL, m_previewItems );
 
     pitem->Point( aPos, aType );
@@ -623,6 +644,8 @@ void PNS_ROUTER::DisplayDebugPoint( const VECTOR2I aPos, int aType )
 
 void PNS_ROUTER::Move( const VECTOR2I& aP, PNS_ITEM* endItem )
 {
+    recordEvent( "move", aP, 0, endItem );
+
     m_currentEnd = aP;
     m_currentEndItem = endItem;
 
@@ -726,6 +749,9 @@ void PNS_ROUTER::UpdateSizes ( const PNS_SIZES_SETTINGS& aSizes )
     // Change track/via size settings
     if( m_state == ROUTE_TRACK)
     {
+        recordSettings();
+        recordEvent( "sizes", m_currentEnd );
+
         m_placer->UpdateSizes( m_sizes );
         movePlacing( m_currentEnd, m_currentEndItem );
     }
@@ -769,7 +795,9 @@ void PNS_ROUTER::CommitRouting( PNS_NODE* aNode )
 
         if( parent )
         {
-            m_view->Remove( parent );
+            if( m_view )
+                m_view->Remove( parent );
+
             m_board->Remove( parent );
             m_undoBuffer.PushItem( ITEM_PICKER( parent, UR_DELETED ) );
         }
@@ -819,7 +847,10 @@ void PNS_ROUTER::CommitRouting( PNS_NODE* aNode )
         {
             item->SetParent( newBI );
             newBI->ClearFlags();
-            m_view->Add( newBI );
+
+            if( m_view )
+                m_view->Add( newBI );
+
             m_board->Add( newBI );
             m_undoBuffer.PushItem( ITEM_PICKER( newBI, UR_NEW ) );
             newBI->ViewUpdate( KIGFX::VIEW_ITEM::GEOMETRY );
@@ -834,6 +865,8 @@ bool PNS_ROUTER::FixRoute( const VECTOR2I& aP, PNS_ITEM* aEndItem )
 {
     bool rv = false;
 
+    recordEvent( "fix", aP, 0, aEndItem );
+
     switch( m_state )
     {
         case ROUTE_TRACK:
@@ -857,6 +890,8 @@ bool PNS_ROUTER::FixRoute( const VECTOR2I& aP, PNS_ITEM* aEndItem )
 
 void PNS_ROUTER::StopRouting()
 {
+    recordEvent( "stop", VECTOR2I() );
+
     // Update the ratsnest with new changes
 
     if( m_placer )
@@ -893,6 +928,8 @@ void PNS_ROUTER::StopRouting()
 
 void PNS_ROUTER::FlipPosture()
 {
+    recordEvent( "posture", m_currentEnd );
+
     if( m_state == ROUTE_TRACK )
     {
         m_placer->FlipPosture();
@@ -903,6 +940,8 @@ void PNS_ROUTER::FlipPosture()
 
 void PNS_ROUTER::SwitchLayer( int aLayer )
 {
+    recordEvent( "layer", m_currentEnd, aLayer );
+
     switch( m_state )
     {
         case ROUTE_TRACK:
@@ -916,6 +955,8 @@ void PNS_ROUTER::SwitchLayer( int aLayer )
 
 void PNS_ROUTER::ToggleViaPlacement()
 {
+    recordEvent( "via", m_currentEnd );
+
     if( m_state == ROUTE_TRACK )
     {
         bool toggle = !m_placer->IsPlacingVia();
@@ -959,6 +1000,48 @@ void PNS_ROUTER::DumpLog()
 }
 
 
+void PNS_ROUTER::SetRecorder( PNS_LOGGER* aRecorder )
+{
+    m_recorder = aRecorder;
+
+    // A new router syncs its world with the board: the replay does the same
+    if( m_recorder )
+        m_recorder->LogLine( "router" );
+}
+
+
+void PNS_ROUTER::recordSettings()
+{
+    if( !m_recorder )
+        return;
+
+    std::stringstream line;
+
+    line << "sizes " << m_sizes.TrackWidth() << " " << m_sizes.ViaDiameter() << " " <<
+            m_sizes.ViaDrill() << " " << m_sizes.ViaType() << " " <<
+            m_sizes.DiffPairWidth() << " " << m_sizes.DiffPairGap() << " " <<
+            m_sizes.DiffPairViaGap() << " " <<
+            m_sizes.GetLayerTop() << " " << m_sizes.GetLayerBottom();
+    m_recorder->LogLine( line.str() );
+
+    line.str( std::string() );
+    line << "settings " << m_mode << " " << m_settings.Mode() << " " <<
+            m_settings.OptimizerEffort() << " " << m_settings.ShoveVias() << " " <<
+            m_settings.RemoveLoops() << " " << m_settings.SmartPads() << " " <<
+            m_settings.JumpOverObstacles() << " " << m_settings.SmoothDraggedSegments() << " " <<
+            m_settings.CanViolateDRC();
+    m_recorder->LogLine( line.str() );
+}
+
+
+void PNS_ROUTER::recordEvent( const std::string& aName, const VECTOR2I& aP, int aArg,
+                              const PNS_ITEM* aItem )
+{
+    if( m_recorder )
+        m_recorder->LogEvent( aName, aP, aArg, aItem );
+}
+
+
 bool PNS_ROUTER::IsPlacingVia() const
 {
     if( !m_placer )
@@ -970,6 +1053,8 @@ bool PNS_ROUTER::IsPlacingVia() const
 
 void PNS_ROUTER::SetOrthoMode( bool aEnable )
 {
+    recordEvent( "ortho", m_currentEnd, aEnable );
+
     if( !m_placer )
         return;
 
@@ -22,6 +22,7 @@
 #define __PNS_ROUTER_H
 
 #include <list>
+#include <string>
 
 #include <boost/optional.hpp>
 #include <boost/unordered_set.hpp>
@@ -53,6 +54,7 @@ class PNS_VIA;
 class PNS_CLEARANCE_FUNC;
 class PNS_SHOVE;
 class PNS_DRAGGER;
+class PNS_LOGGER;
 
 namespace KIGFX
 {
@@ -133,6 +135,17 @@ public:
 
     void DumpLog();
 
+    /**
+     * Function SetRecorder()
+     *
+     * Records the calls of the routing functions (StartRouting(), Move(), FixRoute()...)
+     * into aRecorder, to replay them with the pns_replay tool (see PNS_TOOL_BASE).
+     * The recorder is not owned by the router: the successive routers of a tool append
+     * their calls to the same recording.
+     * @param aRecorder is the recording, or NULL to stop recording.
+     */
+    void SetRecorder( PNS_LOGGER* aRecorder );
+
     PNS_CLEARANCE_FUNC* GetClearanceFunc() const
     {
         return m_clearanceFunc;
@@ -242,6 +255,13 @@ private:
 
     void markViolations( PNS_NODE* aNode, PNS_ITEMSET& aCurrent, PNS_NODE::ITEM_VECTOR& aRemoved );
 
+    ///> Records the sizes and settings used by the next routing operation
+    void recordSettings();
+
+    ///> Records a call of a routing function
+    void recordEvent( const std::string& aName, const VECTOR2I& aP, int aArg = 0,
+                      const PNS_ITEM* aItem = NULL );
+
     VECTOR2I m_currentEnd;
     RouterState m_state;
 
@@ -277,6 +297,9 @@ private:
 
     wxString m_toolStatusbarName;
     wxString m_failureReason;
+
+    ///> Recording of the routing functions calls (see SetRecorder()), not owned
+    PNS_LOGGER* m_recorder;
 };
 
 #endif
@@ -123,6 +123,11 @@ public:
         return 2;
     }
 
+    ///> Segments are allocated from a pool: the router creates and frees lots
+    ///> of them at each routing step.
+    static void* operator new( size_t aSize );
+    static void operator delete( void* aPtr, size_t aSize );
+
 private:
     SHAPE_SEGMENT m_seg;
 };
@@ -157,99 +157,145 @@ PNS_SHOVE::SHOVE_STATUS PNS_SHOVE::walkaroundLoneVia( PNS_LINE* aCurrent, PNS_LI
 }
 
 
-PNS_SHOVE::SHOVE_STATUS PNS_SHOVE::processHullSet( PNS_LINE* aCurrent, PNS_LINE* aObstacle,
-                                                   PNS_LINE* aShoved, const HULL_SET& aHulls )
+PNS_SHOVE::HULL_ATTEMPT_STATUS PNS_SHOVE::tryHullSet( int aAttempt, PNS_LINE* aCurrent,
+                                                       PNS_LINE* aObstacle,
+                                                       const HULL_SET& aHulls,
+                                                       SHAPE_LINE_CHAIN& aShoved ) const
 {
     const SHAPE_LINE_CHAIN& obs = aObstacle->CLine();
-    bool failingDirCheck = false;
-    int attempt;
+    bool invertTraversal = ( aAttempt >= 2 );
+    bool clockwise = aAttempt % 2;
+    int vFirst = -1, vLast = -1;
 
-    for( attempt = 0; attempt < 4; attempt++ )
+    SHAPE_LINE_CHAIN path;
+    PNS_LINE l( *aObstacle );
+
+    for( int i = 0; i < (int) aHulls.size(); i++ )
     {
-        bool invertTraversal = ( attempt >= 2 );
-        bool clockwise = attempt % 2;
-        int vFirst = -1, vLast = -1;
+        const SHAPE_LINE_CHAIN& hull = aHulls[invertTraversal ? aHulls.size() - 1 - i : i];
 
-        SHAPE_LINE_CHAIN path;
-        PNS_LINE l( *aObstacle );
+        l.Walkaround( hull, path, clockwise );
+        path.Simplify();
+        l.SetShape( path );
+    }
 
-        for( int i = 0; i < (int) aHulls.size(); i++ )
+    for( int i = 0; i < std::min ( path.PointCount(), obs.PointCount() ); i++ )
+    {
+        if( path.CPoint( i ) != obs.CPoint( i ) )
         {
-            const SHAPE_LINE_CHAIN& hull = aHulls[invertTraversal ? aHulls.size() - 1 - i : i];
-
-            l.Walkaround( hull, path, clockwise );
-            path.Simplify();
-            l.SetShape( path );
+            vFirst = i;
+            break;
         }
+    }
 
-        for( int i = 0; i < std::min ( path.PointCount(), obs.PointCount() ); i++ )
+    int k = obs.PointCount() - 1;
+    for( int i = path.PointCount() - 1; i >= 0 && k >= 0; i--, k-- )
+    {
+        if( path.CPoint( i ) != obs.CPoint( k ) )
         {
-            if( path.CPoint( i ) != obs.CPoint( i ) )
-            {
-                vFirst = i;
-                break;
-            }
+            vLast = i;
+            break;
         }
+    }
 
-        int k = obs.PointCount() - 1;
-        for( int i = path.PointCount() - 1; i >= 0 && k >= 0; i--, k-- )
-        {
-            if( path.CPoint( i ) != obs.CPoint( k ) )
-            {
-                vLast = i;
-                break;
-            }
-        }
+    if( ( vFirst < 0 || vLast < 0 ) && !path.CompareGeometry( aObstacle->CLine() ) )
+    {
+        TRACE( 100, "attempt %d fail vfirst-last", aAttempt );
+        return HA_FAILED;
+    }
 
-        if( ( vFirst < 0 || vLast < 0 ) && !path.CompareGeometry( aObstacle->CLine() ) )
-        {
-            TRACE( 100, "attempt %d fail vfirst-last", attempt );
-            continue;
-        }
+    if( path.CPoint( -1 ) != obs.CPoint( -1 ) || path.CPoint( 0 ) != obs.CPoint( 0 ) )
+    {
+        TRACE( 100, "attempt %d fail vend-start\n", aAttempt );
+        return HA_FAILED;
+    }
 
-        if( path.CPoint( -1 ) != obs.CPoint( -1 ) || path.CPoint( 0 ) != obs.CPoint( 0 ) )
-        {
-            TRACE( 100, "attempt %d fail vend-start\n", attempt );
-            continue;
-        }
+    if( !checkBumpDirection( aCurrent, &l ) )
+    {
+        TRACE( 100, "attempt %d fail direction-check", aAttempt );
+        aShoved = l.CLine();
+        return HA_WRONG_DIRECTION;
+    }
 
-        if( !checkBumpDirection( aCurrent, &l ) )
-        {
-            TRACE( 100, "attempt %d fail direction-check", attempt );
-            failingDirCheck = true;
-            aShoved->SetShape( l.CLine() );
+    if( path.SelfIntersecting() )
+    {
+        TRACE( 100, "attempt %d fail self-intersect", aAttempt );
+        return HA_FAILED;
+    }
 
-            continue;
-        }
+    bool colliding = m_currentNode->CheckColliding( &l, aCurrent, PNS_ITEM::ANY, m_forceClearance );
 
-        if( path.SelfIntersecting() )
+    if( ( aCurrent->Marker() & MK_HEAD ) && !colliding )
+    {
+        PNS_JOINT* jtStart = m_currentNode->FindJoint( aCurrent->CPoint( 0 ), aCurrent );
+
+        BOOST_FOREACH( PNS_ITEM* item, jtStart->LinkList() )
         {
-            TRACE( 100, "attempt %d fail self-intersect", attempt );
-            continue;
+            if( m_currentNode->CheckColliding( item, &l ) )
+                colliding = true;
         }
+    }
+
+    if( colliding )
+    {
+        TRACE( 100, "attempt %d fail coll-check", aAttempt );
+        return HA_FAILED;
+    }
+
+    aShoved = l.CLine();
+
+    return HA_OK;
+}
 
-        bool colliding = m_currentNode->CheckColliding( &l, aCurrent, PNS_ITEM::ANY, m_forceClearance );
 
-        if( ( aCurrent->Marker() & MK_HEAD ) && !colliding )
+PNS_SHOVE::SHOVE_STATUS PNS_SHOVE::processHullSet( PNS_LINE* aCurrent, PNS_LINE* aObstacle,
+                                                   PNS_LINE* aShoved, const HULL_SET& aHulls )
+{
+    HULL_ATTEMPT_STATUS status[HullAttempts];
+    SHAPE_LINE_CHAIN    paths[HullAttempts];
+    int                 attemptCount = HullAttempts;
+
+    // The attempts only read m_currentNode, so they are evaluated at once when the
+    // walks are long enough to be worth the threads. The result is the one of
+    // a serial search: the first attempt which succeeds.
+#ifdef USE_OPENMP
+    bool parallel = (int) aHulls.size() * aObstacle->PointCount() >= ParallelHullSetMinWork;
+
+    if( parallel )
+    {
+        #pragma omp parallel for schedule(static, 1) num_threads(HullAttempts)
+        for( int attempt = 0; attempt < HullAttempts; attempt++ )
+            status[attempt] = tryHullSet( attempt, aCurrent, aObstacle, aHulls, paths[attempt] );
+    }
+    else
+#endif /* USE_OPENMP */
+    {
+        // Serial search: stop at the first attempt which succeeds
+        for( int attempt = 0; attempt < HullAttempts; attempt++ )
         {
-            PNS_JOINT* jtStart = m_currentNode->FindJoint( aCurrent->CPoint( 0 ), aCurrent );
+            status[attempt] = tryHullSet( attempt, aCurrent, aObstacle, aHulls, paths[attempt] );
 
-            BOOST_FOREACH( PNS_ITEM* item, jtStart->LinkList() )
+            if( status[attempt] == HA_OK )
             {
-                if( m_currentNode->CheckColliding( item, &l ) )
-                    colliding = true;
+                attemptCount = attempt + 1;
+                break;
             }
         }
+    }
 
-        if( colliding )
-        {
-            TRACE( 100, "attempt %d fail coll-check", attempt );
+    bool failingDirCheck = false;
+
+    for( int attempt = 0; attempt < attemptCount; attempt++ )
+    {
+        if( status[attempt] == HA_FAILED )
             continue;
-        }
 
-        aShoved->SetShape( l.CLine() );
+        aShoved->SetShape( paths[attempt] );
 
-        return SH_OK;
+        if( status[attempt] == HA_OK )
+            return SH_OK;
+
+        failingDirCheck = true;
     }
 
     return failingDirCheck ? SH_OK : SH_INCOMPLETE;
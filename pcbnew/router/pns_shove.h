@@ -98,9 +98,33 @@ private:
         OPT_BOX2I m_affectedArea;
     };
 
+    ///> Result of one way of walking around a hull set (see tryHullSet())
+    enum HULL_ATTEMPT_STATUS
+    {
+        HA_OK = 0,
+        HA_FAILED,
+        HA_WRONG_DIRECTION
+    };
+
+    ///> Number of ways of walking around a hull set: both windings, in both hull orders
+    static const int HullAttempts = 4;
+
+    ///> Hulls x obstacle points below which the walks of processHullSet() are done serially
+    static const int ParallelHullSetMinWork = 16;
+
     SHOVE_STATUS processHullSet( PNS_LINE* aCurrent, PNS_LINE* aObstacle,
                                  PNS_LINE* aShoved, const HULL_SET& hulls );
 
+    /**
+     * Function tryHullSet()
+     *
+     * Walks the obstacle line around the hulls in one of the HullAttempts ways and checks
+     * the result. Does not modify the shove state, so the attempts can be run concurrently.
+     * @param aShoved receives the shoved line shape, unless the attempt failed.
+     */
+    HULL_ATTEMPT_STATUS tryHullSet( int aAttempt, PNS_LINE* aCurrent, PNS_LINE* aObstacle,
+                                    const HULL_SET& aHulls, SHAPE_LINE_CHAIN& aShoved ) const;
+
     bool reduceSpringback( const PNS_ITEMSET& aHeadItems );
     bool pushSpringback( PNS_NODE* aNode, const PNS_ITEMSET& aHeadItems,
                                 const PNS_COST_ESTIMATOR& aCost, const OPT_BOX2I& aAffectedArea );
@@ -19,6 +19,7 @@
  */
 
 #include <wx/numdlg.h>
+#include <wx/filename.h>
 
 #include <boost/foreach.hpp>
 #include <boost/optional.hpp>
@@ -39,6 +40,7 @@
 #include <dialogs/dialog_pns_length_tuning_settings.h>
 #include <dialogs/dialog_track_via_size.h>
 #include <base_units.h>
+#include <io_mgr.h>
 
 #include <tool/context_menu.h>
 #include <tools/common_actions.h>
@@ -48,6 +50,7 @@
 #include "pns_tool_base.h"
 #include "pns_segment.h"
 #include "pns_router.h"
+#include "pns_logger.h"
 #include "pns_meander_placer.h" // fixme: move settings to separate header
 #include "pns_tune_status_popup.h"
 #include "trace.h"
@@ -75,11 +78,15 @@ PNS_TOOL_BASE::PNS_TOOL_BASE( const std::string& aToolName ) :
     m_frame = NULL;
     m_ctls = NULL;
     m_board = NULL;
+
+    m_recorder = NULL;
+    m_recordCount = 0;
 }
 
 
 PNS_TOOL_BASE::~PNS_TOOL_BASE()
 {
+    stopRecording();
     delete m_router;
 }
 
@@ -89,6 +96,10 @@ void PNS_TOOL_BASE::Reset( RESET_REASON aReason )
     if( m_router )
         delete m_router;
 
+    // Keep the recording file up to date with the calls of the deleted router
+    if( m_recorder )
+        m_recorder->Save( m_recordFile );
+
     m_frame = getEditFrame<PCB_EDIT_FRAME>();
     m_ctls = getViewControls();
     m_board = getModel<BOARD>();
@@ -104,6 +115,69 @@ void PNS_TOOL_BASE::Reset( RESET_REASON aReason )
 
     if( getView() )
         m_router->SetView( getView() );
+
+    // One recording per board load: the routers created when the tool is invoked again
+    // append their calls to it
+    if( m_board && ( aReason == MODEL_RELOAD || m_recordCount == 0 ) )
+        startRecording();
+
+    m_router->SetRecorder( m_recorder );
+}
+
+
+void PNS_TOOL_BASE::startRecording()
+{
+    stopRecording();
+
+    // KICAD_PNS_RECORD=<file> records the routing sessions into <file>.<tool>, with
+    // the board saved when it was loaded in <file>.<tool>.kicad_pcb, to replay them
+    // with the pns_replay tool.  The router and the length tuner have their own
+    // recordings, and the boards loaded later get a number.
+    wxString recordFile;
+
+    if( !wxGetEnv( wxT( "KICAD_PNS_RECORD" ), &recordFile ) || recordFile.IsEmpty() )
+        return;
+
+    std::string toolName = GetName();
+
+    recordFile << wxT( "." ) << FROM_UTF8( toolName.substr( toolName.rfind( '.' ) + 1 ).c_str() );
+
+    if( ++m_recordCount > 1 )
+        recordFile << wxT( "." ) << m_recordCount;
+
+    wxString boardFile = recordFile + wxT( ".kicad_pcb" );
+
+    try
+    {
+        IO_MGR::Save( IO_MGR::KICAD, boardFile, m_board );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        TRACE( 0, "cannot save the board of the recording: %s", TO_UTF8( ioe.errorText ) );
+        return;
+    }
+
+    m_recordFile = TO_UTF8( recordFile );
+    m_recorder = new PNS_LOGGER;
+
+    // The board is looked for in the directory of the recording
+    wxString boardName = wxFileName( boardFile ).GetFullName();
+    m_recorder->LogLine( "board " + std::string( TO_UTF8( boardName ) ) );
+}
+
+
+void PNS_TOOL_BASE::stopRecording()
+{
+    if( !m_recorder )
+        return;
+
+    if( m_router )
+        m_router->SetRecorder( NULL );
+
+    m_recorder->Save( m_recordFile );
+
+    delete m_recorder;
+    m_recorder = NULL;
 }
 
 
@@ -32,6 +32,7 @@
 #include "pns_router.h"
 
 class PNS_TUNE_STATUS_POPUP;
+class PNS_LOGGER;
 
 class APIEXPORT PNS_TOOL_BASE : public TOOL_INTERACTIVE
 {
@@ -50,6 +51,13 @@ protected:
     virtual void updateStartItem( TOOL_EVENT& aEvent );
     virtual void updateEndItem( TOOL_EVENT& aEvent );
 
+    ///> Starts the recording of the routing session of the board, if requested
+    ///> by the KICAD_PNS_RECORD environment variable
+    void startRecording();
+
+    ///> Saves and closes the current recording
+    void stopRecording();
+
     MSG_PANEL_ITEMS m_panelItems;
 
     PNS_ROUTER* m_router;
@@ -69,6 +77,13 @@ protected:
     KIGFX::VIEW_CONTROLS* m_ctls;
     BOARD* m_board;
 
+    ///> Recording of the calls of all the routers of this tool since the board was loaded
+    PNS_LOGGER* m_recorder;
+    std::string m_recordFile;
+
+    ///> Number of recordings started (one per board load)
+    int m_recordCount;
+
 };
 
 #endif
@@ -31,7 +31,6 @@ using boost::optional;
 
 void PNS_WALKAROUND::start( const PNS_LINE& aInitialPath )
 {
-    m_iteration = 0;
     m_iterationLimit = 50;
 }
 
@@ -43,12 +42,15 @@ PNS_NODE::OPT_OBSTACLE PNS_WALKAROUND::nearestObstacle( const PNS_LINE& aPath )
 
 
 PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::singleStep( PNS_LINE& aPath,
-                                                              bool aWindingDirection )
+                                                              bool aWindingDirection,
+                                                              int aIteration )
 {
     optional<PNS_OBSTACLE>& current_obs =
         aWindingDirection ? m_currentObstacle[0] : m_currentObstacle[1];
 
     bool& prev_recursive = aWindingDirection ? m_recursiveCollision[0] : m_recursiveCollision[1];
+    int& blockage_count =
+        aWindingDirection ? m_recursiveBlockageCount[0] : m_recursiveBlockageCount[1];
 
     if( !current_obs )
         return DONE;
@@ -59,9 +61,9 @@ PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::singleStep( PNS_LINE& aPath,
 
     if( ( current_obs->m_hull ).PointInside( last ) || ( current_obs->m_hull ).PointOnEdge( last ) )
     {
-        m_recursiveBlockageCount++;
+        blockage_count++;
 
-        if( m_recursiveBlockageCount < 3 )
+        if( blockage_count < 3 )
             aPath.Line().Append( current_obs->m_hull.NearestPoint( last ) );
         else
         {
@@ -76,12 +78,17 @@ PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::singleStep( PNS_LINE& aPath,
                       path_post[1], !aWindingDirection );
 
 #ifdef DEBUG
-    m_logger.NewGroup( aWindingDirection ? "walk-cw" : "walk-ccw", m_iteration );
-    m_logger.Log( &path_walk[0], 0, "path-walk" );
-    m_logger.Log( &path_pre[0], 1, "path-pre" );
-    m_logger.Log( &path_post[0], 4, "path-post" );
-    m_logger.Log( &current_obs->m_hull, 2, "hull" );
-    m_logger.Log( current_obs->m_item, 3, "item" );
+#ifdef USE_OPENMP
+    #pragma omp critical(pnsWalkaroundLog)
+#endif /* USE_OPENMP */
+    {
+        m_logger.NewGroup( aWindingDirection ? "walk-cw" : "walk-ccw", aIteration );
+        m_logger.Log( &path_walk[0], 0, "path-walk" );
+        m_logger.Log( &path_pre[0], 1, "path-pre" );
+        m_logger.Log( &path_post[0], 4, "path-post" );
+        m_logger.Log( &current_obs->m_hull, 2, "hull" );
+        m_logger.Log( current_obs->m_item, 3, "item" );
+    }
 #endif
 
     int len_pre = path_walk[0].Length();
@@ -132,6 +139,49 @@ PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::singleStep( PNS_LINE& aPath,
 }
 
 
+bool PNS_WALKAROUND::walkStep( PNS_LINE& aPath, bool aWindingDirection, int aIteration,
+                               WALKAROUND_STATUS& aStatus, int* aDoneIteration )
+{
+    int dir = aWindingDirection ? 0 : 1;
+
+    if( aStatus == STUCK || aDoneIteration[dir] < m_iterationLimit )
+        return false;
+
+    // The path of the other direction is taken if it was done first,
+    // unless the longer path is wanted
+#ifdef USE_OPENMP
+    #pragma omp flush
+#endif /* USE_OPENMP */
+
+    if( !m_forceLongerPath && aDoneIteration[1 - dir] < aIteration )
+        return false;
+
+    aStatus = singleStep( aPath, aWindingDirection, aIteration );
+
+    if( aStatus != DONE )
+        return true;
+
+    aDoneIteration[dir] = aIteration;
+
+#ifdef USE_OPENMP
+    #pragma omp flush
+#endif /* USE_OPENMP */
+
+    return false;
+}
+
+
+void PNS_WALKAROUND::walk( PNS_LINE& aPath, bool aWindingDirection, WALKAROUND_STATUS& aStatus,
+                           int* aDoneIteration )
+{
+    for( int i = 0; i < m_iterationLimit; i++ )
+    {
+        if( !walkStep( aPath, aWindingDirection, i, aStatus, aDoneIteration ) )
+            break;
+    }
+}
+
+
 PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::Route( const PNS_LINE& aInitialPath,
         PNS_LINE& aWalkPath, bool aOptimize )
 {
@@ -142,7 +192,7 @@ PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::Route( const PNS_LINE& aInitia
     start( aInitialPath );
 
     m_currentObstacle[0] = m_currentObstacle[1] = nearestObstacle( aInitialPath );
-    m_recursiveBlockageCount = 0;
+    m_recursiveBlockageCount[0] = m_recursiveBlockageCount[1] = 0;
 
     aWalkPath = aInitialPath;
 
@@ -155,42 +205,38 @@ PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::Route( const PNS_LINE& aInitia
         m_forceSingleDirection = false;
     }
 
-    while( m_iteration < m_iterationLimit )
-    {
-        if( s_cw != STUCK )
-            s_cw = singleStep( path_cw, true );
+    // Iteration at which each direction (cw, ccw) was done, m_iterationLimit if not done
+    int done_iter[2] = { m_iterationLimit, m_iterationLimit };
 
-        if( s_ccw != STUCK )
-            s_ccw = singleStep( path_ccw, false );
-
-        if( ( s_cw == DONE && s_ccw == DONE ) || ( s_cw == STUCK && s_ccw == STUCK ) )
-        {
-            int len_cw  = path_cw.CLine().Length();
-            int len_ccw = path_ccw.CLine().Length();
+    // The walks only read the world, so both directions are walked at once. They give
+    // the same paths as walking them step by step, the first direction done winning.
+#ifdef USE_OPENMP
+    #pragma omp parallel sections num_threads(2) if( s_cw != STUCK && s_ccw != STUCK )
+    {
+        #pragma omp section
+        walk( path_cw, true, s_cw, done_iter );
 
-            if( m_forceLongerPath )
-                aWalkPath = ( len_cw > len_ccw ? path_cw : path_ccw );
-            else
-                aWalkPath = ( len_cw < len_ccw ? path_cw : path_ccw );
+        #pragma omp section
+        walk( path_ccw, false, s_ccw, done_iter );
+    }
+#else /* USE_OPENMP */
+    for( int i = 0; i < m_iterationLimit; i++ )
+    {
+        bool walking_cw = walkStep( path_cw, true, i, s_cw, done_iter );
+        bool walking_ccw = walkStep( path_ccw, false, i, s_ccw, done_iter );
 
+        if( !walking_cw && !walking_ccw )
             break;
-        }
-        else if( s_cw == DONE && !m_forceLongerPath )
-        {
-            aWalkPath = path_cw;
-            break;
-        }
-        else if( s_ccw == DONE && !m_forceLongerPath )
-        {
-            aWalkPath = path_ccw;
-            break;
-        }
-
-        m_iteration++;
     }
+#endif /* USE_OPENMP */
 
-    if( m_iteration == m_iterationLimit )
+    if( done_iter[0] != done_iter[1] && !m_forceLongerPath )
+    {
+        aWalkPath = ( done_iter[0] < done_iter[1] ? path_cw : path_ccw );
+    }
+    else
     {
+        // Both done at the same iteration, none done or the longer path wanted
         int len_cw  = path_cw.CLine().Length();
         int len_ccw = path_ccw.CLine().Length();
 
@@ -243,7 +289,8 @@ PNS_WALKAROUND::WALKAROUND_STATUS PNS_WALKAROUND::Route( const PNS_LINE& aInitia
     if( aWalkPath.CPoint( 0 ) != aInitialPath.CPoint( 0 ) )
         return STUCK;
 
-    WALKAROUND_STATUS st = s_ccw == DONE || s_cw == DONE ? DONE : STUCK;
+    bool done = done_iter[0] < m_iterationLimit || done_iter[1] < m_iterationLimit;
+    WALKAROUND_STATUS st = done ? DONE : STUCK;
 
     if( st == DONE )
     {
@@ -44,9 +44,8 @@ public:
         m_itemMask = PNS_ITEM::ANY;
 
         // Initialize other members, to avoid uninitialized variables.
-        m_recursiveBlockageCount = 0;
+        m_recursiveBlockageCount[0] = m_recursiveBlockageCount[1] = 0;
         m_recursiveCollision[0] = m_recursiveCollision[1] = false;
-        m_iteration = 0;
         m_forceCw = false;
     }
 
@@ -116,13 +115,28 @@ public:
 private:
     void start( const PNS_LINE& aInitialPath );
 
-    WALKAROUND_STATUS singleStep( PNS_LINE& aPath, bool aWindingDirection );
+    WALKAROUND_STATUS singleStep( PNS_LINE& aPath, bool aWindingDirection, int aIteration );
+
+    /**
+     * Function walkStep()
+     *
+     * Does the step aIteration of the walk in one direction, unless this direction
+     * is not walked any more.
+     * @param aDoneIteration is the iteration at which each direction (cw, ccw) was done,
+     * shared by both directions.
+     * @return true if the direction is still walked after this step.
+     */
+    bool walkStep( PNS_LINE& aPath, bool aWindingDirection, int aIteration,
+                   WALKAROUND_STATUS& aStatus, int* aDoneIteration );
+
+    ///> Walks in one direction, until done or the other direction was done first.
+    void walk( PNS_LINE& aPath, bool aWindingDirection, WALKAROUND_STATUS& aStatus,
+               int* aDoneIteration );
     PNS_NODE::OPT_OBSTACLE nearestObstacle( const PNS_LINE& aPath );
 
     PNS_NODE* m_world;
 
-    int m_recursiveBlockageCount;
-    int m_iteration;
+    int m_recursiveBlockageCount[2];
     int m_iterationLimit;
     int m_itemMask;
     bool m_forceSingleDirection, m_forceLongerPath;
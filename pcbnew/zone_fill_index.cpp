@@ -0,0 +1,209 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file zone_fill_index.cpp
+ */
+
+#include <algorithm>
+
+#include <fctsys.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_track.h>
+#include <class_drawsegment.h>
+
+#include <zone_fill_index.h>
+
+
+/**
+ * Class INDEX_COLLECTOR
+ * is the visitor used to gather the item indices found by a BOARD_RTREE<int> query.
+ */
+struct INDEX_COLLECTOR
+{
+    std::vector<int>& m_found;
+
+    INDEX_COLLECTOR( std::vector<int>& aFound ) :
+        m_found( aFound )
+    {}
+
+    bool operator()( int aIndex )
+    {
+        m_found.push_back( aIndex );
+        return true;
+    }
+};
+
+
+ZONE_FILL_INDEX::ZONE_FILL_INDEX( BOARD* aPcb )
+{
+    // Holes of pads not on the zone layer are stored with the default clearance,
+    // which is not greater than the biggest clearance
+    int holeClearance = aPcb->GetDesignSettings().GetBiggestClearanceValue();
+
+    for( MODULE* module = aPcb->m_Modules; module; module = module->Next() )
+    {
+        for( D_PAD* pad = module->Pads(); pad; pad = pad->Next() )
+        {
+            // The pad is an obstacle with its clearance, or a thermal relief with its own
+            // thermal gap (the zone thermal gap is added to the query area)
+            EDA_RECT bbox = pad->GetBoundingBox();
+            bbox.Inflate( std::max( pad->GetClearance(), pad->GetThermalGap() ) );
+
+            if( pad->GetDrillSize().x || pad->GetDrillSize().y )
+            {
+                wxSize   drill = pad->GetDrillSize();
+                EDA_RECT hole( pad->GetPosition() - wxPoint( drill.x / 2, drill.y / 2 ), drill );
+
+                // Oblong holes can be rotated
+                hole.Inflate( std::max( drill.x, drill.y ) / 2 + holeClearance );
+                bbox.Merge( hole );
+            }
+
+            m_padTree.Insert( m_pads.size(), bbox );
+            m_pads.push_back( pad );
+        }
+    }
+
+    for( TRACK* track = aPcb->m_Track; track; track = track->Next() )
+    {
+        m_trackTree.Insert( m_tracks.size(), track->GetBoundingBox(), track->GetLayerSet() );
+        m_tracks.push_back( track );
+    }
+
+    // Footprint items first, then board items, like buildFeatureHoleList() does
+    for( MODULE* module = aPcb->m_Modules; module; module = module->Next() )
+    {
+        for( BOARD_ITEM* item = module->GraphicalItems(); item; item = item->Next() )
+        {
+            if( item->Type() != PCB_MODULE_EDGE_T )
+                continue;
+
+            if( !IsCopperLayer( item->GetLayer() ) && item->GetLayer() != Edge_Cuts )
+                continue;
+
+            EDA_RECT bbox = item->GetBoundingBox();
+            bbox.Inflate( ( (DRAWSEGMENT*) item )->GetWidth() );
+
+            m_graphicTree.Insert( m_graphicItems.size(), bbox );
+            m_graphicItems.push_back( item );
+        }
+    }
+
+    for( BOARD_ITEM* item = aPcb->m_Drawings; item; item = item->Next() )
+    {
+        if( !IsCopperLayer( item->GetLayer() ) && item->GetLayer() != Edge_Cuts )
+            continue;
+
+        EDA_RECT bbox = item->GetBoundingBox();
+
+        switch( item->Type() )
+        {
+        case PCB_LINE_T:
+            bbox.Inflate( ( (DRAWSEGMENT*) item )->GetWidth() );
+            break;
+
+        case PCB_TEXT_T:
+            break;
+
+        default:
+            continue;
+        }
+
+        m_graphicTree.Insert( m_graphicItems.size(), bbox );
+        m_graphicItems.push_back( item );
+    }
+}
+
+
+void ZONE_FILL_INDEX::QueryPads( const EDA_RECT& aArea, std::vector<D_PAD*>& aPads )
+{
+    std::vector<int> found;
+    INDEX_COLLECTOR  collector( found );
+
+    m_padTree.Query( aArea, collector );
+    std::sort( found.begin(), found.end() );
+
+    aPads.clear();
+
+    for( unsigned ii = 0; ii < found.size(); ++ii )
+        aPads.push_back( m_pads[found[ii]] );
+}
+
+
+void ZONE_FILL_INDEX::QueryTracks( const EDA_RECT& aArea, LAYER_ID aLayer,
+                                   std::vector<TRACK*>& aTracks )
+{
+    std::vector<int> found;
+    INDEX_COLLECTOR  collector( found );
+
+    m_trackTree.Query( aArea, LSET( aLayer ), collector );
+    std::sort( found.begin(), found.end() );
+
+    aTracks.clear();
+
+    for( unsigned ii = 0; ii < found.size(); ++ii )
+        aTracks.push_back( m_tracks[found[ii]] );
+}
+
+
+void ZONE_FILL_INDEX::QueryGraphicItems( const EDA_RECT& aArea, std::vector<BOARD_ITEM*>& aItems )
+{
+    std::vector<int> found;
+    INDEX_COLLECTOR  collector( found );
+
+    m_graphicTree.Query( aArea, collector );
+    std::sort( found.begin(), found.end() );
+
+    aItems.clear();
+
+    for( unsigned ii = 0; ii < found.size(); ++ii )
+        aItems.push_back( m_graphicItems[found[ii]] );
+}
+
+
+void ZONE_FILL_INDEX::CollectBoardItems( BOARD* aPcb, std::vector<D_PAD*>& aPads,
+                                         std::vector<TRACK*>& aTracks,
+                                         std::vector<BOARD_ITEM*>& aGraphicItems )
+{
+    for( MODULE* module = aPcb->m_Modules; module; module = module->Next() )
+    {
+        for( D_PAD* pad = module->Pads(); pad; pad = pad->Next() )
+            aPads.push_back( pad );
+    }
+
+    for( TRACK* track = aPcb->m_Track; track; track = track->Next() )
+        aTracks.push_back( track );
+
+    // Footprint items first, then board items, like the queries
+    for( MODULE* module = aPcb->m_Modules; module; module = module->Next() )
+    {
+        for( BOARD_ITEM* item = module->GraphicalItems(); item; item = item->Next() )
+            aGraphicItems.push_back( item );
+    }
+
+    for( BOARD_ITEM* item = aPcb->m_Drawings; item; item = item->Next() )
+        aGraphicItems.push_back( item );
+}
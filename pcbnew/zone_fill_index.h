@@ -0,0 +1,119 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file zone_fill_index.h
+ * @brief Spatial index of the board items which can create holes in filled zones.
+ */
+
+#ifndef ZONE_FILL_INDEX_H
+#define ZONE_FILL_INDEX_H
+
+#include <vector>
+
+#include <board_rtree.h>
+#include <pad_polygon_cache.h>
+
+class BOARD;
+class BOARD_ITEM;
+class D_PAD;
+class TRACK;
+
+
+/**
+ * Class ZONE_FILL_INDEX
+ * stores the pads, tracks and graphic items of a board in R-trees, to find the
+ * obstacles of a zone without walking the whole board for each zone
+ * (see ZONE_CONTAINER::buildFeatureHoleList()).
+ *
+ * Items are stored with a bounding box inflated by the clearance they can have
+ * in any zone, so a query using the zone bounding box inflated by the zone clearances
+ * returns a superset of the items used to fill this zone.  Items are returned in the
+ * board order, so the fill gives the same result as a full board walk.
+ *
+ * The index stores pointers to the items: it must be rebuilt when items are added
+ * or removed.  Queries do not modify the index, so it can be shared by threads
+ * filling different zones.
+ *
+ * It also holds the pad polygons cache shared by the zones filled with this index,
+ * which is freed with the index at the end of the fill.
+ */
+class ZONE_FILL_INDEX
+{
+public:
+    /**
+     * Constructor
+     * indexes the items of aPcb.
+     */
+    ZONE_FILL_INDEX( BOARD* aPcb );
+
+    /**
+     * Function QueryPads
+     * finds the pads which can be an obstacle (or a thermal relief) in aArea.
+     * The pads of all layers are returned, because pads having a hole create
+     * holes on all layers.
+     * @param aArea is the zone bounding box inflated by the zone clearances.
+     * @param aPads is filled with the pads found, in board order.
+     */
+    void QueryPads( const EDA_RECT& aArea, std::vector<D_PAD*>& aPads );
+
+    /**
+     * Function QueryTracks
+     * finds the tracks and vias on aLayer whose bounding box intersects aArea.
+     * @param aTracks is filled with the tracks found, in board order.
+     */
+    void QueryTracks( const EDA_RECT& aArea, LAYER_ID aLayer, std::vector<TRACK*>& aTracks );
+
+    /**
+     * Function QueryGraphicItems
+     * finds the footprint graphic items and board graphic items on copper layers and
+     * on the board edges layer which can be an obstacle in aArea.
+     * @param aItems is filled with the items found: footprint items first, then board
+     * items, each in board order.
+     */
+    void QueryGraphicItems( const EDA_RECT& aArea, std::vector<BOARD_ITEM*>& aItems );
+
+    PAD_POLYGON_CACHE& GetPadPolygons() { return m_padPolygons; }
+
+    /**
+     * Function CollectBoardItems
+     * fills the same lists as the queries with all the pads, tracks and graphic items
+     * of aPcb, when no index is available.
+     */
+    static void CollectBoardItems( BOARD* aPcb, std::vector<D_PAD*>& aPads,
+                                   std::vector<TRACK*>& aTracks,
+                                   std::vector<BOARD_ITEM*>& aGraphicItems );
+
+private:
+    std::vector<D_PAD*>         m_pads;
+    std::vector<TRACK*>         m_tracks;
+    std::vector<BOARD_ITEM*>    m_graphicItems;
+
+    BOARD_RTREE<int>            m_padTree;
+    LAYERED_BOARD_RTREE<int>    m_trackTree;
+    BOARD_RTREE<int>            m_graphicTree;
+
+    PAD_POLYGON_CACHE           m_padPolygons;
+};
+
+#endif  // ZONE_FILL_INDEX_H
@@ -54,7 +54,8 @@
  * to add holes for pads and tracks and other items not in net.
  */
 
-bool ZONE_CONTAINER::BuildFilledSolidAreasPolygons( BOARD* aPcb, CPOLYGONS_LIST* aOutlineBuffer )
+bool ZONE_CONTAINER::BuildFilledSolidAreasPolygons( BOARD* aPcb, CPOLYGONS_LIST* aOutlineBuffer,
+                                                    ZONE_FILL_INDEX* aIndex )
 {
     /* convert outlines + holes to outlines without holes (adding extra segments if necessary)
      * m_Poly data is expected normalized, i.e. NormalizeAreaOutlines was used after building
@@ -106,9 +107,9 @@ bool ZONE_CONTAINER::BuildFilledSolidAreasPolygons( BOARD* aPcb, CPOLYGONS_LIST*
         if( IsOnCopperLayer() )
         {
             if(g_UseOldZoneFillingAlgo)
-                AddClearanceAreasPolygonsToPolysList( aPcb );
+                AddClearanceAreasPolygonsToPolysList( aPcb, aIndex );
             else
-                AddClearanceAreasPolygonsToPolysList_NG( aPcb );
+                AddClearanceAreasPolygonsToPolysList_NG( aPcb, aIndex );
         }
         else
         {
@@ -116,6 +117,8 @@ bool ZONE_CONTAINER::BuildFilledSolidAreasPolygons( BOARD* aPcb, CPOLYGONS_LIST*
             m_smoothedPoly->m_CornersList.InflateOutline(m_FilledPolysList, -margin, true );
         }
 
+        buildFilledPolysIndex();
+
         if( m_FillMode )   // if fill mode uses segments, create them:
             FillZoneAreasWithSegments();
 
@@ -26,6 +26,12 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif /* USE_OPENMP */
+
+#include <map>
+
 #include <wx/progdlg.h>
 
 #include <fctsys.h>
@@ -37,8 +43,10 @@
 #include <macros.h>
 
 #include <class_board.h>
+#include <class_module.h>
 #include <class_track.h>
 #include <class_zone.h>
+#include <zone_fill_index.h>
 
 #include <pcbnew.h>
 #include <zones.h>
@@ -46,6 +54,102 @@
 #define FORMAT_STRING _( "Filling zone %d out of %d (net %s)..." )
 
 
+/**
+ * Function zoneFillUses
+ * @return true if filling aZone reads the outline of aOther (which is rebuilt by the fill
+ * of aOther, see ZONE_CONTAINER::buildFeatureHoleList()): aOther is a keepout area or a
+ * zone having a higher priority, on the same layer and near aZone.
+ * @param aClearance is the biggest clearance used around aZone.
+ */
+static bool zoneFillUses( const ZONE_CONTAINER* aZone, const ZONE_CONTAINER* aOther,
+                          int aClearance )
+{
+    if( aOther == aZone || aOther->GetLayer() != aZone->GetLayer() )
+        return false;
+
+    if( !aOther->GetIsKeepout() && aOther->GetPriority() <= aZone->GetPriority() )
+        return false;
+
+    if( aOther->GetIsKeepout() && !aOther->GetDoNotAllowCopperPour() )
+        return false;
+
+    EDA_RECT bbox = aZone->GetBoundingBox();
+    bbox.Inflate( aClearance );
+
+    return bbox.Intersects( aOther->GetBoundingBox() );
+}
+
+
+/**
+ * Function buildZoneFillGroups
+ * splits a list of zones to fill in groups of zones which can be filled at the same time:
+ * the fill of a zone rebuilds its corner smoothed outline, which is also rebuilt by the fill
+ * of the zones using it as a hole (see zoneFillUses()).  Zones of a group do not use the same
+ * outlines, so they can be filled by several threads.
+ * @param aBoard is the board owning the zones.
+ * @param aZones is the list of zones to fill.
+ * @param aGroups is filled with the groups of zones, to be filled one after the other.
+ */
+static void buildZoneFillGroups( BOARD* aBoard, const std::vector<ZONE_CONTAINER*>& aZones,
+                                 std::vector< std::vector<ZONE_CONTAINER*> >& aGroups )
+{
+    int areaCount = aBoard->GetAreaCount();
+    int biggestClearance = aBoard->GetDesignSettings().GetBiggestClearanceValue();
+
+    // Zones (by board index) whose outline is rebuilt by the fill of each group
+    std::vector< std::vector<bool> > groupOutlines;
+
+    std::vector<int> used;
+
+    for( unsigned ii = 0; ii < aZones.size(); ++ii )
+    {
+        ZONE_CONTAINER* zone = aZones[ii];
+        int clearance = std::max( biggestClearance,
+                                  std::max( zone->GetZoneClearance(), zone->GetClearance() ) )
+                        + zone->GetMinThickness();
+
+        // The zone itself, and the zones used as holes
+        used.clear();
+
+        for( int jj = 0; jj < areaCount; ++jj )
+        {
+            ZONE_CONTAINER* other = aBoard->GetArea( jj );
+
+            if( other == zone || zoneFillUses( zone, other, clearance ) )
+                used.push_back( jj );
+        }
+
+        // Find the first group which does not use these zones
+        unsigned group;
+
+        for( group = 0; group < aGroups.size(); ++group )
+        {
+            unsigned kk;
+
+            for( kk = 0; kk < used.size(); ++kk )
+            {
+                if( groupOutlines[group][used[kk]] )
+                    break;
+            }
+
+            if( kk == used.size() )
+                break;
+        }
+
+        if( group == aGroups.size() )
+        {
+            aGroups.resize( group + 1 );
+            groupOutlines.resize( group + 1, std::vector<bool>( areaCount, false ) );
+        }
+
+        aGroups[group].push_back( zone );
+
+        for( unsigned kk = 0; kk < used.size(); ++kk )
+            groupOutlines[group][used[kk]] = true;
+    }
+}
+
+
 /**
  * Function Delete_OldZone_Fill (obsolete)
  * Used for compatibility with old boards
@@ -87,8 +191,16 @@ void PCB_EDIT_FRAME::Delete_OldZone_Fill( SEGZONE* aZone, time_t aTimestamp )
 }
 
 
-int PCB_EDIT_FRAME::Fill_Zone( ZONE_CONTAINER* aZone )
+int PCB_EDIT_FRAME::Fill_Zone( ZONE_CONTAINER* aZone, ZONE_FILL_INDEX* aIndex )
 {
+    uint64_t fillHash = aZone->CalculateFillHash( GetBoard(), aIndex );
+
+    // Nothing used to fill the zone has changed since the last fill: keep the filled areas
+    // (unless they are dumped for debugging)
+    if( !aZone->GetIsKeepout() && !g_DumpZonesWhenFilling
+      && aZone->IsFilled() && aZone->GetFillHash() == fillHash )
+        return 0;
+
     aZone->ClearFilledPolysList();
     aZone->UnFill();
 
@@ -114,7 +226,8 @@ int PCB_EDIT_FRAME::Fill_Zone( ZONE_CONTAINER* aZone )
 
     wxBusyCursor dummy;     // Shows an hourglass cursor (removed by its destructor)
 
-    aZone->BuildFilledSolidAreasPolygons( GetBoard() );
+    aZone->BuildFilledSolidAreasPolygons( GetBoard(), NULL, aIndex );
+    aZone->SetFillHash( fillHash );
     aZone->ViewUpdate( KIGFX::VIEW_ITEM::ALL );
     GetBoard()->GetRatsnest()->Update( aZone );
 
@@ -146,26 +259,144 @@ int PCB_EDIT_FRAME::Fill_All_Zones( wxWindow * aActiveWindow, bool aVerbose )
     // Remove segment zones
     GetBoard()->m_Zone.DeleteAll();
 
-    int ii;
+    int ii = 0;
 
-    for( ii = 0; ii < areaCount; ii++ )
+    // Items are searched in an index, to avoid a full board walk for each zone
+    ZONE_FILL_INDEX fillIndex( GetBoard() );
+
+#ifdef USE_OPENMP
+    // The zone dump file is shared by all zones, so zones are filled by only one thread
+    // when it is used
+    if( !g_DumpZonesWhenFilling && omp_get_max_threads() > 1 )
     {
-        ZONE_CONTAINER* zoneContainer = GetBoard()->GetArea( ii );
-        if( zoneContainer->GetIsKeepout() )
-            continue;
+        std::vector<ZONE_CONTAINER*> zones;
+        std::map<ZONE_CONTAINER*, uint64_t> fillHashes;
+
+        for( int jj = 0; jj < areaCount; jj++ )
+        {
+            ZONE_CONTAINER* zoneContainer = GetBoard()->GetArea( jj );
+
+            if( zoneContainer->GetIsKeepout() )
+                continue;
+
+            // Zones not changed since their last fill are skipped (see Fill_Zone())
+            uint64_t fillHash = zoneContainer->CalculateFillHash( GetBoard(), &fillIndex );
+
+            if( zoneContainer->IsFilled() && zoneContainer->GetFillHash() == fillHash )
+            {
+                ii++;
+                continue;
+            }
+
+            zones.push_back( zoneContainer );
+            fillHashes[zoneContainer] = fillHash;
+        }
 
-        msg.Printf( FORMAT_STRING, ii + 1, areaCount, GetChars( zoneContainer->GetNetname() ) );
+        std::vector< std::vector<ZONE_CONTAINER*> > groups;
+        buildZoneFillGroups( GetBoard(), zones, groups );
 
-        if( progressDialog )
+        // The pad bounding radius is computed on request and stored in the pad:
+        // compute it now, before pads are shared by threads
+        for( MODULE* module = GetBoard()->m_Modules; module; module = module->Next() )
         {
-            if( !progressDialog->Update( ii+1, msg ) )
-                break;  // Aborted by user
+            for( D_PAD* pad = module->Pads(); pad; pad = pad->Next() )
+                pad->GetBoundingRadius();
         }
 
-        errorLevel = Fill_Zone( zoneContainer );
+        // Zones of a group are filled by blocks of a few zones, to report the progress and
+        // to test the cancel button of the progress dialog between blocks
+        int  blockSize = omp_get_max_threads();
+        bool aborted = false;
 
-        if( errorLevel && !aVerbose )
-            break;
+        std::vector<ZONE_CONTAINER*> filled;
+
+        for( unsigned group = 0; group < groups.size() && !aborted; ++group )
+        {
+            const std::vector<ZONE_CONTAINER*>& groupZones = groups[group];
+            int count = groupZones.size();
+
+            for( int first = 0; first < count; first += blockSize )
+            {
+                int last = std::min( first + blockSize, count );
+
+                msg.Printf( FORMAT_STRING, ii + 1, areaCount,
+                            GetChars( groupZones[first]->GetNetname() ) );
+
+                if( progressDialog && !progressDialog->Update( ii + 1, msg ) )
+                {
+                    aborted = true;     // Aborted by user
+                    break;
+                }
+
+                #pragma omp parallel for schedule(dynamic, 1)
+                for( int jj = first; jj < last; ++jj )
+                {
+                    ZONE_CONTAINER* zone = groupZones[jj];
+
+                    // The segment fill can show a message box, which must be done by the
+                    // main thread: these zones are filled below
+                    if( zone->GetFillMode() )
+                        continue;
+
+                    zone->ClearFilledPolysList();
+                    zone->UnFill();
+                    zone->BuildFilledSolidAreasPolygons( GetBoard(), NULL, &fillIndex );
+                }
+
+                for( int jj = first; jj < last; ++jj )
+                {
+                    ZONE_CONTAINER* zone = groupZones[jj];
+
+                    if( !zone->GetFillMode() )
+                        continue;
+
+                    zone->ClearFilledPolysList();
+                    zone->UnFill();
+                    zone->BuildFilledSolidAreasPolygons( GetBoard(), NULL, &fillIndex );
+                }
+
+                for( int jj = first; jj < last; ++jj )
+                {
+                    groupZones[jj]->SetFillHash( fillHashes[groupZones[jj]] );
+                    filled.push_back( groupZones[jj] );
+                }
+
+                ii += last - first;
+            }
+        }
+
+        // Views and ratsnest are not thread safe
+        for( unsigned jj = 0; jj < filled.size(); ++jj )
+        {
+            filled[jj]->ViewUpdate( KIGFX::VIEW_ITEM::ALL );
+            GetBoard()->GetRatsnest()->Update( filled[jj] );
+        }
+
+        if( !filled.empty() )
+            OnModify();
+    }
+    else
+#endif /* USE_OPENMP */
+    {
+        for( ii = 0; ii < areaCount; ii++ )
+        {
+            ZONE_CONTAINER* zoneContainer = GetBoard()->GetArea( ii );
+            if( zoneContainer->GetIsKeepout() )
+                continue;
+
+            msg.Printf( FORMAT_STRING, ii + 1, areaCount, GetChars( zoneContainer->GetNetname() ) );
+
+            if( progressDialog )
+            {
+                if( !progressDialog->Update( ii+1, msg ) )
+                    break;  // Aborted by user
+            }
+
+            errorLevel = Fill_Zone( zoneContainer, &fillIndex );
+
+            if( errorLevel && !aVerbose )
+                break;
+        }
     }
 
     if( progressDialog )
@@ -59,6 +59,7 @@
 #include <class_drawsegment.h>
 #include <class_pcb_text.h>
 #include <class_zone.h>
+#include <zone_fill_index.h>
 #include <project.h>
 
 #include <pcbnew.h>
@@ -90,7 +91,25 @@ extern void CreateThermalReliefPadPolygon( CPOLYGONS_LIST& aCornerBuffer,
 // Local Variables:
 static double s_thermalRot = 450;  // angle of stubs in thermal reliefs for round pads
 
-void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, CPOLYGONS_LIST& aFeatures )
+/**
+ * Function addPadShape
+ * adds the shape of aPad inflated by aClearance to aFeatures, using the pad polygons
+ * cache of aIndex if any.
+ */
+static void addPadShape( ZONE_FILL_INDEX* aIndex, CPOLYGONS_LIST& aFeatures, D_PAD* aPad,
+                         int aClearance, int aSegsPerCircle, double aCorrectionFactor )
+{
+    if( aIndex )
+        aIndex->GetPadPolygons().TransformPadShapeWithClearanceToPolygon(
+                aFeatures, *aPad, aClearance, aSegsPerCircle, aCorrectionFactor );
+    else
+        aPad->TransformShapeWithClearanceToPolygon( aFeatures, aClearance,
+                                                    aSegsPerCircle, aCorrectionFactor );
+}
+
+
+void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, CPOLYGONS_LIST& aFeatures,
+                                           ZONE_FILL_INDEX* aIndex )
 {
     int segsPerCircle;
     double correctionFactor;
@@ -128,6 +147,28 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, CPOLYGONS_LIST& aFeature
     biggest_clearance = std::max( biggest_clearance, zone_clearance );
     zone_boundingbox.Inflate( biggest_clearance );
 
+    /* Candidate items: only the items close to the zone when the board is indexed.
+     * The query area covers the biggest clearance and thermal gap of the pads, the
+     * tests below are the same in both cases.
+     */
+    std::vector<D_PAD*>         pads;
+    std::vector<TRACK*>         tracks;
+    std::vector<BOARD_ITEM*>    graphicItems;
+
+    if( aIndex )
+    {
+        EDA_RECT query_area = zone_boundingbox;
+        query_area.Inflate( outline_half_thickness + m_ThermalReliefGap );
+
+        aIndex->QueryPads( query_area, pads );
+        aIndex->QueryTracks( zone_boundingbox, GetLayer(), tracks );
+        aIndex->QueryGraphicItems( zone_boundingbox, graphicItems );
+    }
+    else
+    {
+        ZONE_FILL_INDEX::CollectBoardItems( aPcb, pads, tracks, graphicItems );
+    }
+
     /*
      * First : Add pads. Note: pads having the same net as zone are left in zone.
      * Thermal shapes will be created later if necessary
@@ -144,78 +185,67 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, CPOLYGONS_LIST& aFeature
     MODULE dummymodule( aPcb );    // Creates a dummy parent
     D_PAD dummypad( &dummymodule );
 
-    for( MODULE* module = aPcb->m_Modules;  module;  module = module->Next() )
+    for( unsigned ii = 0; ii < pads.size(); ii++ )
     {
-        D_PAD* nextpad;
+        D_PAD* pad = pads[ii];  // pad pointer can be modified by next code
 
-        for( D_PAD* pad = module->Pads(); pad != NULL; pad = nextpad )
+        if( !pad->IsOnLayer( GetLayer() ) )
         {
-            nextpad = pad->Next();  // pad pointer can be modified by next code, so
-                                    // calculate the next pad here
+            /* Test for pads that are on top or bottom only and have a hole.
+             * There are curious pads but they can be used for some components that are
+             * inside the board (in fact inside the hole. Some photo diodes and Leds are
+             * like this)
+             */
+            if( pad->GetDrillSize().x == 0 && pad->GetDrillSize().y == 0 )
+                continue;
 
-            if( !pad->IsOnLayer( GetLayer() ) )
-            {
-                /* Test for pads that are on top or bottom only and have a hole.
-                 * There are curious pads but they can be used for some components that are
-                 * inside the board (in fact inside the hole. Some photo diodes and Leds are
-                 * like this)
-                 */
-                if( pad->GetDrillSize().x == 0 && pad->GetDrillSize().y == 0 )
-                    continue;
-
-                // Use a dummy pad to calculate a hole shape that have the same dimension as
-                // the pad hole
-                dummypad.SetSize( pad->GetDrillSize() );
-                dummypad.SetOrientation( pad->GetOrientation() );
-                dummypad.SetShape( pad->GetDrillShape() == PAD_DRILL_OBLONG ?
-                                   PAD_OVAL : PAD_CIRCLE );
-                dummypad.SetPosition( pad->GetPosition() );
-
-                pad = &dummypad;
-            }
+            // Use a dummy pad to calculate a hole shape that have the same dimension as
+            // the pad hole
+            dummypad.SetSize( pad->GetDrillSize() );
+            dummypad.SetOrientation( pad->GetOrientation() );
+            dummypad.SetShape( pad->GetDrillShape() == PAD_DRILL_OBLONG ?
+                               PAD_OVAL : PAD_CIRCLE );
+            dummypad.SetPosition( pad->GetPosition() );
 
-            // Note: netcode <=0 means not connected item
-            if( ( pad->GetNetCode() != GetNetCode() ) || ( pad->GetNetCode() <= 0 ) )
-            {
-                item_clearance   = pad->GetClearance() + outline_half_thickness;
-                item_boundingbox = pad->GetBoundingBox();
-                item_boundingbox.Inflate( item_clearance );
-
-                if( item_boundingbox.Intersects( zone_boundingbox ) )
-                {
-                    int clearance = std::max( zone_clearance, item_clearance );
-                    pad->TransformShapeWithClearanceToPolygon( aFeatures,
-                                                               clearance,
-                                                               segsPerCircle,
-                                                               correctionFactor );
-                }
+            pad = &dummypad;
+        }
 
-                continue;
-            }
+        // Note: netcode <=0 means not connected item
+        if( ( pad->GetNetCode() != GetNetCode() ) || ( pad->GetNetCode() <= 0 ) )
+        {
+            item_clearance   = pad->GetClearance() + outline_half_thickness;
+            item_boundingbox = pad->GetBoundingBox();
+            item_boundingbox.Inflate( item_clearance );
 
-            if( GetPadConnection( pad ) == PAD_NOT_IN_ZONE )
+            if( item_boundingbox.Intersects( zone_boundingbox ) )
             {
-                int gap = zone_clearance;
-                int thermalGap = GetThermalReliefGap( pad );
-                gap = std::max( gap, thermalGap );
-                item_boundingbox = pad->GetBoundingBox();
-
-                if( item_boundingbox.Intersects( zone_boundingbox ) )
-                {
-                    pad->TransformShapeWithClearanceToPolygon( aFeatures,
-                                                               gap,
-                                                               segsPerCircle,
-                                                               correctionFactor );
-                }
+                int clearance = std::max( zone_clearance, item_clearance );
+                addPadShape( aIndex, aFeatures, pad, clearance,
+                             segsPerCircle, correctionFactor );
             }
+
+            continue;
+        }
+
+        if( GetPadConnection( pad ) == PAD_NOT_IN_ZONE )
+        {
+            int gap = zone_clearance;
+            int thermalGap = GetThermalReliefGap( pad );
+            gap = std::max( gap, thermalGap );
+            item_boundingbox = pad->GetBoundingBox();
+
+            if( item_boundingbox.Intersects( zone_boundingbox ) )
+                addPadShape( aIndex, aFeatures, pad, gap, segsPerCircle, correctionFactor );
         }
     }
 
     /* Add holes (i.e. tracks and vias areas as polygons outlines)
      * in cornerBufferPolysToSubstract
      */
-    for( TRACK* track = aPcb->m_Track;  track;  track = track->Next() )
+    for( unsigned ii = 0; ii < tracks.size(); ii++ )
     {
+        TRACK* track = tracks[ii];
+
         if( !track->IsOnLayer( GetLayer() ) )
             continue;
 
@@ -239,30 +269,31 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, CPOLYGONS_LIST& aFeature
      * Pcbnew allows these items to be on copper layers in microwave applictions
      * This is a bad thing, but must be handled here, until a better way is found
      */
-    for( MODULE* module = aPcb->m_Modules;  module;  module = module->Next() )
+    for( unsigned ii = 0; ii < graphicItems.size(); ii++ )
     {
-        for( BOARD_ITEM* item = module->GraphicalItems();  item;  item = item->Next() )
-        {
-            if( !item->IsOnLayer( GetLayer() ) && !item->IsOnLayer( Edge_Cuts ) )
-                continue;
+        BOARD_ITEM* item = graphicItems[ii];
 
-            if( item->Type() != PCB_MODULE_EDGE_T )
-                continue;
+        if( item->Type() != PCB_MODULE_EDGE_T )
+            continue;
 
-            item_boundingbox = item->GetBoundingBox();
+        if( !item->IsOnLayer( GetLayer() ) && !item->IsOnLayer( Edge_Cuts ) )
+            continue;
 
-            if( item_boundingbox.Intersects( zone_boundingbox ) )
-            {
-                ( (EDGE_MODULE*) item )->TransformShapeWithClearanceToPolygon(
-                    aFeatures, zone_clearance,
-                    segsPerCircle, correctionFactor );
-            }
+        item_boundingbox = item->GetBoundingBox();
+
+        if( item_boundingbox.Intersects( zone_boundingbox ) )
+        {
+            ( (EDGE_MODULE*) item )->TransformShapeWithClearanceToPolygon(
+                aFeatures, zone_clearance,
+                segsPerCircle, correctionFactor );
         }
     }
 
     // Add graphic items (copper texts) and board edges
-    for( BOARD_ITEM* item = aPcb->m_Drawings; item; item = item->Next() )
+    for( unsigned ii = 0; ii < graphicItems.size(); ii++ )
     {
+        BOARD_ITEM* item = graphicItems[ii];
+
         if( item->GetLayer() != GetLayer() && item->GetLayer() != Edge_Cuts )
             continue;
 
@@ -332,37 +363,45 @@ void ZONE_CONTAINER::buildFeatureHoleList( BOARD* aPcb, CPOLYGONS_LIST& aFeature
     }
 
    // Remove thermal symbols
-    for( MODULE* module = aPcb->m_Modules;  module;  module = module->Next() )
+    for( unsigned ii = 0; ii < pads.size(); ii++ )
     {
-        for( D_PAD* pad = module->Pads(); pad != NULL; pad = pad->Next() )
-        {
-            // Rejects non-standard pads with tht-only thermal reliefs
-            if( GetPadConnection( pad ) == THT_THERMAL
-             && pad->GetAttribute() != PAD_STANDARD )
-                continue;
+        D_PAD* pad = pads[ii];
 
-            if( GetPadConnection( pad ) != THERMAL_PAD
-             && GetPadConnection( pad ) != THT_THERMAL )
-                continue;
+        // Rejects non-standard pads with tht-only thermal reliefs
+        if( GetPadConnection( pad ) == THT_THERMAL
+         && pad->GetAttribute() != PAD_STANDARD )
+            continue;
 
-            if( !pad->IsOnLayer( GetLayer() ) )
-                continue;
+        if( GetPadConnection( pad ) != THERMAL_PAD
+         && GetPadConnection( pad ) != THT_THERMAL )
+            continue;
 
-            if( pad->GetNetCode() != GetNetCode() )
-                continue;
-            item_boundingbox = pad->GetBoundingBox();
-            int thermalGap = GetThermalReliefGap( pad );
-            item_boundingbox.Inflate( thermalGap, thermalGap );
+        if( !pad->IsOnLayer( GetLayer() ) )
+            continue;
 
-            if( item_boundingbox.Intersects( zone_boundingbox ) )
-            {
+        if( pad->GetNetCode() != GetNetCode() )
+            continue;
+        item_boundingbox = pad->GetBoundingBox();
+        int thermalGap = GetThermalReliefGap( pad );
+        item_boundingbox.Inflate( thermalGap, thermalGap );
+
+        if( item_boundingbox.Intersects( zone_boundingbox ) )
+        {
+            // Thermal reliefs of identical pads are built once for all zones
+            if( aIndex )
+                aIndex->GetPadPolygons().CreateThermalReliefPadPolygon( aFeatures,
+                                               *pad, thermalGap,
+                                               GetThermalReliefCopperBridge( pad ),
+                                               m_ZoneMinThickness,
+                                               segsPerCircle,
+                                               correctionFactor, s_thermalRot );
+            else
                 CreateThermalReliefPadPolygon( aFeatures,
                                                *pad, thermalGap,
                                                GetThermalReliefCopperBridge( pad ),
                                                m_ZoneMinThickness,
                                                segsPerCircle,
                                                correctionFactor, s_thermalRot );
-            }
         }
     }
 
@@ -476,7 +515,8 @@ static const SHAPE_POLY_SET convertBoostToPolySet ( const KI_POLYGON_SET& aSet )
  *     Remove new insulated copper islands
  */
 
-void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb )
+void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb,
+                                                              ZONE_FILL_INDEX* aIndex )
 {
     int segsPerCircle;
     double correctionFactor;
@@ -510,7 +550,7 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb )
 
 
     tmp.RemoveAllContours();
-    buildFeatureHoleList( aPcb, tmp );
+    buildFeatureHoleList( aPcb, tmp, aIndex );
     SHAPE_POLY_SET holes = convertPolyListToPolySet( tmp );
 
     if(g_DumpZonesWhenFilling)
@@ -535,6 +575,7 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb )
         dumper->Write ( &fractured, "fractured" );
 
     m_FilledPolysList =  convertPolySetToPolyList( fractured );
+    buildFilledPolysIndex();
 
     if (g_DumpZonesWhenFilling)
     {
@@ -576,6 +617,7 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb )
             dumper->Write ( &fractured, "fractured" );
 
         m_FilledPolysList = convertPolySetToPolyList( fractured );
+        buildFilledPolysIndex();
 
         if( GetNetCode() > 0 )
             TestForCopperIslandAndRemoveInsulatedIslands( aPcb );
@@ -585,7 +627,8 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList_NG( BOARD* aPcb )
         dumper->EndGroup();
 }
 
-void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList( BOARD* aPcb )
+void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList( BOARD* aPcb,
+                                                           ZONE_FILL_INDEX* aIndex )
 {
     int segsPerCircle;
     double correctionFactor;
@@ -637,7 +680,7 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList( BOARD* aPcb )
  if (g_DumpZonesWhenFilling)
         dumper->Write ( convertBoostToPolySet( polyset_zone_solid_areas ), "solid-areas" );
 
-    buildFeatureHoleList( aPcb, cornerBufferPolysToSubstract );
+    buildFeatureHoleList( aPcb, cornerBufferPolysToSubstract, aIndex );
 
     // cornerBufferPolysToSubstract contains polygons to substract.
     // polyset_zone_solid_areas contains the main filled area
@@ -704,4 +747,5 @@ void ZONE_CONTAINER::CopyPolygonsFromKiPolygonListToFilledPolysList( KI_POLYGON_
 {
     m_FilledPolysList.RemoveAllContours();
     m_FilledPolysList.ImportFrom( aKiPolyList );
+    buildFilledPolysIndex();
 }
@@ -0,0 +1,330 @@
+/**
+ * @file zones_fill_hash.cpp
+ * @brief Hash of the data used to fill a zone, to skip the refill of unchanged zones.
+ */
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see change_log.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <fctsys.h>
+#include <common.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_track.h>
+#include <class_edge_mod.h>
+#include <class_drawsegment.h>
+#include <class_pcb_text.h>
+#include <class_zone.h>
+#include <zone_fill_index.h>
+
+#include <pcbnew.h>
+
+/* Version of the data hashed below.
+ * It must be incremented each time the fill algorithm or the hashed data change,
+ * to invalidate the hashes stored in the board files.
+ */
+#define ZONE_FILL_HASH_VERSION  2
+
+
+/**
+ * Class FILL_HASH
+ * accumulates values in a 64 bits FNV-1a hash.
+ * The values are hashed byte by byte in a fixed order, so the hash does not
+ * depend on the platform and can be saved in board files.
+ */
+class FILL_HASH
+{
+public:
+    FILL_HASH() : m_hash( 0xCBF29CE484222325ULL )
+    {
+    }
+
+    void Add( int64_t aValue )
+    {
+        uint64_t value = (uint64_t) aValue;
+
+        for( int ii = 0; ii < 8; ++ii, value >>= 8 )
+        {
+            m_hash ^= value & 0xFF;
+            m_hash *= 0x100000001B3ULL;
+        }
+    }
+
+    void Add( int aValue )          { Add( (int64_t) aValue ); }
+    void Add( bool aValue )         { Add( (int64_t) aValue ); }
+
+    /// Angles (in 0.1 degree) are hashed with a 0.001 degree resolution.
+    void AddAngle( double aValue )  { Add( (int64_t) KiROUND( aValue * 100 ) ); }
+
+    void Add( const wxPoint& aPoint )
+    {
+        Add( aPoint.x );
+        Add( aPoint.y );
+    }
+
+    void Add( const wxSize& aSize )
+    {
+        Add( aSize.x );
+        Add( aSize.y );
+    }
+
+    void Add( const EDA_RECT& aRect )
+    {
+        Add( aRect.GetOrigin() );
+        Add( aRect.GetSize() );
+    }
+
+    void Add( const std::vector<wxPoint>& aPoints )
+    {
+        Add( (int) aPoints.size() );
+
+        for( unsigned ii = 0; ii < aPoints.size(); ++ii )
+            Add( aPoints[ii] );
+    }
+
+    void Add( const CPolyLine& aPoly )
+    {
+        Add( aPoly.GetCornersCount() );
+
+        for( int ii = 0; ii < aPoly.GetCornersCount(); ++ii )
+        {
+            Add( aPoly.GetPos( ii ) );
+            Add( aPoly.IsEndContour( ii ) );
+        }
+    }
+
+    uint64_t GetHash() const
+    {
+        // 0 is used for "no hash"
+        return m_hash ? m_hash : 1;
+    }
+
+private:
+    uint64_t m_hash;
+};
+
+
+static void hashDrawSegment( FILL_HASH& aHash, const DRAWSEGMENT* aSegment )
+{
+    aHash.Add( aSegment->GetLayer() );
+    aHash.Add( aSegment->GetShape() );
+    aHash.Add( aSegment->GetStart() );
+    aHash.Add( aSegment->GetEnd() );
+    aHash.AddAngle( aSegment->GetAngle() );
+    aHash.Add( aSegment->GetWidth() );
+    aHash.Add( aSegment->GetPolyPoints() );
+
+    // Polygons of footprints are given relative to the footprint
+    MODULE* module = aSegment->GetParentModule();
+
+    if( module )
+    {
+        aHash.Add( module->GetPosition() );
+        aHash.AddAngle( module->GetOrientation() );
+    }
+}
+
+
+uint64_t ZONE_CONTAINER::CalculateFillHash( BOARD* aPcb, ZONE_FILL_INDEX* aIndex ) const
+{
+    FILL_HASH hash;
+
+    hash.Add( ZONE_FILL_HASH_VERSION );
+    hash.Add( g_UseOldZoneFillingAlgo );
+
+    // The zone itself
+    hash.Add( GetLayer() );
+    hash.Add( GetNetCode() );
+    hash.Add( *m_Poly );
+    hash.Add( GetIsKeepout() );
+    hash.Add( (int) m_priority );
+    hash.Add( m_ZoneClearance );
+    hash.Add( GetClearance() );
+    hash.Add( m_ZoneMinThickness );
+    hash.Add( m_FillMode );
+    hash.Add( m_ArcToSegmentsCount );
+    hash.Add( m_PadConnection );
+    hash.Add( m_ThermalReliefGap );
+    hash.Add( m_ThermalReliefCopperBridge );
+    hash.Add( m_cornerSmoothingType );
+    hash.Add( (int) m_cornerRadius );
+
+    // Zones on technical layers are filled from their outline only
+    if( !IsOnCopperLayer() )
+        return hash.GetHash();
+
+    /* Items outside the zone bounding box + the biggest clearance cannot
+     * change the filled areas (see buildFeatureHoleList())
+     */
+    int outline_half_thickness = m_ZoneMinThickness / 2;
+    int zone_clearance = std::max( m_ZoneClearance, GetClearance() ) + outline_half_thickness;
+    int board_clearance = aPcb->GetDesignSettings().GetBiggestClearanceValue();
+    int biggest_clearance = std::max( board_clearance, zone_clearance );
+    hash.Add( biggest_clearance );
+
+    EDA_RECT zone_boundingbox = GetBoundingBox();
+    zone_boundingbox.Inflate( biggest_clearance );
+
+    /* Candidate items: only the items close to the zone when the board is indexed.
+     * The query areas cover the margins used below, so the tests below, and therefore
+     * the hash, are the same in both cases.
+     */
+    std::vector<D_PAD*>         pads;
+    std::vector<TRACK*>         tracks;
+    std::vector<BOARD_ITEM*>    graphicItems;
+
+    if( aIndex )
+    {
+        EDA_RECT query_area = zone_boundingbox;
+        query_area.Inflate( outline_half_thickness + m_ThermalReliefGap );
+        aIndex->QueryPads( query_area, pads );
+
+        query_area = zone_boundingbox;
+        query_area.Inflate( board_clearance + outline_half_thickness );
+        aIndex->QueryTracks( query_area, GetLayer(), tracks );
+
+        aIndex->QueryGraphicItems( zone_boundingbox, graphicItems );
+    }
+    else
+    {
+        ZONE_FILL_INDEX::CollectBoardItems( aPcb, pads, tracks, graphicItems );
+    }
+
+    EDA_RECT item_boundingbox;
+
+    // Pads (holes, thermal reliefs and unconnected pads used to remove the copper islands)
+    for( unsigned ii = 0; ii < pads.size(); ii++ )
+    {
+        D_PAD* pad = pads[ii];
+        int thermalGap = GetThermalReliefGap( pad );
+        int margin = std::max( pad->GetClearance(), thermalGap ) + outline_half_thickness;
+
+        item_boundingbox = pad->GetBoundingBox();
+        item_boundingbox.Inflate( margin );
+
+        if( !item_boundingbox.Intersects( zone_boundingbox ) )
+            continue;
+
+        hash.Add( pad->IsOnLayer( GetLayer() ) );
+        hash.Add( pad->GetNetCode() );
+        hash.Add( pad->GetShape() );
+        hash.Add( pad->GetPosition() );
+        hash.Add( pad->ShapePos() );
+        hash.Add( pad->GetSize() );
+        hash.Add( pad->GetDelta() );
+        hash.Add( pad->GetOffset() );
+        hash.AddAngle( pad->GetOrientation() );
+        hash.Add( pad->GetDrillSize() );
+        hash.Add( pad->GetDrillShape() );
+        hash.Add( pad->GetAttribute() );
+        hash.Add( pad->GetClearance() );
+        hash.Add( GetPadConnection( pad ) );
+        hash.Add( thermalGap );
+        hash.Add( GetThermalReliefCopperBridge( pad ) );
+    }
+
+    // Tracks and vias
+    for( unsigned ii = 0; ii < tracks.size(); ii++ )
+    {
+        TRACK* track = tracks[ii];
+
+        if( !track->IsOnLayer( GetLayer() ) )
+            continue;
+
+        item_boundingbox = track->GetBoundingBox();
+        item_boundingbox.Inflate( track->GetClearance() + outline_half_thickness );
+
+        if( !item_boundingbox.Intersects( zone_boundingbox ) )
+            continue;
+
+        hash.Add( track->Type() );
+        hash.Add( track->GetNetCode() );
+        hash.Add( track->GetStart() );
+        hash.Add( track->GetEnd() );
+        hash.Add( track->GetWidth() );
+        hash.Add( track->GetClearance() );
+    }
+
+    // Footprint graphic items on copper layers and board edges, then board graphic
+    // items (copper texts) and board edges
+    for( unsigned ii = 0; ii < graphicItems.size(); ii++ )
+    {
+        BOARD_ITEM* item = graphicItems[ii];
+
+        if( !item->IsOnLayer( GetLayer() ) && !item->IsOnLayer( Edge_Cuts ) )
+            continue;
+
+        if( !item->GetBoundingBox().Intersects( zone_boundingbox ) )
+            continue;
+
+        switch( item->Type() )
+        {
+        case PCB_MODULE_EDGE_T:
+        case PCB_LINE_T:
+            hashDrawSegment( hash, (DRAWSEGMENT*) item );
+            break;
+
+        case PCB_TEXT_T:
+        {
+            TEXTE_PCB* text = (TEXTE_PCB*) item;
+
+            if( text->GetText().Length() == 0 )
+                break;
+
+            hash.Add( text->GetLayer() );
+            hash.Add( text->GetTextBox( -1 ) );
+            hash.Add( text->GetTextPosition() );
+            hash.AddAngle( text->GetOrientation() );
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    // Other zones on the same layer (keepout and higher priority zones)
+    for( int ii = 0; ii < aPcb->GetAreaCount(); ii++ )
+    {
+        ZONE_CONTAINER* zone = aPcb->GetArea( ii );
+
+        if( zone == this || zone->GetLayer() != GetLayer() )
+            continue;
+
+        if( !zone->GetBoundingBox().Intersects( zone_boundingbox ) )
+            continue;
+
+        hash.Add( zone->GetNetCode() );
+        hash.Add( *zone->Outline() );
+        hash.Add( zone->GetIsKeepout() );
+        hash.Add( zone->GetDoNotAllowCopperPour() );
+        hash.Add( (int) zone->GetPriority() );
+        hash.Add( zone->GetClearance() );
+        hash.Add( zone->GetCornerSmoothingType() );
+        hash.Add( (int) zone->GetCornerRadius() );
+        hash.Add( zone->GetArcSegmentCount() );
+    }
+
+    return hash.GetHash();
+}
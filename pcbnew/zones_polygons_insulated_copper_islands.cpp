@@ -114,6 +114,8 @@ void ZONE_CONTAINER::TestForCopperIslandAndRemoveInsulatedIslands( BOARD* aPcb )
             }
         }
     }
+
+    buildFilledPolysIndex();
 }
 
 
@@ -39,22 +39,16 @@
 
 #include <pcbnew.h>
 #include <zones.h>
-#include <polygon_test_point_inside.h>
+#include <connect.h>
 
 static bool CmpZoneSubnetValue( const BOARD_CONNECTED_ITEM* a, const BOARD_CONNECTED_ITEM* b );
 
 void Merge_SubNets_Connected_By_CopperAreas( BOARD* aPcb, int aNetcode );
 
-// This helper function sort a list of zones by netcode,
-// and for a given netcode by zone size
-// zone size = size of the m_FilledPolysList buffer
+// This helper function sort a list of zones by netcode
 bool sort_areas( const ZONE_CONTAINER* ref, const ZONE_CONTAINER* tst )
 {
-    if( ref->GetNetCode() == tst->GetNetCode() )
-        return ref->GetFilledPolysList().GetCornersCount() <
-               tst->GetFilledPolysList().GetCornersCount();
-    else
-        return ref->GetNetCode() < tst->GetNetCode();
+    return ref->GetNetCode() < tst->GetNetCode();
 }
 
 /**
@@ -83,14 +77,14 @@ void BOARD::Test_Connections_To_Copper_Areas( int aNetcode )
             track->SetZoneSubNet( 0 );
     }
 
-    // examine all zones, net by net:
-    int subnet = 0;
-
     // Build zones candidates list
     std::vector<ZONE_CONTAINER*> zones_candidates;
 
     zones_candidates.reserve( GetAreaCount() );
 
+    // Each filled sub-area of the zones gives a zone subnet value (> 0).
+    int subnetCount = 1;
+
     for( int index = 0; index < GetAreaCount(); index++ )
     {
         ZONE_CONTAINER* zone = GetArea( index );
@@ -105,17 +99,21 @@ void BOARD::Test_Connections_To_Copper_Areas( int aNetcode )
             continue;
 
         zones_candidates.push_back( zone );
+        subnetCount += zone->GetFilledPolysIndex().GetSubAreaCount();
     }
 
-    // sort them by netcode then vertices count.
-    // For a given net, examine the smaller zones first slightly speed up calculation
-    // (25% faster)
-    // this is only noticeable with very large boards and depends on board zones topology
-    // This is due to the fact some items are connected by small zones ares,
-    // before examining large zones areas and these items are not tested after a connection is found
+    // sort them by netcode
     sort( zones_candidates.begin(), zones_candidates.end(), sort_areas );
 
+    // When an item is connected to more than one filled sub-area, the zone subnets
+    // of these sub-areas are merged.  The final value is set in items after all zones
+    // are examined.
+    SUBNET_SETS zoneSubnets;
+    zoneSubnets.Reset( subnetCount );
+
+    int subnet = 1;     // zone subnet of the first sub-area of the current zone
     int oldnetcode = -1;
+
     for( unsigned idx = 0; idx < zones_candidates.size(); idx++ )
     {
         ZONE_CONTAINER* zone = zones_candidates[idx];
@@ -129,6 +127,11 @@ void BOARD::Test_Connections_To_Copper_Areas( int aNetcode )
         NETINFO_ITEM* net = FindNet( netcode );
 
         wxASSERT( net );
+
+        const POLY_EDGE_GRID& index = zone->GetFilledPolysIndex();
+        int firstSubnet = subnet;
+        subnet += index.GetSubAreaCount();
+
         if( net == NULL )
             continue;
 
@@ -156,105 +159,76 @@ void BOARD::Test_Connections_To_Copper_Areas( int aNetcode )
         }
 
         // test if a candidate is inside a filled area of this zone
-        unsigned indexstart = 0, indexend;
-        const CPOLYGONS_LIST& polysList = zone->GetFilledPolysList();
-
-        for( indexend = 0; indexend < polysList.GetCornersCount(); indexend++ )
+        for( unsigned ic = 0; ic < candidates.size(); ic++ )
         {
-            // end of a filled sub-area found
-            if( polysList.IsEndContour( indexend ) )
+            // test if this area is connected to a board item:
+            BOARD_CONNECTED_ITEM* item = candidates[ic];
+
+            if( !item->IsOnLayer( zone->GetLayer() ) )
+                continue;
+
+            wxPoint pos1, pos2;
+
+            if( item->Type() == PCB_PAD_T )
+            {
+                // For pads we use the shape position instead of
+                // the pad position, because the zones are connected
+                // to the center of the shape, not the pad position
+                // (this is important for pads with thermal relief)
+                pos1 = pos2 = ( (D_PAD*) item )->ShapePos();
+            }
+            else if( item->Type() == PCB_VIA_T )
+            {
+                const VIA *via = static_cast<const VIA*>( item );
+                pos1 = via->GetStart();
+                pos2 = pos1;
+            }
+            else if( item->Type() == PCB_TRACE_T )
+            {
+                const TRACK *trk = static_cast<const TRACK*>( item );
+                pos1 = trk->GetStart();
+                pos2 = trk->GetEnd();
+            }
+            else
+            {
+                continue;
+            }
+
+            // The 2 ends of a track can be inside 2 different sub-areas
+            int areas[2];
+            areas[0] = index.FindSubArea( pos1.x, pos1.y );
+            areas[1] = ( pos1 != pos2 ) ? index.FindSubArea( pos2.x, pos2.y ) : -1;
+
+            for( int ii = 0; ii < 2; ii++ )
             {
-                subnet++;
-                EDA_RECT bbox = zone->CalculateSubAreaBoundaryBox( indexstart, indexend );
-
-                for( unsigned ic = 0; ic < candidates.size(); ic++ )
-                {
-                    // test if this area is connected to a board item:
-                    BOARD_CONNECTED_ITEM* item = candidates[ic];
-
-                    if( item->GetZoneSubNet() == subnet )   // Already merged
-                        continue;
-
-                   if( !item->IsOnLayer( zone->GetLayer() ) )
-                        continue;
-
-                    wxPoint pos1, pos2;
-
-                    if( item->Type() == PCB_PAD_T )
-                    {
-                        // For pads we use the shape position instead of
-                        // the pad position, because the zones are connected
-                        // to the center of the shape, not the pad position
-                        // (this is important for pads with thermal relief)
-                        pos1 = pos2 = ( (D_PAD*) item )->ShapePos();
-                    }
-                    else if( item->Type() == PCB_VIA_T )
-                    {
-                        const VIA *via = static_cast<const VIA*>( item );
-                        pos1 = via->GetStart();
-                        pos2 = pos1;
-                    }
-                    else if( item->Type() == PCB_TRACE_T )
-                    {
-                        const TRACK *trk = static_cast<const TRACK*>( item );
-                        pos1 = trk->GetStart();
-                        pos2 = trk->GetEnd();
-                    }
-                    else
-                    {
-                        continue;
-                    }
-
-                    bool connected = false;
-
-                    if( bbox.Contains( pos1 ) )
-                    {
-                        if( TestPointInsidePolygon( polysList, indexstart,
-                                                    indexend, pos1.x, pos1.y ) )
-                            connected = true;
-                    }
-                    if( !connected && (pos1 != pos2 ) )
-                    {
-                        if( bbox.Contains( pos2 ) )
-                        {
-                            if( TestPointInsidePolygon( polysList,
-                                                        indexstart, indexend,
-                                                        pos2.x, pos2.y ) )
-                                connected = true;
-                        }
-                    }
-
-                    if( connected )
-                    {
-                        // Set ZoneSubnet to the current subnet value.
-                        // If the previous subnet is not 0, merge all items with old subnet
-                        // to the new one
-                        int old_subnet = item->GetZoneSubNet();
-                        item->SetZoneSubNet( subnet );
-
-                        // Merge previous subnet with the current
-                        if( (old_subnet > 0) && (old_subnet != subnet) )
-                        {
-                            for( unsigned jj = 0; jj < candidates.size(); jj++ )
-                            {
-                                BOARD_CONNECTED_ITEM* item_to_merge = candidates[jj];
-
-                                if( old_subnet == item_to_merge->GetZoneSubNet() )
-                                {
-                                    item_to_merge->SetZoneSubNet( subnet );
-                                }
-                            }
-                        }   // End if ( old_subnet > 0 )
-                    }       // End if( connected )
-                }
-
-                // End test candidates for the current filled area
-                indexstart = indexend + 1;  // prepare test next area, starting at indexend+1
-                                            // (if exists).  End read one area in
-                                            // zone->m_FilledPolysList
+                if( areas[ii] < 0 )
+                    continue;
+
+                int old_subnet = item->GetZoneSubNet();
+
+                if( old_subnet > 0 )
+                    zoneSubnets.Merge( old_subnet, firstSubnet + areas[ii] );
+                else
+                    item->SetZoneSubNet( firstSubnet + areas[ii] );
             }
-        } // End read all segments in zone
+        }
     } // End read all zones candidates
+
+    // Set the merged zone subnet values
+    for( MODULE* module = m_Modules;  module;  module = module->Next() )
+    {
+        for( D_PAD* pad = module->Pads();  pad;  pad = pad->Next() )
+        {
+            if( ( aNetcode < 0 || aNetcode == pad->GetNetCode() ) && pad->GetZoneSubNet() > 0 )
+                pad->SetZoneSubNet( zoneSubnets.Find( pad->GetZoneSubNet() ) );
+        }
+    }
+
+    for( TRACK* track = m_Track;  track;  track = track->Next() )
+    {
+        if( ( aNetcode < 0 || aNetcode == track->GetNetCode() ) && track->GetZoneSubNet() > 0 )
+            track->SetZoneSubNet( zoneSubnets.Find( track->GetZoneSubNet() ) );
+    }
 }
 
 
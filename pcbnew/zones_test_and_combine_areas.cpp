@@ -42,6 +42,8 @@
 #include <pcbnew.h>
 #include <drc_stuff.h>
 #include <math_for_graphics.h>
+#include <geometry/shape_poly_set.h>
+#include <geometry/seg.h>
 
 #define STRAIGHT 0      // To be remove after math_for_graphics code cleanup
 
@@ -356,17 +358,142 @@ bool BOARD::CombineAreas( PICKED_ITEMS_LIST* aDeletedList, ZONE_CONTAINER* area_
 }
 
 
+/**
+ * Function convertPolyLineToPolySet
+ * @return the outline (first contour) and the holes (other contours) of aPoly
+ * as a SHAPE_POLY_SET.
+ */
+static const SHAPE_POLY_SET convertPolyLineToPolySet( CPolyLine* aPoly )
+{
+    SHAPE_POLY_SET rv;
+
+    for( int icont = 0; icont < aPoly->GetContoursCount(); icont++ )
+    {
+        SHAPE_LINE_CHAIN contour;
+
+        for( int ic = aPoly->GetContourStart( icont ); ic <= aPoly->GetContourEnd( icont ); ic++ )
+            contour.Append( aPoly->GetX( ic ), aPoly->GetY( ic ) );
+
+        contour.SetClosed( true );
+
+        if( icont == 0 )
+            rv.AddOutline( contour );
+        else
+            rv.AddHole( contour );
+    }
+
+    return rv;
+}
+
+
+/**
+ * Function addAreaToAreaMarkers
+ * creates a marker of type aErrorCode for each polygon of aErrorAreas,
+ * at the position of its first corner.
+ * @param aSelected, if not NULL, gives the polygons of aErrorAreas which are errors
+ * @return the number of markers created
+ */
+static int addAreaToAreaMarkers( BOARD* aPcb, const SHAPE_POLY_SET& aErrorAreas, int aErrorCode,
+                                 ZONE_CONTAINER* aArea1, ZONE_CONTAINER* aArea2,
+                                 const std::vector<bool>* aSelected = NULL )
+{
+    int count = 0;
+
+    for( int ii = 0; ii < aErrorAreas.OutlineCount(); ii++ )
+    {
+        if( aSelected && !(*aSelected)[ii] )
+            continue;
+
+        VECTOR2I corner = aErrorAreas.GetVertex( 0, ii );
+        wxPoint  pos( corner.x, corner.y );
+
+        MARKER_PCB* marker = new MARKER_PCB( aErrorCode, pos,
+                                             aArea1->GetSelectMenuText(), pos,
+                                             aArea2->GetSelectMenuText(), pos );
+        aPcb->Add( marker );
+        count++;
+    }
+
+    return count;
+}
+
+
+/**
+ * Function edgesTooClose
+ * tests the exact distance between the edges of aRef and the edges of aTest near aArea.
+ * @param aArea is the bounding box of the part of aTest which can be too close to aRef
+ * @return true if an edge of aRef is closer than aClearance to an edge of aTest.
+ */
+static bool edgesTooClose( const SHAPE_POLY_SET& aRef, const SHAPE_POLY_SET& aTest,
+                           const BOX2I& aArea, int aClearance )
+{
+    BOX2I refArea = aArea;
+    refArea.Inflate( aClearance );
+
+    std::vector<SEG> refEdges;
+    std::vector<SEG> testEdges;
+
+    for( int pass = 0; pass < 2; pass++ )
+    {
+        const SHAPE_POLY_SET& polys = pass == 0 ? aRef : aTest;
+        const BOX2I&          area  = pass == 0 ? refArea : aArea;
+        std::vector<SEG>&     edges = pass == 0 ? refEdges : testEdges;
+
+        for( int ii = 0; ii < polys.OutlineCount(); ii++ )
+        {
+            const ClipperLib::Paths& paths = polys.GetPoly( ii );
+
+            for( unsigned jj = 0; jj < paths.size(); jj++ )
+            {
+                const ClipperLib::Path& path = paths[jj];
+
+                for( unsigned kk = 0; kk < path.size(); kk++ )
+                {
+                    const ClipperLib::IntPoint& a = path[kk];
+                    const ClipperLib::IntPoint& b = path[ ( kk + 1 ) % path.size() ];
+
+                    SEG   edge( VECTOR2I( a.X, a.Y ), VECTOR2I( b.X, b.Y ) );
+                    BOX2I edgeBox( edge.A, edge.B - edge.A );
+
+                    if( area.Intersects( edgeBox.Normalize() ) )
+                        edges.push_back( edge );
+                }
+            }
+        }
+    }
+
+    VECTOR2I::extended_type clearance2 = (VECTOR2I::extended_type) aClearance * aClearance;
+
+    for( unsigned ii = 0; ii < refEdges.size(); ii++ )
+    {
+        for( unsigned jj = 0; jj < testEdges.size(); jj++ )
+        {
+            if( refEdges[ii].SquaredDistance( testEdges[jj] ) < clearance2 )
+                return true;
+        }
+    }
+
+    return false;
+}
+
+
 int BOARD::Test_Drc_Areas_Outlines_To_Areas_Outlines( ZONE_CONTAINER* aArea_To_Examine,
                                                       bool            aCreate_Markers )
 {
-    wxString    str;
     int         nerrors = 0;
 
+    // The outlines are converted once, when they are needed.
+    // An empty outline in outlines[] is an outline not yet converted.
+    std::vector<SHAPE_POLY_SET> outlines( GetAreaCount() );
+    std::vector<EDA_RECT>       bboxes( GetAreaCount() );
+
+    for( int ia = 0; ia < GetAreaCount(); ia++ )
+        bboxes[ia] = GetArea( ia )->GetSmoothedPoly()->GetBoundingBox();
+
     // iterate through all areas
     for( int ia = 0; ia < GetAreaCount(); ia++ )
     {
         ZONE_CONTAINER* Area_Ref = GetArea( ia );
-        CPolyLine*      refSmoothedPoly = Area_Ref->GetSmoothedPoly();
 
         if( !Area_Ref->IsOnCopperLayer() )
             continue;
@@ -375,10 +502,10 @@ int BOARD::Test_Drc_Areas_Outlines_To_Areas_Outlines( ZONE_CONTAINER* aArea_To_E
         if( aArea_To_Examine && (aArea_To_Examine != Area_Ref) )
             continue;
 
-        for( int ia2 = 0; ia2 < GetAreaCount(); ia2++ )
+        // When testing all areas, the test is symmetric: test each pair only once
+        for( int ia2 = aArea_To_Examine ? 0 : ia + 1; ia2 < GetAreaCount(); ia2++ )
         {
             ZONE_CONTAINER* area_to_test = GetArea( ia2 );
-            CPolyLine*      testSmoothedPoly = area_to_test->GetSmoothedPoly();
 
             if( Area_Ref == area_to_test )
                 continue;
@@ -411,127 +538,71 @@ int BOARD::Test_Drc_Areas_Outlines_To_Areas_Outlines( ZONE_CONTAINER* aArea_To_E
             if( Area_Ref->GetIsKeepout() )
                 zone2zoneClearance = 1;
 
-            // test for some corners of Area_Ref inside area_to_test
-            for( int ic = 0; ic < refSmoothedPoly->GetCornersCount(); ic++ )
-            {
-                int x = refSmoothedPoly->GetX( ic );
-                int y = refSmoothedPoly->GetY( ic );
+            // Areas too far from each other cannot have errors
+            EDA_RECT refBox = bboxes[ia];
+            refBox.Inflate( zone2zoneClearance );
 
-                if( testSmoothedPoly->TestPointInside( x, y ) )
-                {
-                    // COPPERAREA_COPPERAREA error: copper area ref corner inside copper area
-                    if( aCreate_Markers )
-                    {
-                        wxString msg1   = Area_Ref->GetSelectMenuText();
-                        wxString msg2   = area_to_test->GetSelectMenuText();
-                        MARKER_PCB*  marker = new MARKER_PCB( COPPERAREA_INSIDE_COPPERAREA,
-                                                              wxPoint( x, y ),
-                                                              msg1, wxPoint( x, y ),
-                                                              msg2, wxPoint( x, y ) );
-                        Add( marker );
-                    }
+            if( !refBox.Intersects( bboxes[ia2] ) )
+                continue;
 
-                    nerrors++;
-                }
-            }
+            if( outlines[ia].OutlineCount() == 0 )
+                outlines[ia] = convertPolyLineToPolySet( Area_Ref->GetSmoothedPoly() );
 
-            // test for some corners of area_to_test inside Area_Ref
-            for( int ic2 = 0; ic2 < testSmoothedPoly->GetCornersCount(); ic2++ )
-            {
-                int x = testSmoothedPoly->GetX( ic2 );
-                int y = testSmoothedPoly->GetY( ic2 );
+            if( outlines[ia2].OutlineCount() == 0 )
+                outlines[ia2] = convertPolyLineToPolySet( area_to_test->GetSmoothedPoly() );
 
-                if( refSmoothedPoly->TestPointInside( x, y ) )
-                {
-                    // COPPERAREA_COPPERAREA error: copper area corner inside copper area ref
-                    if( aCreate_Markers )
-                    {
-                        wxString msg1   = area_to_test->GetSelectMenuText();
-                        wxString msg2   = Area_Ref->GetSelectMenuText();
-                        MARKER_PCB*  marker = new MARKER_PCB( COPPERAREA_INSIDE_COPPERAREA,
-                                                              wxPoint( x, y ),
-                                                              msg1, wxPoint( x, y ),
-                                                              msg2, wxPoint( x, y ) );
-                        Add( marker );
-                    }
+            // test for overlapping areas: each polygon of the intersection is an error
+            SHAPE_POLY_SET overlap = outlines[ia];
+            overlap.Intersection( outlines[ia2] );
 
-                    nerrors++;
-                }
+            if( overlap.OutlineCount() )
+            {
+                // COPPERAREA_COPPERAREA error: copper area inside copper area
+                if( aCreate_Markers )
+                    addAreaToAreaMarkers( this, overlap, COPPERAREA_INSIDE_COPPERAREA,
+                                          Area_Ref, area_to_test );
+
+                nerrors += overlap.OutlineCount();
+                continue;
             }
 
-            // now test spacing between areas
-            for( int icont = 0; icont < refSmoothedPoly->GetContoursCount(); icont++ )
+            // now test spacing between areas: area_to_test is too close to Area_Ref
+            // if it intersects Area_Ref inflated by the clearance.
+            // The inflated outline contains all the points closer than the clearance to
+            // Area_Ref, plus a thin band (chords of its arcs) of points slightly farther:
+            // each polygon of the intersection is only a candidate, confirmed by the exact
+            // distance between the outline edges near it.
+            SHAPE_POLY_SET tooClose = outlines[ia];
+            tooClose.Inflate( zone2zoneClearance, ARC_APPROX_SEGMENTS_COUNT_HIGHT_DEF );
+            tooClose.Intersection( outlines[ia2] );
+
+            std::vector<bool> confirmed( tooClose.OutlineCount(), false );
+            int               count = 0;
+
+            for( int ii = 0; ii < tooClose.OutlineCount(); ii++ )
             {
-                int ic_start = refSmoothedPoly->GetContourStart( icont );
-                int ic_end   = refSmoothedPoly->GetContourEnd( icont );
+                const ClipperLib::Path& contour = tooClose.GetPoly( ii )[0];
+                BOX2I candidateBox( VECTOR2I( contour[0].X, contour[0].Y ), VECTOR2I( 0, 0 ) );
 
-                for( int ic = ic_start; ic<=ic_end; ic++ )
+                for( unsigned jj = 1; jj < contour.size(); jj++ )
+                    candidateBox.Merge( VECTOR2I( contour[jj].X, contour[jj].Y ) );
+
+                if( edgesTooClose( outlines[ia], outlines[ia2], candidateBox,
+                                   zone2zoneClearance ) )
                 {
-                    int ax1 = refSmoothedPoly->GetX( ic );
-                    int ay1 = refSmoothedPoly->GetY( ic );
-                    int ax2, ay2;
+                    confirmed[ii] = true;
+                    count++;
+                }
+            }
 
-                    if( ic == ic_end )
-                    {
-                        ax2 = refSmoothedPoly->GetX( ic_start );
-                        ay2 = refSmoothedPoly->GetY( ic_start );
-                    }
-                    else
-                    {
-                        ax2 = refSmoothedPoly->GetX( ic + 1 );
-                        ay2 = refSmoothedPoly->GetY( ic + 1 );
-                    }
+            if( count )
+            {
+                // COPPERAREA_COPPERAREA error : too close
+                if( aCreate_Markers )
+                    addAreaToAreaMarkers( this, tooClose, COPPERAREA_CLOSE_TO_COPPERAREA,
+                                          Area_Ref, area_to_test, &confirmed );
 
-                    for( int icont2 = 0; icont2 < testSmoothedPoly->GetContoursCount(); icont2++ )
-                    {
-                        int ic_start2 = testSmoothedPoly->GetContourStart( icont2 );
-                        int ic_end2   = testSmoothedPoly->GetContourEnd( icont2 );
-
-                        for( int ic2 = ic_start2; ic2<=ic_end2; ic2++ )
-                        {
-                            int bx1 = testSmoothedPoly->GetX( ic2 );
-                            int by1 = testSmoothedPoly->GetY( ic2 );
-                            int bx2, by2;
-
-                            if( ic2 == ic_end2 )
-                            {
-                                bx2 = testSmoothedPoly->GetX( ic_start2 );
-                                by2 = testSmoothedPoly->GetY( ic_start2 );
-                            }
-                            else
-                            {
-                                bx2 = testSmoothedPoly->GetX( ic2 + 1 );
-                                by2 = testSmoothedPoly->GetY( ic2 + 1 );
-                            }
-
-                            int x, y;
-
-                            int d = GetClearanceBetweenSegments( bx1, by1, bx2, by2,
-                                                                 0,
-                                                                 ax1, ay1, ax2, ay2,
-                                                                 0,
-                                                                 zone2zoneClearance,
-                                                                 &x, &y );
-
-                            if( d < zone2zoneClearance )
-                            {
-                                // COPPERAREA_COPPERAREA error : intersect or too close
-                                if( aCreate_Markers )
-                                {
-                                    wxString msg1   = Area_Ref->GetSelectMenuText();
-                                    wxString msg2   = area_to_test->GetSelectMenuText();
-                                    MARKER_PCB*  marker = new MARKER_PCB( COPPERAREA_CLOSE_TO_COPPERAREA,
-                                                                          wxPoint( x, y ),
-                                                                          msg1, wxPoint( x, y ),
-                                                                          msg2, wxPoint( x, y ) );
-                                    Add( marker );
-                                }
-
-                                nerrors++;
-                            }
-                        }
-                    }
-                }
+                nerrors += count;
             }
         }
     }
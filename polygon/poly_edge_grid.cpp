@@ -0,0 +1,213 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file poly_edge_grid.cpp
+ */
+
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+#include <PolyLine.h>
+#include <poly_edge_grid.h>
+
+// Upper limit of the buckets count (the count is the square root of the edges count)
+#define MAX_BUCKETS 1024
+
+
+POLY_EDGE_GRID::POLY_EDGE_GRID()
+{
+    Clear();
+}
+
+
+void POLY_EDGE_GRID::Clear()
+{
+    m_edges.clear();
+    m_edgeRefs.clear();
+    m_groups.clear();
+    m_buckets.clear();
+
+    m_subAreaCount = 0;
+    m_xMin = m_xMax = m_yMin = m_yMax = 0;
+    m_bucketHeight = 1;
+}
+
+
+void POLY_EDGE_GRID::Build( const std::vector<CPolyPt>& aCorners )
+{
+    if( aCorners.empty() )
+        Clear();
+    else
+        Build( &aCorners[0], &aCorners.back() );
+}
+
+
+void POLY_EDGE_GRID::Build( const CPolyPt* aBegin, const CPolyPt* aEnd )
+{
+    Clear();
+
+    if( aEnd < aBegin )
+        return;
+
+    // Sub-area of each edge
+    std::vector<int> subAreas;
+
+    m_xMin = m_xMax = aBegin->x;
+    m_yMin = m_yMax = aBegin->y;
+
+    for( const CPolyPt* first = aBegin; first <= aEnd; )
+    {
+        const CPolyPt* last = first;
+
+        while( last < aEnd && !last->end_contour )
+            ++last;
+
+        // The first edge goes from the first corner to the last one (the closing edge)
+        const CPolyPt* prev = last;
+
+        for( const CPolyPt* corner = first; corner <= last; prev = corner++ )
+        {
+            m_xMin = std::min( m_xMin, corner->x );
+            m_xMax = std::max( m_xMax, corner->x );
+            m_yMin = std::min( m_yMin, corner->y );
+            m_yMax = std::max( m_yMax, corner->y );
+
+            // Horizontal edges are never crossed by the horizontal test line
+            if( corner->y == prev->y )
+                continue;
+
+            EDGE edge = { corner->x, corner->y, prev->x, prev->y };
+            m_edges.push_back( edge );
+            subAreas.push_back( m_subAreaCount );
+        }
+
+        m_subAreaCount++;
+        first = last + 1;
+    }
+
+    int count = std::max( 1, std::min( MAX_BUCKETS, (int) sqrt( (double) m_edges.size() ) ) );
+    m_bucketHeight = ( (long long) m_yMax - m_yMin ) / count + 1;
+    count = bucket( m_yMax ) + 1;
+
+    // Put each edge in all the buckets it crosses. The edges are processed in the corners
+    // order, so in a bucket the edges of a sub-area are contiguous
+    std::vector<unsigned> refStart( count + 1, 0 );
+
+    for( unsigned ii = 0; ii < m_edges.size(); ++ii )
+    {
+        const EDGE& edge = m_edges[ii];
+        int last = bucket( std::max( edge.m_startY, edge.m_endY ) );
+
+        for( int jj = bucket( std::min( edge.m_startY, edge.m_endY ) ); jj <= last; ++jj )
+            refStart[jj + 1]++;
+    }
+
+    for( int jj = 0; jj < count; ++jj )
+        refStart[jj + 1] += refStart[jj];
+
+    std::vector<unsigned> refEnd( refStart.begin(), refStart.end() - 1 );
+    m_edgeRefs.resize( refStart.back() );
+
+    for( unsigned ii = 0; ii < m_edges.size(); ++ii )
+    {
+        const EDGE& edge = m_edges[ii];
+        int last = bucket( std::max( edge.m_startY, edge.m_endY ) );
+
+        for( int jj = bucket( std::min( edge.m_startY, edge.m_endY ) ); jj <= last; ++jj )
+            m_edgeRefs[refEnd[jj]++] = ii;
+    }
+
+    // Split the buckets in groups of edges of the same sub-area
+    m_buckets.resize( count + 1 );
+
+    for( int jj = 0; jj < count; ++jj )
+    {
+        m_buckets[jj] = m_groups.size();
+
+        for( unsigned ii = refStart[jj]; ii < refStart[jj + 1]; )
+        {
+            GROUP group;
+            group.m_subArea = subAreas[m_edgeRefs[ii]];
+            group.m_maxX = INT_MIN;
+            group.m_first = ii;
+
+            for( ; ii < refStart[jj + 1] && subAreas[m_edgeRefs[ii]] == group.m_subArea; ++ii )
+            {
+                const EDGE& edge = m_edges[m_edgeRefs[ii]];
+                group.m_maxX = std::max( group.m_maxX, std::max( edge.m_startX, edge.m_endX ) );
+            }
+
+            group.m_end = ii;
+            m_groups.push_back( group );
+        }
+    }
+
+    m_buckets[count] = m_groups.size();
+}
+
+
+int POLY_EDGE_GRID::FindSubArea( int aX, int aY ) const
+{
+    if( m_groups.empty() || aX < m_xMin || aX > m_xMax || aY < m_yMin || aY > m_yMax )
+        return -1;
+
+    int idx = bucket( aY );
+
+    for( unsigned jj = m_buckets[idx]; jj < m_buckets[idx + 1]; ++jj )
+    {
+        const GROUP& group = m_groups[jj];
+
+        // All the edges are at the left of the point: the semi infinite line crosses none of them
+        if( aX > group.m_maxX )
+            continue;
+
+        int count = 0;
+
+        // Same test as TestPointInsidePolygon()
+        for( unsigned ii = group.m_first; ii < group.m_end; ++ii )
+        {
+            const EDGE& edge = m_edges[m_edgeRefs[ii]];
+
+            if( ( edge.m_startY > aY ) && ( edge.m_endY > aY ) )
+                continue;
+
+            if( ( edge.m_startY <= aY ) && ( edge.m_endY <= aY ) )
+                continue;
+
+            double seg_endX = edge.m_endX - edge.m_startX;
+            double seg_endY = edge.m_endY - edge.m_startY;
+            double newrefx = (double) ( aX - edge.m_startX );
+            double newrefy = (double) ( aY - edge.m_startY );
+
+            if( newrefx < ( newrefy * seg_endX ) / seg_endY )
+                count++;
+        }
+
+        if( count & 1 )
+            return group.m_subArea;
+    }
+
+    return -1;
+}
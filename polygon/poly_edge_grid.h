@@ -0,0 +1,128 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2015 KiCad Developers, see CHANGELOG.TXT for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file poly_edge_grid.h
+ * @brief Point location in a list of polygons, using their edges stored in
+ * horizontal buckets.
+ */
+
+#ifndef POLY_EDGE_GRID_H
+#define POLY_EDGE_GRID_H
+
+#include <vector>
+
+class CPolyPt;
+
+/**
+ * Class POLY_EDGE_GRID
+ * finds the polygon (sub-area) of a list of polygons which contains a point.
+ *
+ * The polygons are given as a range of corners, each polygon ending by a corner
+ * having its end_contour flag set (like the filled areas of a zone).
+ * The edges are stored in buckets covering horizontal slices of the bounding box,
+ * and inside a bucket they are grouped by sub-area.  A query only tests the edges
+ * of the bucket containing the point, so it does not depend on the number of
+ * sub-areas and corners outside this slice.
+ *
+ * The result is the same as the one of TestPointInsidePolygon() used on each
+ * sub-area (points on horizontal edges are outside).
+ * The corners are copied, so the grid must be rebuilt when the polygons change.
+ */
+class POLY_EDGE_GRID
+{
+public:
+    POLY_EDGE_GRID();
+
+    /**
+     * Function Clear
+     * removes all polygons.
+     */
+    void Clear();
+
+    /**
+     * Function Build
+     * stores the polygons defined by a range of corners.
+     * @param aBegin is the first corner of the first polygon.
+     * @param aEnd is the last corner of the last polygon (included in the range).
+     */
+    void Build( const CPolyPt* aBegin, const CPolyPt* aEnd );
+
+    /**
+     * Function Build
+     * stores all the polygons of a corner list.
+     */
+    void Build( const std::vector<CPolyPt>& aCorners );
+
+    int GetSubAreaCount() const
+    {
+        return m_subAreaCount;
+    }
+
+    /**
+     * Function FindSubArea
+     * @return the index (in the list order) of the sub-area containing the point
+     * (aX, aY), or -1 if it is outside all sub-areas.
+     */
+    int FindSubArea( int aX, int aY ) const;
+
+    /**
+     * Function Contains
+     * @return true if the point (aX, aY) is inside one of the sub-areas.
+     */
+    bool Contains( int aX, int aY ) const
+    {
+        return FindSubArea( aX, aY ) >= 0;
+    }
+
+private:
+    struct EDGE
+    {
+        int m_startX, m_startY, m_endX, m_endY;
+    };
+
+    ///> Edges of one sub-area found in a bucket.
+    struct GROUP
+    {
+        int      m_subArea;
+        int      m_maxX;            ///> No crossing for the points at the right of m_maxX
+        unsigned m_first, m_end;    ///> Range of the edges in m_edgeRefs (m_end excluded)
+    };
+
+    ///> Returns the bucket containing the ordinate aY.
+    int bucket( int aY ) const
+    {
+        return ( (long long) aY - m_yMin ) / m_bucketHeight;
+    }
+
+    std::vector<EDGE>       m_edges;
+    std::vector<unsigned>   m_edgeRefs;     ///> Edges of each group
+    std::vector<GROUP>      m_groups;       ///> Groups of each bucket
+    std::vector<unsigned>   m_buckets;      ///> First group of each bucket, and the groups count
+
+    int         m_subAreaCount;
+    int         m_xMin, m_xMax, m_yMin, m_yMax;
+    long long   m_bucketHeight;
+};
+
+#endif  // POLY_EDGE_GRID_H